@@ -5,7 +5,9 @@ layout(location=1) in vec2 i_UVs;
 layout(location=2) in float i_Thickness;
 layout(location=3) in float i_Value;
 
-uniform mat3 u_VP = mat3(vec3(1.0, 0.0, 0.0), vec3(0.0, 1.0, 0.0), vec3(0.0, 0.0, 1.0));
+layout(std140) uniform ViewBlock {
+	mat3 u_VP;
+};
 
 out vec2 t_UVs;
 out float t_InnerRadius;
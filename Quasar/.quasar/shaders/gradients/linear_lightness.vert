@@ -3,7 +3,9 @@
 layout(location=0) in vec2 i_VertexPosition;
 layout(location=1) in float i_LightnessProgress;
 
-uniform mat3 u_VP = mat3(vec3(1.0, 0.0, 0.0), vec3(0.0, 1.0, 0.0), vec3(0.0, 0.0, 1.0));
+layout(std140) uniform ViewBlock {
+	mat3 u_VP;
+};
 
 out float t_LightnessProgress;
 
@@ -1,17 +1,24 @@
 #version 440 core
 
 layout(location = 0) in vec2 i_VertexPosition;
+layout(location = 1) in vec2 i_Expand;
 
-uniform mat3 u_VP = mat3(vec3(1.0, 0.0, 0.0), vec3(0.0, 1.0, 0.0), vec3(0.0, 0.0, 1.0));
+layout(std140) uniform ViewBlock {
+	mat3 u_VP;
+};
 uniform vec4 u_FlatTransform = vec4(0.0, 0.0, 1.0, 1.0);
 uniform vec4 u_Color = vec4(0.2, 0.3, 1.0, 1.0);
+uniform float u_LineWidth = 1.0;
 
 out vec4 t_Color;
 
 void main() {
 	t_Color = u_Color;
 
+	// half line width in image units: u_LineWidth screen pixels when zoomed in, u_LineWidth image pixels when zoomed out
+	vec2 half_width = 0.5 * u_LineWidth / max(u_FlatTransform.zw, vec2(1.0));
+
 	// model matrix
 	mat3 M = mat3(vec3(u_FlatTransform[2], 0.0, 0.0), vec3(0.0, u_FlatTransform[3], 0.0), vec3(u_FlatTransform[0], u_FlatTransform[1], 1.0));
-	gl_Position.xy = (u_VP * M * vec3(i_VertexPosition, 1.0)).xy;
+	gl_Position.xy = (u_VP * M * vec3(i_VertexPosition + i_Expand * half_width, 1.0)).xy;
 }
@@ -0,0 +1,20 @@
+#version 440 core
+
+layout(location=0) out vec4 o_Color;
+
+in vec2 t_GridPosition;
+flat in vec2 t_HalfWidth;
+
+uniform vec4 u_Color = vec4(0.2, 0.3, 1.0, 1.0);
+uniform vec2 u_GridSize = vec2(0.0, 0.0);
+uniform vec2 u_LineSpacing = vec2(1.0, 1.0);
+
+void main() {
+	// Lines lie at every multiple of the spacing inside the image, and on its far edges.
+	vec2 last_line = max(ceil(u_GridSize / u_LineSpacing) - 1.0, 0.0);
+	vec2 nearest_line = clamp(round(t_GridPosition / u_LineSpacing), vec2(0.0), last_line) * u_LineSpacing;
+	vec2 line_distance = min(abs(t_GridPosition - nearest_line), abs(t_GridPosition - u_GridSize));
+	if (line_distance.x > t_HalfWidth.x && line_distance.y > t_HalfWidth.y)
+		discard;
+	o_Color = u_Color;
+}
@@ -0,0 +1,24 @@
+#version 440 core
+
+layout(location = 0) in vec2 i_Corner;
+
+layout(std140) uniform ViewBlock {
+	mat3 u_VP;
+};
+uniform vec4 u_FlatTransform = vec4(0.0, 0.0, 1.0, 1.0);
+uniform float u_LineWidth = 1.0;
+uniform vec2 u_GridSize = vec2(0.0, 0.0);
+
+out vec2 t_GridPosition;
+flat out vec2 t_HalfWidth;
+
+void main() {
+	// half line width in image units: u_LineWidth screen pixels when zoomed in, u_LineWidth image pixels when zoomed out
+	t_HalfWidth = 0.5 * u_LineWidth / max(u_FlatTransform.zw, vec2(1.0));
+	// position relative to the image's corner, covering the outer half of the border lines
+	t_GridPosition = mix(-t_HalfWidth, u_GridSize + t_HalfWidth, i_Corner);
+
+	// model matrix
+	mat3 M = mat3(vec3(u_FlatTransform[2], 0.0, 0.0), vec3(0.0, u_FlatTransform[3], 0.0), vec3(u_FlatTransform[0], u_FlatTransform[1], 1.0));
+	gl_Position.xy = (u_VP * M * vec3(t_GridPosition - 0.5 * u_GridSize, 1.0)).xy;
+}
@@ -8,7 +8,9 @@ layout(location=4) in vec2 i_RectSize;
 layout(location=5) in float i_CornerRadius;
 layout(location=6) in float i_Thickness;
 
-uniform mat3 u_VP = mat3(vec3(1.0, 0.0, 0.0), vec3(0.0, 1.0, 0.0), vec3(0.0, 0.0, 1.0));
+layout(std140) uniform ViewBlock {
+	mat3 u_VP;
+};
 
 out vec2 t_RelVertexPosition;
 out vec4 t_BorderColor;
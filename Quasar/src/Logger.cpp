@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <chrono>
+#include <iomanip>
 
 // LATER translate OpenGL error codes
 // LATER submit_count to batch X amount of statements before flushing.
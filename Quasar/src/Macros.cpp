@@ -1,3 +1,4 @@
+#include <cstring>
 #include <memory>
 
 #define STBI_MALLOC(sz) (new unsigned char[sz])
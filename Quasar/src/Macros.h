@@ -1,11 +1,21 @@
 #pragma once
 
+// QUASAR_HEADLESS builds the editing core without a window or GL, e.g. for the benchmarks. GL types and constants come from HeadlessGL.h,
+// and every QUASAR_GL() call is compiled out.
+#ifdef QUASAR_HEADLESS
+#include "variety/HeadlessGL.h"
+#else
 #define GLEW_STATIC
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#endif
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#if defined(QUASAR_HEADLESS) && !defined(QUASAR_GL)
+#define QUASAR_GL(x) ;
+#endif
+
 #if QUASAR_DEBUG == 1
 #ifndef QUASAR_ASSERT
 #define QUASAR_ASSERT(x) if (!(x)) __debugbreak();
@@ -24,8 +34,23 @@
 
 #include "Logger.h"
 
+#ifndef _MSC_VER
+#include <cerrno>
+#include <cstdio>
+
+// fopen_s is MSVC-only, and SDL checks reject plain fopen there, so other compilers get this fallback instead.
+inline int fopen_s(FILE** file, const char* filename, const char* mode)
+{
+	*file = std::fopen(filename, mode);
+	return *file ? 0 : errno;
+}
+#endif
+
 inline bool no_gl_error(const char* function, const char* file, int line)
 {
+#ifdef QUASAR_HEADLESS
+	return true;
+#else
 	bool no_err = true;
 	while (GLenum error = glGetError())
 	{
@@ -35,4 +60,5 @@ inline bool no_gl_error(const char* function, const char* file, int line)
 	if (!no_err)
 		LOG << LOG.flush;
 	return no_err;
+#endif
 }
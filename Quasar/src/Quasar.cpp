@@ -38,10 +38,11 @@ int main()
 	MainWindow->bind_gui();
 	for (;;)
 	{
-		glfwPollEvents();
+		Machine.wait_events();
 		if (Machine.should_exit())
 			break;
-		Machine.on_render();
+		if (Machine.should_render())
+			Machine.on_render();
 	}
 	Machine.destroy();
 	glfwTerminate();
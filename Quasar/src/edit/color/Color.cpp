@@ -1,5 +1,7 @@
 #include "Color.h"
 
+#include <vector>
+
 // LATER use more accurate contrast formulas. perhaps even put some constants in settings.
 
 constexpr float BLACK = 0.0f;
@@ -68,3 +70,49 @@ float contrast_wb_value_complex_hsl(HSL hsl)
 	else
 		return hsl.l < 0.8f ? WHITE : BLACK;
 }
+
+// Rounded x / 255 for x in [0, 255 * 255], exactly.
+static unsigned int div255(unsigned int x)
+{
+	x += 128;
+	return (x + (x >> 8)) >> 8;
+}
+
+// floor(2^31 / n) for every composite alpha n = 255 * a + bkg.a * (255 - a), which is at most 255 * 255. Un-premultiplying by n
+// then takes a multiply and a shift instead of a division.
+static const unsigned int* unpremultiply_reciprocals()
+{
+	static const std::vector<unsigned int> reciprocals = [] {
+		std::vector<unsigned int> table(255 * 255 + 1, 0);
+		for (unsigned int n = 1; n < table.size(); ++n)
+			table[n] = (unsigned int)((1ull << 31) / n);
+		return table;
+		}();
+	return reciprocals.data();
+}
+
+// Rounded num / n for num <= 255 * n, as floor((2 * num + n) / (2 * n)). The reciprocal underestimates the quotient by at most 1,
+// since the dividend is below 2^25, and the remainder check corrects that without branching.
+static unsigned int unpremultiply(unsigned int num, unsigned int n, unsigned int reciprocal)
+{
+	unsigned int x = 2 * num + n;
+	unsigned int q = (unsigned int)(((unsigned long long)x * reciprocal) >> 32);
+	q += x - q * 2 * n >= 2 * n;
+	return q;
+}
+
+void PixelRGBA::blend_over(PixelRGBA bkg)
+{
+	unsigned int inv_a = 255 - a;
+	unsigned int bkg_weight = bkg.a * inv_a;
+	unsigned int n = 255 * a + bkg_weight; // composite alpha, scaled by 255 * 255
+	if (n != 0)
+	{
+		unsigned int weight = 255 * a;
+		unsigned int reciprocal = unpremultiply_reciprocals()[n];
+		r = (unsigned char)unpremultiply(r * weight + bkg.r * bkg_weight, n, reciprocal);
+		g = (unsigned char)unpremultiply(g * weight + bkg.g * bkg_weight, n, reciprocal);
+		b = (unsigned char)unpremultiply(b * weight + bkg.b * bkg_weight, n, reciprocal);
+	}
+	a = (unsigned char)div255(n);
+}
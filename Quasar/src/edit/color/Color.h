@@ -296,27 +296,18 @@ struct PixelRGBA
 	unsigned char& at(int i) { return i == 0 ? r : i == 1 ? g : i == 2 ? b : a; }
 	bool operator==(const PixelRGBA&) const = default;
 
-	constexpr void blend_over(PixelRGBA bkg);
+	// Source-over compositing in exact integer arithmetic. Every channel is the correctly rounded (half up) value of the same
+	// formula that RGBA::blend_over() evaluates in float. If both alphas are 0, the color channels are left as they are.
+	void blend_over(PixelRGBA bkg);
 };
 
-constexpr void PixelRGBA::blend_over(PixelRGBA bkg)
-{
-	float new_alpha = std::clamp((a + bkg.a * (1.0f - a * inv255)) * inv255, 0.0f, 1.0f);
-	if (new_alpha != 0.0f)
-	{
-		float inv_alpha = inv255 / new_alpha;
-		r = std::clamp(roundi((r * a + bkg.r * bkg.a * (1.0f - a * inv255)) * inv_alpha), 0, 255);
-		g = std::clamp(roundi((g * a + bkg.g * bkg.a * (1.0f - a * inv255)) * inv_alpha), 0, 255);
-		b = std::clamp(roundi((b * a + bkg.b * bkg.a * (1.0f - a * inv255)) * inv_alpha), 0, 255);
-	}
-	a = std::clamp(roundi(new_alpha * 255), 0, 255);
-}
-
 template<>
 struct std::hash<PixelRGBA>
 {
-	size_t operator()(const PixelRGBA& p) const { return std::hash<unsigned char>{}(p.r) ^ std::hash<unsigned char>{}(p.g)
-		^ std::hash<unsigned char>{}(p.b) ^ std::hash<unsigned char>{}(p.a); }
+	size_t operator()(const PixelRGBA& p) const
+	{
+		return mix_hash((static_cast<unsigned long long>(p.r) << 24) | (static_cast<unsigned long long>(p.g) << 16) | (static_cast<unsigned long long>(p.b) << 8) | p.a);
+	}
 };
 
 constexpr PixelRGBA RGBA::get_pixel_rgba() const
@@ -0,0 +1,293 @@
+#include "ColorBuffer.h"
+
+#include <array>
+
+#include "ColorLanes.h"
+
+template<typename L>
+static typename L::V clamp01(typename L::V a)
+{
+	return L::min(L::max(a, L::set(0.0f)), L::set(1.0f));
+}
+
+// Same operations in the same order as RGB::to_hsv()/to_hsl(), so results are bit-identical to the scalar versions.
+template<typename L, bool Lightness>
+static void rgb_to_hue_lanes(const float* r_, const float* g_, const float* b_, float* h_, float* s_, float* x_, size_t& i, size_t n)
+{
+	typedef typename L::V V;
+	const V zero = L::set(0.0f), one = L::set(1.0f), near_zero = L::set(NEAR_ZERO);
+	for (; i + L::N <= n; i += L::N)
+	{
+		V r = clamp01<L>(L::load(r_ + i));
+		V g = clamp01<L>(L::load(g_ + i));
+		V b = clamp01<L>(L::load(b_ + i));
+		V max = L::max(L::max(r, g), b);
+		V min = L::min(L::min(r, g), b);
+		V chroma = L::sub(max, min);
+
+		V hue = L::select(L::eq(max, r), L::div(L::sub(g, b), chroma), L::select(L::eq(max, g),
+			L::add(L::set(2.0f), L::div(L::sub(b, r), chroma)), L::add(L::set(4.0f), L::div(L::sub(r, g), chroma))));
+		hue = L::select(L::lt(hue, zero), L::add(hue, L::set(6.0f)), hue);
+		V has_hue = L::gt(chroma, near_zero);
+		L::store(h_ + i, L::select(has_hue, L::mul(hue, L::set(inv6)), zero));
+
+		if constexpr (Lightness)
+		{
+			V sum = L::add(max, min);
+			L::store(s_ + i, L::select(has_hue, L::div(chroma, L::sub(one, L::abs(L::sub(sum, one)))), zero));
+			L::store(x_ + i, L::mul(sum, L::set(0.5f)));
+		}
+		else
+		{
+			L::store(s_ + i, L::select(L::gt(max, near_zero), L::div(chroma, max), zero));
+			L::store(x_ + i, max);
+		}
+	}
+}
+
+// Sextant of a hue in [0, 1], with h = 1 wrapping back to 0 like the "si % 6" in the scalar versions.
+template<typename L>
+static typename L::V sextant(typename L::V hue6)
+{
+	typename L::V si = L::trunc(hue6);
+	return L::select(L::ge(si, L::set(6.0f)), L::sub(si, L::set(6.0f)), si);
+}
+
+template<typename L>
+static void hsv_to_rgb_lanes(const float* h_, const float* s_, const float* v_, float* r_, float* g_, float* b_, size_t& i, size_t n)
+{
+	typedef typename L::V V;
+	const V one = L::set(1.0f);
+	for (; i + L::N <= n; i += L::N)
+	{
+		V h = clamp01<L>(L::load(h_ + i));
+		V s = clamp01<L>(L::load(s_ + i));
+		V v = clamp01<L>(L::load(v_ + i));
+		V hue6 = L::mul(h, L::set(6.0f));
+		V si = L::trunc(hue6);
+		V fr = L::sub(hue6, si);
+		V min = L::mul(v, L::sub(one, s));
+		V pre = L::mul(v, L::sub(one, L::mul(s, fr)));
+		V post = L::mul(v, L::sub(one, L::mul(s, L::sub(one, fr))));
+
+		V sector = sextant<L>(hue6);
+		V s0 = L::eq(sector, L::set(0.0f)), s1 = L::eq(sector, L::set(1.0f)), s2 = L::eq(sector, L::set(2.0f));
+		V s3 = L::eq(sector, L::set(3.0f)), s4 = L::eq(sector, L::set(4.0f)), s5 = L::eq(sector, L::set(5.0f));
+		V r = L::select(L::bit_or(s0, s5), v, L::select(s1, pre, L::select(s4, post, min)));
+		V g = L::select(L::bit_or(s1, s2), v, L::select(s0, post, L::select(s3, pre, min)));
+		V b = L::select(L::bit_or(s3, s4), v, L::select(s2, post, L::select(s5, pre, min)));
+
+		V grey = L::le(s, L::set(NEAR_ZERO));
+		L::store(r_ + i, clamp01<L>(L::select(grey, v, r)));
+		L::store(g_ + i, clamp01<L>(L::select(grey, v, g)));
+		L::store(b_ + i, clamp01<L>(L::select(grey, v, b)));
+	}
+}
+
+template<typename L>
+static void hsl_to_rgb_lanes(const float* h_, const float* s_, const float* l_, float* r_, float* g_, float* b_, size_t& i, size_t n)
+{
+	typedef typename L::V V;
+	const V one = L::set(1.0f), two = L::set(2.0f), half = L::set(0.5f);
+	for (; i + L::N <= n; i += L::N)
+	{
+		V h = clamp01<L>(L::load(h_ + i));
+		V s = clamp01<L>(L::load(s_ + i));
+		V l = clamp01<L>(L::load(l_ + i));
+		V chroma = L::mul(L::sub(one, L::abs(L::sub(L::mul(two, l), one))), s);
+		V hue6 = L::mul(h, L::set(6.0f));
+		V mod2 = L::sub(hue6, L::mul(two, L::trunc(L::div(hue6, two))));
+		V x = L::mul(chroma, L::sub(one, L::abs(L::sub(mod2, one))));
+		V c1 = L::add(l, L::mul(chroma, half));
+		V c2 = L::add(L::sub(l, L::mul(chroma, half)), x);
+		V c3 = L::sub(l, L::mul(chroma, half));
+
+		V sector = sextant<L>(hue6);
+		V s0 = L::eq(sector, L::set(0.0f)), s1 = L::eq(sector, L::set(1.0f)), s2 = L::eq(sector, L::set(2.0f));
+		V s3 = L::eq(sector, L::set(3.0f)), s4 = L::eq(sector, L::set(4.0f)), s5 = L::eq(sector, L::set(5.0f));
+		V r = L::select(L::bit_or(s0, s5), c1, L::select(L::bit_or(s1, s4), c2, c3));
+		V g = L::select(L::bit_or(s1, s2), c1, L::select(L::bit_or(s0, s3), c2, c3));
+		V b = L::select(L::bit_or(s3, s4), c1, L::select(L::bit_or(s2, s5), c2, c3));
+
+		L::store(r_ + i, clamp01<L>(r));
+		L::store(g_ + i, clamp01<L>(g));
+		L::store(b_ + i, clamp01<L>(b));
+	}
+}
+
+void rgb_to_hsv(const float* r, const float* g, const float* b, float* h, float* s, float* v, size_t n)
+{
+	size_t i = 0;
+#ifdef QUASAR_COLOR_AVX2
+	rgb_to_hue_lanes<AVXLanes, false>(r, g, b, h, s, v, i, n);
+#endif
+#ifdef QUASAR_COLOR_SSE2
+	rgb_to_hue_lanes<SSELanes, false>(r, g, b, h, s, v, i, n);
+#endif
+	for (; i < n; ++i)
+	{
+		HSV hsv = RGB(r[i], g[i], b[i]).to_hsv();
+		h[i] = hsv.h;
+		s[i] = hsv.s;
+		v[i] = hsv.v;
+	}
+}
+
+void rgb_to_hsl(const float* r, const float* g, const float* b, float* h, float* s, float* l, size_t n)
+{
+	size_t i = 0;
+#ifdef QUASAR_COLOR_AVX2
+	rgb_to_hue_lanes<AVXLanes, true>(r, g, b, h, s, l, i, n);
+#endif
+#ifdef QUASAR_COLOR_SSE2
+	rgb_to_hue_lanes<SSELanes, true>(r, g, b, h, s, l, i, n);
+#endif
+	for (; i < n; ++i)
+	{
+		HSL hsl = RGB(r[i], g[i], b[i]).to_hsl();
+		h[i] = hsl.h;
+		s[i] = hsl.s;
+		l[i] = hsl.l;
+	}
+}
+
+void hsv_to_rgb(const float* h, const float* s, const float* v, float* r, float* g, float* b, size_t n)
+{
+	size_t i = 0;
+#ifdef QUASAR_COLOR_AVX2
+	hsv_to_rgb_lanes<AVXLanes>(h, s, v, r, g, b, i, n);
+#endif
+#ifdef QUASAR_COLOR_SSE2
+	hsv_to_rgb_lanes<SSELanes>(h, s, v, r, g, b, i, n);
+#endif
+	for (; i < n; ++i)
+	{
+		RGB rgb = HSV(h[i], s[i], v[i]).to_rgb();
+		r[i] = rgb.r;
+		g[i] = rgb.g;
+		b[i] = rgb.b;
+	}
+}
+
+void hsl_to_rgb(const float* h, const float* s, const float* l, float* r, float* g, float* b, size_t n)
+{
+	size_t i = 0;
+#ifdef QUASAR_COLOR_AVX2
+	hsl_to_rgb_lanes<AVXLanes>(h, s, l, r, g, b, i, n);
+#endif
+#ifdef QUASAR_COLOR_SSE2
+	hsl_to_rgb_lanes<SSELanes>(h, s, l, r, g, b, i, n);
+#endif
+	for (; i < n; ++i)
+	{
+		RGB rgb = HSL(h[i], s[i], l[i]).to_rgb();
+		r[i] = rgb.r;
+		g[i] = rgb.g;
+		b[i] = rgb.b;
+	}
+}
+
+// Pixels are converted in chunks so the deinterleaved planes are still in cache when the conversion kernel reads them.
+static constexpr size_t CONVERSION_CHUNK = 1024;
+
+void convert_buffer(const Buffer& buf, ColorSpace space, float* out)
+{
+	const size_t area = buf.area();
+	float* p0 = out;
+	float* p1 = out + area;
+	float* p2 = out + 2 * area;
+	const Byte* px = buf.pixels;
+	for (size_t start = 0; start < area; start += CONVERSION_CHUNK)
+	{
+		size_t n = std::min(CONVERSION_CHUNK, area - start);
+		for (size_t i = start; i < start + n; ++i)
+		{
+			p0[i] = px[0] * inv255;
+			p1[i] = buf.chpp > 1 ? px[1] * inv255 : 1.0f;
+			p2[i] = buf.chpp > 2 ? px[2] * inv255 : 1.0f;
+			px += buf.chpp;
+		}
+		if (space == ColorSpace::HSV)
+			rgb_to_hsv(p0 + start, p1 + start, p2 + start, p0 + start, p1 + start, p2 + start, n);
+		else if (space == ColorSpace::HSL)
+			rgb_to_hsl(p0 + start, p1 + start, p2 + start, p0 + start, p1 + start, p2 + start, n);
+	}
+}
+
+void convert_buffer(const float* in, ColorSpace space, const Buffer& buf)
+{
+	const size_t area = buf.area();
+	const float* p0 = in;
+	const float* p1 = in + area;
+	const float* p2 = in + 2 * area;
+	const CHPP color_channels = std::min(buf.chpp, 3);
+	float rgb[3][CONVERSION_CHUNK];
+	Byte* px = buf.pixels;
+	for (size_t start = 0; start < area; start += CONVERSION_CHUNK)
+	{
+		size_t n = std::min(CONVERSION_CHUNK, area - start);
+		const float* planes[3] = { rgb[0], rgb[1], rgb[2] };
+		if (space == ColorSpace::HSV)
+			hsv_to_rgb(p0 + start, p1 + start, p2 + start, rgb[0], rgb[1], rgb[2], n);
+		else if (space == ColorSpace::HSL)
+			hsl_to_rgb(p0 + start, p1 + start, p2 + start, rgb[0], rgb[1], rgb[2], n);
+		else
+		{
+			planes[0] = p0 + start;
+			planes[1] = p1 + start;
+			planes[2] = p2 + start;
+		}
+		for (size_t i = 0; i < n; ++i)
+		{
+			for (CHPP c = 0; c < color_channels; ++c)
+				px[c] = std::clamp(roundi(planes[c][i] * 255), 0, 255);
+			px += buf.chpp;
+		}
+	}
+}
+
+static const std::array<float, 256>& srgb_to_linear()
+{
+	static const std::array<float, 256> table = []() {
+		std::array<float, 256> t;
+		for (int i = 0; i < 256; ++i)
+		{
+			float c = i * inv255;
+			t[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+		}
+		return t;
+		}();
+	return table;
+}
+
+static Byte linear_to_srgb(float c)
+{
+	c = std::clamp(c, 0.0f, 1.0f);
+	c = c <= 0.0031308f ? 12.92f * c : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+	return (Byte)roundi(c * 255);
+}
+
+Oklab to_oklab(PixelRGBA color)
+{
+	const std::array<float, 256>& linear = srgb_to_linear();
+	float r = linear[color.r], g = linear[color.g], b = linear[color.b];
+	float l = std::cbrt(0.4122214708f * r + 0.5363325363f * g + 0.0514459929f * b);
+	float m = std::cbrt(0.2119034982f * r + 0.6806995451f * g + 0.1073969566f * b);
+	float s = std::cbrt(0.0883024619f * r + 0.2817188376f * g + 0.6299787005f * b);
+	return { 0.2104542553f * l + 0.7936177850f * m - 0.0040720468f * s,
+		1.9779984951f * l - 2.4285922050f * m + 0.4505937099f * s,
+		0.0259040371f * l + 0.7827717662f * m - 0.8086757660f * s };
+}
+
+PixelRGBA from_oklab(Oklab lab)
+{
+	float l = lab.L + 0.3963377774f * lab.a + 0.2158037573f * lab.b;
+	float m = lab.L - 0.1055613458f * lab.a - 0.0638541728f * lab.b;
+	float s = lab.L - 0.0894841775f * lab.a - 1.2914855480f * lab.b;
+	l = l * l * l;
+	m = m * m * m;
+	s = s * s * s;
+	return { linear_to_srgb(4.0767416621f * l - 3.3077115913f * m + 0.2309699292f * s),
+		linear_to_srgb(-1.2684380046f * l + 2.6097574011f * m - 0.3413193965f * s),
+		linear_to_srgb(-0.0041960863f * l - 0.7034186147f * m + 1.7076147010f * s), 255 };
+}
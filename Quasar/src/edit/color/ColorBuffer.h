@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Color.h"
+#include "edit/image/PixelBuffer.h"
+
+enum class ColorSpace : char
+{
+	RGB,
+	HSV,
+	HSL
+};
+
+// Structure-of-arrays colour conversions. Each channel is its own plane of n floats in [0, 1], matching the scalar RGB/HSV/HSL members.
+// Inputs are clamped like the scalar constructors, and outputs agree with RGB::to_hsv() etc. to within float rounding.
+// Output planes may alias input planes.
+extern void rgb_to_hsv(const float* r, const float* g, const float* b, float* h, float* s, float* v, size_t n);
+extern void rgb_to_hsl(const float* r, const float* g, const float* b, float* h, float* s, float* l, size_t n);
+extern void hsv_to_rgb(const float* h, const float* s, const float* v, float* r, float* g, float* b, size_t n);
+extern void hsl_to_rgb(const float* h, const float* s, const float* l, float* r, float* g, float* b, size_t n);
+
+// Converts the colour channels of buf into three planes of buf.area() floats: out, out + area, out + 2 * area. Alpha is ignored.
+// Like Canvas::pixel_color_at(), channels missing from buffers with chpp < 3 read as 255.
+extern void convert_buffer(const Buffer& buf, ColorSpace space, float* out);
+// Inverse of the above: converts three planes in space back to RGB and writes the channels that buf has, leaving alpha untouched.
+extern void convert_buffer(const float* in, ColorSpace space, const Buffer& buf);
+
+// Perceptual colour space that palette matching measures distances in: Euclidean distance in Oklab tracks perceived difference far better than in sRGB.
+struct Oklab
+{
+	float L = 0.0f;
+	float a = 0.0f;
+	float b = 0.0f;
+};
+
+extern Oklab to_oklab(PixelRGBA color);
+// Alpha is always 255.
+extern PixelRGBA from_oklab(Oklab lab);
@@ -0,0 +1,270 @@
+#include "ColorHistogram.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <thread>
+
+static_assert(sizeof(PixelRGBA) == sizeof(unsigned int));
+
+static unsigned int color_key(PixelRGBA color)
+{
+	unsigned int key;
+	memcpy(&key, &color, sizeof(key));
+	return key;
+}
+
+static PixelRGBA key_color(unsigned int key)
+{
+	PixelRGBA color;
+	memcpy(&color, &key, sizeof(key));
+	return color;
+}
+
+// Open-addressing counter keyed by packed RGBA. A count of 0 marks an empty slot, so every 32-bit key is usable.
+struct ColorCountTable
+{
+	std::vector<unsigned int> keys;
+	std::vector<unsigned int> counts;
+	size_t size = 0;
+
+	ColorCountTable(size_t capacity = 1 << 12) : keys(capacity), counts(capacity) {}
+
+	void add(unsigned int key, size_t hash, unsigned int count)
+	{
+		size_t i = slot(key, hash);
+		if (!counts[i] && 2 * ++size > keys.size())
+		{
+			grow();
+			i = slot(key, hash);
+		}
+		keys[i] = key;
+		counts[i] += count;
+	}
+
+	template<typename Func>
+	void for_each(Func f) const
+	{
+		for (size_t i = 0; i < keys.size(); ++i)
+		{
+			if (counts[i])
+				f(keys[i], counts[i]);
+		}
+	}
+
+private:
+	size_t slot(unsigned int key, size_t hash) const
+	{
+		size_t mask = keys.size() - 1;
+		size_t i = hash & mask;
+		while (counts[i] && keys[i] != key)
+			i = (i + 1) & mask;
+		return i;
+	}
+
+	void grow()
+	{
+		std::vector<unsigned int> old_keys(2 * keys.size());
+		std::vector<unsigned int> old_counts(2 * counts.size());
+		old_keys.swap(keys);
+		old_counts.swap(counts);
+		for (size_t i = 0; i < old_keys.size(); ++i)
+		{
+			if (old_counts[i])
+			{
+				size_t j = slot(old_keys[i], mix_hash(old_keys[i]));
+				keys[j] = old_keys[i];
+				counts[j] = old_counts[i];
+			}
+		}
+	}
+};
+
+// Counting in a hash table is fastest while the table stays in cache. Past this many colors a thread gives up on it and collects
+// runs to be radix sorted instead, which costs the same however many colors there are.
+static const size_t MAX_HASHED_COLORS = 1 << 18;
+
+// Colors are split into partitions by hash, one per thread. Each thread counts a disjoint range of pixels into its own tables,
+// one per partition, and then each thread merges one partition across all threads, so no color is counted by two threads at the end.
+static size_t partition_of(size_t hash, size_t num_partitions)
+{
+	return (hash >> 48) % num_partitions;
+}
+
+// Entries of spilled runs, with the color in the high bits so that sorting by the high bits groups equal colors.
+static unsigned long long pack_entry(unsigned int key, unsigned int count)
+{
+	return ((unsigned long long)key << 32) | count;
+}
+
+// One thread's counts over its range of pixels, split by partition.
+struct PartitionedCounts
+{
+	std::vector<ColorCountTable> tables;
+	std::vector<std::vector<unsigned long long>> spilled;
+	size_t hashed_colors = 0;
+	bool hashing = true;
+
+	PartitionedCounts(size_t num_partitions) : tables(num_partitions, ColorCountTable(1 << 8)), spilled(num_partitions) {}
+
+	void add(unsigned int key, unsigned int run_length)
+	{
+		size_t hash = mix_hash(key);
+		size_t p = partition_of(hash, tables.size());
+		if (!hashing)
+		{
+			spilled[p].push_back(pack_entry(key, run_length));
+			return;
+		}
+		size_t size = tables[p].size;
+		tables[p].add(key, hash, run_length);
+		hashed_colors += tables[p].size - size;
+		if (hashed_colors > MAX_HASHED_COLORS)
+			spill();
+	}
+
+private:
+	void spill()
+	{
+		for (size_t p = 0; p < tables.size(); ++p)
+		{
+			spilled[p].reserve(tables[p].size);
+			tables[p].for_each([this, p](unsigned int key, unsigned int count) { spilled[p].push_back(pack_entry(key, count)); });
+			tables[p] = ColorCountTable(0);
+		}
+		hashing = false;
+	}
+};
+
+// Calls f(key, run_length) for every run of equal pixels in [first, last), so that runs are hashed once.
+template<typename Func>
+static void for_each_run(const Buffer& buf, size_t first, size_t last, Func f)
+{
+	const Byte* px = buf.pixels + first * buf.chpp;
+	const Byte* end = buf.pixels + last * buf.chpp;
+	unsigned int run_key = 0;
+	unsigned int run_length = 0;
+	for (; px < end; px += buf.chpp)
+	{
+		unsigned int key;
+		if (buf.chpp == 4)
+			memcpy(&key, px, sizeof(key));
+		else
+		{
+			PixelRGBA color{ 255, 255, 255, 255 };
+			for (CHPP c = 0; c < buf.chpp; ++c)
+				color.at(c) = px[c];
+			key = color_key(color);
+		}
+		if (key == run_key && run_length)
+			++run_length;
+		else
+		{
+			if (run_length)
+				f(run_key, run_length);
+			run_key = key;
+			run_length = 1;
+		}
+	}
+	if (run_length)
+		f(run_key, run_length);
+}
+
+// Sorts by the color in the high 32 bits only.
+static void radix_sort(std::vector<unsigned long long>& entries)
+{
+	static const int DIGIT_BITS = 11;
+	static const unsigned long long DIGIT_MASK = (1 << DIGIT_BITS) - 1;
+	std::vector<unsigned long long> sorted(entries.size());
+	for (int shift = 32; shift < 64; shift += DIGIT_BITS)
+	{
+		std::array<size_t, DIGIT_MASK + 1> offsets = {};
+		for (unsigned long long entry : entries)
+			++offsets[(entry >> shift) & DIGIT_MASK];
+		size_t offset = 0;
+		for (size_t& o : offsets)
+		{
+			size_t count = o;
+			o = offset;
+			offset += count;
+		}
+		for (unsigned long long entry : entries)
+			sorted[offsets[(entry >> shift) & DIGIT_MASK]++] = entry;
+		entries.swap(sorted);
+	}
+}
+
+static void merge_partition(const std::vector<PartitionedCounts>& threads, size_t p, std::vector<ColorCount>& counts)
+{
+	bool spilled = std::any_of(threads.begin(), threads.end(), [](const PartitionedCounts& t) { return !t.hashing; });
+	if (!spilled)
+	{
+		ColorCountTable table;
+		for (const PartitionedCounts& t : threads)
+			t.tables[p].for_each([&table](unsigned int key, unsigned int count) { table.add(key, mix_hash(key), count); });
+		counts.reserve(table.size);
+		table.for_each([&counts](unsigned int key, unsigned int count) { counts.push_back({ key_color(key), count }); });
+		return;
+	}
+
+	std::vector<unsigned long long> entries;
+	for (const PartitionedCounts& t : threads)
+	{
+		entries.insert(entries.end(), t.spilled[p].begin(), t.spilled[p].end());
+		t.tables[p].for_each([&entries](unsigned int key, unsigned int count) { entries.push_back(pack_entry(key, count)); });
+	}
+	radix_sort(entries);
+	for (size_t i = 0; i < entries.size();)
+	{
+		unsigned int key = (unsigned int)(entries[i] >> 32);
+		unsigned int count = 0;
+		for (; i < entries.size() && (unsigned int)(entries[i] >> 32) == key; ++i)
+			count += (unsigned int)entries[i];
+		counts.push_back({ key_color(key), count });
+	}
+}
+
+// Runs f(t) for t in [0, num_threads), on the calling thread for t = 0.
+template<typename Func>
+static void run_parallel(unsigned int num_threads, Func f)
+{
+	std::vector<std::thread> threads;
+	threads.reserve(num_threads - 1);
+	for (unsigned int t = 1; t < num_threads; ++t)
+		threads.emplace_back(f, t);
+	f(0);
+	for (std::thread& thread : threads)
+		thread.join();
+}
+
+std::vector<ColorCount> color_histogram(const Buffer& buf)
+{
+	static const size_t MIN_PIXELS_PER_THREAD = 1 << 16;
+	unsigned int num_threads = (unsigned int)std::clamp<size_t>(buf.area() / MIN_PIXELS_PER_THREAD, 1, std::max(std::thread::hardware_concurrency(), 1u));
+	std::vector<PartitionedCounts> threads(num_threads, PartitionedCounts(num_threads));
+	size_t area = buf.area();
+	run_parallel(num_threads, [&](unsigned int t) {
+		PartitionedCounts& counts = threads[t];
+		for_each_run(buf, area * t / num_threads, area * (t + 1) / num_threads, [&counts](unsigned int key, unsigned int run_length) { counts.add(key, run_length); });
+		});
+
+	std::vector<std::vector<ColorCount>> partitions(num_threads);
+	run_parallel(num_threads, [&](unsigned int p) { merge_partition(threads, p, partitions[p]); });
+	for (unsigned int p = 1; p < num_threads; ++p)
+		partitions[0].insert(partitions[0].end(), partitions[p].begin(), partitions[p].end());
+	return std::move(partitions[0]);
+}
+
+void keep_most_frequent_colors(std::vector<ColorCount>& histogram, size_t max_colors)
+{
+	auto more_frequent = [](const ColorCount& a, const ColorCount& b) {
+		return a.count != b.count ? a.count > b.count : color_key(a.color) < color_key(b.color);
+		};
+	if (max_colors < histogram.size())
+	{
+		std::partial_sort(histogram.begin(), histogram.begin() + max_colors, histogram.end(), more_frequent);
+		histogram.resize(max_colors);
+	}
+	else
+		std::sort(histogram.begin(), histogram.end(), more_frequent);
+}
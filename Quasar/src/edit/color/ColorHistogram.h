@@ -0,0 +1,18 @@
+#pragma once
+
+#include <vector>
+
+#include "Color.h"
+#include "edit/image/PixelBuffer.h"
+
+struct ColorCount
+{
+	PixelRGBA color;
+	unsigned int count;
+};
+
+// Every unique pixel color in buf with the number of pixels that have it, in no particular order.
+// Like Canvas::pixel_color_at(), channels missing from buffers with chpp < 4 read as 255.
+extern std::vector<ColorCount> color_histogram(const Buffer& buf);
+// Keeps the max_colors most frequent entries of histogram, most frequent first. Equal counts are ordered by color, so results are deterministic.
+extern void keep_most_frequent_colors(std::vector<ColorCount>& histogram, size_t max_colors);
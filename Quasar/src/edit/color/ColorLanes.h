@@ -0,0 +1,66 @@
+#pragma once
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define QUASAR_COLOR_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define QUASAR_COLOR_SSE2
+#endif
+
+// Lane traits: colour kernels are written once against these and instantiated per instruction set.
+// Comparisons return all-ones/all-zeros masks, and select(m, a, b) picks a where m is set.
+#ifdef QUASAR_COLOR_SSE2
+struct SSELanes
+{
+	typedef __m128 V;
+	static constexpr size_t N = 4;
+
+	static V load(const float* p) { return _mm_loadu_ps(p); }
+	static void store(float* p, V v) { _mm_storeu_ps(p, v); }
+	static V set(float f) { return _mm_set1_ps(f); }
+	static V add(V a, V b) { return _mm_add_ps(a, b); }
+	static V sub(V a, V b) { return _mm_sub_ps(a, b); }
+	static V mul(V a, V b) { return _mm_mul_ps(a, b); }
+	static V div(V a, V b) { return _mm_div_ps(a, b); }
+	static V min(V a, V b) { return _mm_min_ps(a, b); }
+	static V max(V a, V b) { return _mm_max_ps(a, b); }
+	static V abs(V a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+	static V trunc(V a) { return _mm_cvtepi32_ps(_mm_cvttps_epi32(a)); }
+	static V eq(V a, V b) { return _mm_cmpeq_ps(a, b); }
+	static V lt(V a, V b) { return _mm_cmplt_ps(a, b); }
+	static V le(V a, V b) { return _mm_cmple_ps(a, b); }
+	static V gt(V a, V b) { return _mm_cmpgt_ps(a, b); }
+	static V ge(V a, V b) { return _mm_cmpge_ps(a, b); }
+	static V bit_or(V a, V b) { return _mm_or_ps(a, b); }
+	static V select(V m, V a, V b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+};
+#endif
+
+#ifdef QUASAR_COLOR_AVX2
+struct AVXLanes
+{
+	typedef __m256 V;
+	static constexpr size_t N = 8;
+
+	static V load(const float* p) { return _mm256_loadu_ps(p); }
+	static void store(float* p, V v) { _mm256_storeu_ps(p, v); }
+	static V set(float f) { return _mm256_set1_ps(f); }
+	static V add(V a, V b) { return _mm256_add_ps(a, b); }
+	static V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+	static V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+	static V div(V a, V b) { return _mm256_div_ps(a, b); }
+	static V min(V a, V b) { return _mm256_min_ps(a, b); }
+	static V max(V a, V b) { return _mm256_max_ps(a, b); }
+	static V abs(V a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+	static V trunc(V a) { return _mm256_round_ps(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+	static V eq(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+	static V lt(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	static V le(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+	static V gt(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+	static V ge(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+	static V bit_or(V a, V b) { return _mm256_or_ps(a, b); }
+	static V select(V m, V a, V b) { return _mm256_blendv_ps(b, a, m); }
+};
+#endif
@@ -1,145 +1,188 @@
 #include "ColorScheme.h"
 
+#include "ColorBuffer.h"
+
 void ColorSubscheme::remove(size_t i)
 {
 	if (i < colors.size())
+	{
+		if (key_cache_in_sync())
+		{
+			key_cache.keys.erase(key_cache.keys.begin() + i);
+			key_cache.colors.erase(key_cache.colors.begin() + i);
+		}
 		colors.erase(colors.begin() + i);
+	}
 }
 
 void ColorSubscheme::insert(RGBA color, size_t pos)
 {
+	if (key_cache_in_sync())
+	{
+		key_cache.keys.insert(key_cache.keys.begin() + pos, sort_key(color));
+		key_cache.colors.insert(key_cache.colors.begin() + pos, color);
+	}
 	colors.insert(colors.begin() + pos, color);
 }
 
-static constexpr bool less(float a, float b) { return a < b; }
-static constexpr bool greater(float a, float b) { return a > b; }
+enum class SortKeyChannel : char
+{
+	R,
+	G,
+	B,
+	A,
+	H,
+	S_HSV,
+	V,
+	S_HSL,
+	L,
+	_COUNT
+};
 
-void ColorSubscheme::sort(Sort sort)
+struct SortKeyLayout
 {
-	if (sort == _sort)
-		return;
-	_sort = sort;
-	if (sort.policy == SortingPolicy::NONE)
-		return;
-	compare = sort.topfirst ? &greater : &less;
-	std::sort(colors.begin(), colors.end(), [this](RGBA a, RGBA b) { return predicate(a, b); });
+	SortKeyChannel channels[4];
+	// Whether the channel compares the other way round to the primary direction, e.g. brighter colors first when sorting by hue.
+	bool reversed[4];
+};
+
+static constexpr SortKeyLayout SORT_KEY_LAYOUTS[] = {
+	{ { SortKeyChannel::R, SortKeyChannel::G, SortKeyChannel::B, SortKeyChannel::A }, { false, false, false, false } }, // NONE
+	{ { SortKeyChannel::H, SortKeyChannel::S_HSV, SortKeyChannel::V, SortKeyChannel::A }, { false, true, true, true } }, // HUE
+	{ { SortKeyChannel::S_HSV, SortKeyChannel::H, SortKeyChannel::V, SortKeyChannel::A }, { false, false, true, true } }, // SAT_HSV
+	{ { SortKeyChannel::S_HSL, SortKeyChannel::H, SortKeyChannel::L, SortKeyChannel::A }, { false, false, true, true } }, // SAT_HSL
+	{ { SortKeyChannel::V, SortKeyChannel::H, SortKeyChannel::S_HSV, SortKeyChannel::A }, { true, false, false, true } }, // VALUE
+	{ { SortKeyChannel::L, SortKeyChannel::H, SortKeyChannel::S_HSL, SortKeyChannel::A }, { true, false, false, true } }, // LIGHT
+	{ { SortKeyChannel::R, SortKeyChannel::G, SortKeyChannel::B, SortKeyChannel::A }, { true, false, false, true } }, // RED
+	{ { SortKeyChannel::G, SortKeyChannel::B, SortKeyChannel::R, SortKeyChannel::A }, { true, false, false, true } }, // GREEN
+	{ { SortKeyChannel::B, SortKeyChannel::R, SortKeyChannel::G, SortKeyChannel::A }, { true, false, false, true } }, // BLUE
+	{ { SortKeyChannel::A, SortKeyChannel::H, SortKeyChannel::S_HSV, SortKeyChannel::V }, { true, false, true, true } }, // ALPHA
+};
+
+// The scaling is monotonic, so key order never contradicts float comparison, but floats that differ by less than about 2^-30 can map to
+// the same component. Such ties fall through to the secondary components, and colors that tie on all four keep their order, as the sort is stable.
+// The headroom above 1 is for HSL saturation, which can round slightly past 1 for near-white/near-black colors.
+static unsigned int sort_key_component(float value, bool descending)
+{
+	unsigned int fixed = static_cast<unsigned int>(std::clamp(value, 0.0f, 2.0f) * 2147483647.5);
+	return descending ? ~fixed : fixed;
 }
 
-size_t ColorSubscheme::first_index_of(RGBA color)
+static ColorSubscheme::SortKey pack_sort_key(const float* channel_values, ColorSubscheme::Sort sort)
 {
-	auto iter = std::lower_bound(colors.begin(), colors.end(), color, [this](RGBA a, RGBA b) { return predicate(a, b); });
-	if (iter == colors.end() || *iter != color)
-		return -1;
-	else
-		return iter - colors.begin();
+	const SortKeyLayout& layout = SORT_KEY_LAYOUTS[(int)sort.policy];
+	unsigned long long c[4];
+	for (int k = 0; k < 4; ++k)
+		c[k] = sort_key_component(channel_values[(int)layout.channels[k]], sort.topfirst != layout.reversed[k]);
+	return { (c[0] << 32) | c[1], (c[2] << 32) | c[3] };
 }
 
-bool ColorSubscheme::predicate(RGBA a, RGBA b)
+// Converts all colors at once through the planar HSV/HSL kernels, which match RGB::to_hsv()/to_hsl() exactly.
+static void compute_sort_keys(ColorSubscheme::Sort sort, const std::vector<RGBA>& colors, std::vector<ColorSubscheme::SortKey>& keys)
 {
-	switch (_sort.policy)
-	{
-	case SortingPolicy::HUE:
-	{
-		HSV ac = a.rgb.to_hsv(), bc = b.rgb.to_hsv();
-		if (ac.h != bc.h)
-			return compare(ac.h, bc.h);
-		if (ac.s != bc.s)
-			return compare(bc.s, ac.s);
-		if (ac.v != bc.v)
-			return compare(bc.v, ac.v);
-		return compare(b.alpha, a.alpha);
-	}
-	case SortingPolicy::SAT_HSV:
-	{
-		HSV ac = a.rgb.to_hsv(), bc = b.rgb.to_hsv();
-		if (ac.s != bc.s)
-			return compare(ac.s, bc.s);
-		if (ac.h != bc.h)
-			return compare(ac.h, bc.h);
-		if (ac.v != bc.v)
-			return compare(bc.v, ac.v);
-		return compare(b.alpha, a.alpha);
-	}
-	case SortingPolicy::SAT_HSL:
+	const size_t n = colors.size();
+	std::vector<float> planes(((size_t)SortKeyChannel::_COUNT + 1) * n);
+	auto plane = [&](SortKeyChannel channel) { return planes.data() + (size_t)channel * n; };
+	float* hsl_hue = planes.data() + (size_t)SortKeyChannel::_COUNT * n;
+	for (size_t i = 0; i < n; ++i)
 	{
-		HSL ac = a.rgb.to_hsl(), bc = b.rgb.to_hsl();
-		if (ac.s != bc.s)
-			return compare(ac.s, bc.s);
-		if (ac.h != bc.h)
-			return compare(ac.h, bc.h);
-		if (ac.l != bc.l)
-			return compare(bc.l, ac.l);
-		return compare(b.alpha, a.alpha);
+		plane(SortKeyChannel::R)[i] = colors[i].rgb.r;
+		plane(SortKeyChannel::G)[i] = colors[i].rgb.g;
+		plane(SortKeyChannel::B)[i] = colors[i].rgb.b;
+		plane(SortKeyChannel::A)[i] = colors[i].alpha;
 	}
-	case SortingPolicy::VALUE:
-	{
-		HSV ac = a.rgb.to_hsv(), bc = b.rgb.to_hsv();
-		if (ac.v != bc.v)
-			return compare(bc.v, ac.v);
-		if (ac.h != bc.h)
-			return compare(ac.h, bc.h);
-		if (ac.s != bc.s)
-			return compare(ac.s, bc.s);
-		return compare(b.alpha, a.alpha);
-	}
-	case SortingPolicy::LIGHT:
+	rgb_to_hsv(plane(SortKeyChannel::R), plane(SortKeyChannel::G), plane(SortKeyChannel::B), plane(SortKeyChannel::H), plane(SortKeyChannel::S_HSV), plane(SortKeyChannel::V), n);
+	rgb_to_hsl(plane(SortKeyChannel::R), plane(SortKeyChannel::G), plane(SortKeyChannel::B), hsl_hue, plane(SortKeyChannel::S_HSL), plane(SortKeyChannel::L), n);
+
+	keys.resize(n);
+	float channel_values[(size_t)SortKeyChannel::_COUNT];
+	for (size_t i = 0; i < n; ++i)
 	{
-		HSL ac = a.rgb.to_hsl(), bc = b.rgb.to_hsl();
-		if (ac.l != bc.l)
-			return compare(bc.l, ac.l);
-		if (ac.h != bc.h)
-			return compare(ac.h, bc.h);
-		if (ac.s != bc.s)
-			return compare(ac.s, bc.s);
-		return compare(b.alpha, a.alpha);
+		for (size_t c = 0; c < (size_t)SortKeyChannel::_COUNT; ++c)
+			channel_values[c] = planes[c * n + i];
+		keys[i] = pack_sort_key(channel_values, sort);
 	}
-	case SortingPolicy::RED:
+}
+
+ColorSubscheme::SortKey ColorSubscheme::sort_key(RGBA color) const
+{
+	if (_sort.policy == SortingPolicy::NONE)
+		return {};
+	HSV hsv = color.rgb.to_hsv();
+	HSL hsl = color.rgb.to_hsl();
+	float channel_values[(size_t)SortKeyChannel::_COUNT] = { color.rgb.r, color.rgb.g, color.rgb.b, color.alpha, hsv.h, hsv.s, hsv.v, hsl.s, hsl.l };
+	return pack_sort_key(channel_values, _sort);
+}
+
+bool ColorSubscheme::key_cache_in_sync() const
+{
+	return _sort.policy != SortingPolicy::NONE && key_cache.colors.size() == colors.size();
+}
+
+void ColorSubscheme::sync_key_cache()
+{
+	if (_sort.policy == SortingPolicy::NONE)
+		return;
+	if (key_cache.colors.size() != colors.size())
 	{
-		RGB ac = a.rgb, bc = b.rgb;
-		if (ac.r != bc.r)
-			return compare(bc.r, ac.r);
-		if (ac.g != bc.g)
-			return compare(ac.g, bc.g);
-		if (ac.b != bc.b)
-			return compare(ac.b, bc.b);
-		return compare(b.alpha, a.alpha);
+		compute_sort_keys(_sort, colors, key_cache.keys);
+		key_cache.colors = colors;
+		return;
 	}
-	case SortingPolicy::GREEN:
+	for (size_t i = 0; i < colors.size(); ++i)
 	{
-		RGB ac = a.rgb, bc = b.rgb;
-		if (ac.g != bc.g)
-			return compare(bc.g, ac.g);
-		if (ac.b != bc.b)
-			return compare(ac.b, bc.b);
-		if (ac.r != bc.r)
-			return compare(ac.r, bc.r);
-		return compare(b.alpha, a.alpha);
+		if (key_cache.colors[i] != colors[i])
+		{
+			key_cache.keys[i] = sort_key(colors[i]);
+			key_cache.colors[i] = colors[i];
+		}
 	}
-	case SortingPolicy::BLUE:
+}
+
+void ColorSubscheme::sort(Sort sort)
+{
+	if (sort == _sort)
+		return;
+	_sort = sort;
+	key_cache.keys.clear();
+	key_cache.colors.clear();
+	if (sort.policy == SortingPolicy::NONE)
+		return;
+	sync_key_cache();
+
+	std::vector<size_t> order(colors.size());
+	for (size_t i = 0; i < order.size(); ++i)
+		order[i] = i;
+	std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) { return key_cache.keys[a] < key_cache.keys[b]; });
+	std::vector<SortKey> sorted_keys;
+	sorted_keys.reserve(order.size());
+	for (size_t i = 0; i < order.size(); ++i)
 	{
-		RGB ac = a.rgb, bc = b.rgb;
-		if (ac.b != bc.b)
-			return compare(bc.b, ac.b);
-		if (ac.r != bc.r)
-			return compare(ac.r, bc.r);
-		if (ac.g != bc.g)
-			return compare(ac.g, bc.g);
-		return compare(b.alpha, a.alpha);
+		sorted_keys.push_back(key_cache.keys[order[i]]);
+		colors[i] = key_cache.colors[order[i]];
 	}
-	case SortingPolicy::ALPHA:
+	key_cache.keys = std::move(sorted_keys);
+	key_cache.colors = colors;
+}
+
+size_t ColorSubscheme::first_index_of(RGBA color)
+{
+	if (_sort.policy == SortingPolicy::NONE)
 	{
-		HSV ac = a.rgb.to_hsv(), bc = b.rgb.to_hsv();
-		if (a.alpha != b.alpha)
-			return compare(b.alpha, a.alpha);
-		if (ac.h != bc.h)
-			return compare(ac.h, bc.h);
-		if (ac.s != bc.s)
-			return compare(bc.s, ac.s);
-		return compare(bc.v, ac.v);
-	}
-	default:
-		return true;
+		auto iter = std::find(colors.begin(), colors.end(), color);
+		return iter == colors.end() ? -1 : iter - colors.begin();
 	}
+	sync_key_cache();
+	size_t i = std::lower_bound(key_cache.keys.begin(), key_cache.keys.end(), sort_key(color)) - key_cache.keys.begin();
+	if (i == colors.size() || colors[i] != color)
+		return -1;
+	else
+		return i;
+}
+
+bool ColorSubscheme::predicate(RGBA a, RGBA b) const
+{
+	return sort_key(a) < sort_key(b);
 }
 
 void ColorSubscheme::move(size_t from, size_t to)
@@ -151,3 +194,17 @@ void ColorSubscheme::move(size_t from, size_t to)
 		colors.insert(colors.begin() + to, c);
 	}
 }
+
+const PaletteLookup& ColorSubscheme::palette_lookup()
+{
+	if (lookup_cache.colors != colors)
+	{
+		std::vector<PixelRGBA> pixel_colors;
+		pixel_colors.reserve(std::min(colors.size(), PaletteLookup::MAX_COLORS));
+		for (size_t i = 0; i < colors.size() && i < PaletteLookup::MAX_COLORS; ++i)
+			pixel_colors.push_back(colors[i].get_pixel_rgba());
+		lookup_cache.lookup = PaletteLookup(pixel_colors);
+		lookup_cache.colors = colors;
+	}
+	return lookup_cache.lookup;
+}
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <memory>
 #include <vector>
 
 #include "Color.h"
+#include "PaletteLookup.h"
 
 struct ColorSubscheme
 {
@@ -38,19 +40,43 @@ struct ColorSubscheme
 		bool operator==(const Sort&) const = default;
 	};
 
+	// Four 32-bit fixed-point components, ordered and direction-flipped per policy, so that colors sort by plain ascending key comparison.
+	struct SortKey
+	{
+		unsigned long long hi = 0, lo = 0;
+
+		auto operator<=>(const SortKey&) const = default;
+	};
+
 private:
 	Sort _sort = { SortingPolicy::NONE, true };
+	// Keys of colors under _sort, along with the colors they were computed from, since colors can be edited in place from outside.
+	struct
+	{
+		std::vector<SortKey> keys;
+		std::vector<RGBA> colors;
+	} key_cache;
+	// Likewise, the lookup is rebuilt whenever colors no longer match the ones it was built from.
+	struct
+	{
+		PaletteLookup lookup;
+		std::vector<RGBA> colors;
+	} lookup_cache;
 	
 public:
 	void remove(size_t i);
 	void insert(RGBA color, size_t pos);
 	void sort(Sort sort);
 	size_t first_index_of(RGBA color);
-	bool predicate(RGBA a, RGBA b);
+	SortKey sort_key(RGBA color) const;
+	bool predicate(RGBA a, RGBA b) const;
 	void move(size_t from, size_t to);
+	// Nearest-colour lookup over colors, or over the first PaletteLookup::MAX_COLORS of them.
+	const PaletteLookup& palette_lookup();
 
 private:
-	bool(*compare)(float, float) = nullptr;
+	bool key_cache_in_sync() const;
+	void sync_key_cache();
 };
 
 struct ColorScheme
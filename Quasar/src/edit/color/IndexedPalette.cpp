@@ -0,0 +1,118 @@
+#include "IndexedPalette.h"
+
+#include <cstring>
+
+#include "variety/GLutility.h"
+#include "edit/image/Image.h"
+
+IndexedPalette::IndexedPalette(const std::shared_ptr<ColorSubscheme>& subscheme)
+	: subscheme(subscheme), colors(MAX_COLORS, PixelRGBA{ 0, 0, 0, 0 })
+{
+	QUASAR_GL(glGenTextures(1, &tid));
+	bind_texture(tid);
+	QUASAR_GL(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+	QUASAR_GL(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, (GLsizei)MAX_COLORS, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, colors.data()));
+	bind_texture_params({});
+	sync();
+}
+
+IndexedPalette::~IndexedPalette()
+{
+	delete_texture(tid);
+}
+
+bool IndexedPalette::sync()
+{
+	bool changed = false;
+	size_t n = std::min(subscheme->colors.size(), MAX_COLORS);
+	for (size_t i = 0; i < MAX_COLORS; ++i)
+	{
+		PixelRGBA color = i < n ? subscheme->colors[i].get_pixel_rgba() : PixelRGBA{ 0, 0, 0, 0 };
+		if (!(color == colors[i]))
+		{
+			colors[i] = color;
+			changed = true;
+		}
+	}
+	if (n != num_colors)
+	{
+		num_colors = n;
+		changed = true;
+	}
+	if (changed)
+	{
+		bind_texture(tid);
+		QUASAR_GL(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, (GLsizei)MAX_COLORS, 1, GL_RGBA, GL_UNSIGNED_BYTE, colors.data()));
+		lookup_stale = true;
+	}
+	return changed;
+}
+
+const PaletteLookup& IndexedPalette::palette_lookup()
+{
+	if (lookup_stale)
+	{
+		lookup = PaletteLookup(std::vector<PixelRGBA>(colors.begin(), colors.begin() + num_colors));
+		lookup_stale = false;
+	}
+	return lookup;
+}
+
+Byte IndexedPalette::index_of(PixelRGBA color)
+{
+	QUASAR_ASSERT(!empty());
+	for (size_t i = 0; i < num_colors; ++i)
+	{
+		if (colors[i] == color)
+			return (Byte)i;
+	}
+	if (color.a == 0)
+	{
+		for (size_t i = 0; i < num_colors; ++i)
+		{
+			if (colors[i].a == 0)
+				return (Byte)i;
+		}
+	}
+	return (Byte)palette_lookup().nearest(color);
+}
+
+Buffer index_buffer(const Buffer& buf, IndexedPalette& palette, QuantizeOptions::Dither dither)
+{
+	std::vector<Byte> indices = remap_to_palette(buf, palette.palette_lookup(), dither);
+	Buffer indexed;
+	indexed.width = buf.width;
+	indexed.height = buf.height;
+	indexed.chpp = 1;
+	indexed.pxnew();
+	memcpy(indexed.pixels, indices.data(), indices.size());
+
+	size_t transparent = 0;
+	while (transparent < palette.size() && palette.color((Byte)transparent).a != 0)
+		++transparent;
+	if (buf.chpp == 4 && transparent < palette.size())
+	{
+		for (Dim i = 0; i < buf.area(); ++i)
+		{
+			if (buf.pixels[4 * i + 3] == 0)
+				indexed.pixels[i] = (Byte)transparent;
+		}
+	}
+	return indexed;
+}
+
+Buffer expand_indexed_buffer(const Buffer& buf, const IndexedPalette& palette)
+{
+	QUASAR_ASSERT(buf.chpp == 1);
+	Buffer direct;
+	direct.width = buf.width;
+	direct.height = buf.height;
+	direct.chpp = 4;
+	direct.pxnew();
+	for (Dim i = 0; i < buf.area(); ++i)
+	{
+		PixelRGBA color = palette.color(buf.pixels[i]);
+		memcpy(direct.pixels + 4 * i, &color, sizeof(color));
+	}
+	return direct;
+}
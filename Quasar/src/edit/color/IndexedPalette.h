@@ -0,0 +1,48 @@
+#pragma once
+
+#include <memory>
+
+#include "Macros.h"
+#include "ColorScheme.h"
+#include "Quantize.h"
+
+// Colours of an indexed image: the first MAX_COLORS colours of the subscheme it is linked to, uploaded to a MAX_COLORS x 1 texture that the
+// palette-lookup sprite shader reads. Editing the subscheme recolours every pixel of the image once sync() reuploads that texture.
+// Indices refer to positions in the subscheme, so reordering its colours reorders the image's colours too.
+class IndexedPalette
+{
+	std::shared_ptr<ColorSubscheme> subscheme;
+	std::vector<PixelRGBA> colors; // as of the last sync, padded to MAX_COLORS with transparent black
+	size_t num_colors = 0;
+	GLuint tid = 0;
+	// Only painting needs the lookup, so it is rebuilt on first use after a sync that changed the colours.
+	PaletteLookup lookup;
+	bool lookup_stale = true;
+
+public:
+	static constexpr size_t MAX_COLORS = MAX_QUANTIZED_COLORS;
+
+	IndexedPalette(const std::shared_ptr<ColorSubscheme>& subscheme);
+	IndexedPalette(const IndexedPalette&) = delete;
+	IndexedPalette(IndexedPalette&&) noexcept = delete;
+	~IndexedPalette();
+
+	const std::shared_ptr<ColorSubscheme>& linked_subscheme() const { return subscheme; }
+	GLuint texture() const { return tid; }
+	size_t size() const { return num_colors; }
+	bool empty() const { return num_colors == 0; }
+	PixelRGBA color(Byte index) const { return colors[index]; }
+
+	// Reuploads the texture if the subscheme's colours changed since the last sync, and returns whether they did.
+	bool sync();
+	// Index of the first entry equal to color. Failing that, the first fully transparent entry for a transparent color if there is one,
+	// or else the nearest entry, ignoring alpha. The palette must not be empty.
+	Byte index_of(PixelRGBA color);
+	const PaletteLookup& palette_lookup();
+};
+
+// Indexed copy (chpp 1) of a direct colour buffer, remapped to the nearest entries of a non-empty palette. Fully transparent pixels
+// go to the first fully transparent entry if there is one. Other than that, alpha comes from the palette entries.
+extern Buffer index_buffer(const Buffer& buf, IndexedPalette& palette, QuantizeOptions::Dither dither);
+// Direct RGBA copy of an indexed buffer.
+extern Buffer expand_indexed_buffer(const Buffer& buf, const IndexedPalette& palette);
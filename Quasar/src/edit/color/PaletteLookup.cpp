@@ -0,0 +1,254 @@
+#include "PaletteLookup.h"
+
+#include <atomic>
+#include <thread>
+
+#include "ColorLanes.h"
+
+static constexpr size_t PLANAR_PADDING = 8;
+static constexpr float FAR_AWAY = 1e9f;
+
+static float lab_distance2(const Oklab& x, const Oklab& y)
+{
+	float dl = x.L - y.L, da = x.a - y.a, db = x.b - y.b;
+	return dl * dl + da * da + db * db;
+}
+
+PlanarPalette::PlanarPalette(const std::vector<Oklab>& colors)
+{
+	size_t padded = (colors.size() + PLANAR_PADDING - 1) / PLANAR_PADDING * PLANAR_PADDING;
+	L.resize(padded, FAR_AWAY);
+	a.resize(padded, FAR_AWAY);
+	b.resize(padded, FAR_AWAY);
+	for (size_t i = 0; i < colors.size(); ++i)
+	{
+		L[i] = colors[i].L;
+		a[i] = colors[i].a;
+		b[i] = colors[i].b;
+	}
+}
+
+// Each lane tracks the nearest entry among every N-th palette colour. Distances are computed in the same order as lab_distance2().
+template<typename Lanes>
+size_t PlanarPalette::nearest_lanes(Oklab lab) const
+{
+	typedef typename Lanes::V V;
+	static const float lane_indices[8] = { 0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f };
+	const V cl = Lanes::set(lab.L), ca = Lanes::set(lab.a), cb = Lanes::set(lab.b), step = Lanes::set((float)Lanes::N);
+	V best = Lanes::set(FLT_MAX), best_index = Lanes::set(0.0f), index = Lanes::load(lane_indices);
+	for (size_t i = 0; i < L.size(); i += Lanes::N)
+	{
+		V dl = Lanes::sub(Lanes::load(L.data() + i), cl);
+		V da = Lanes::sub(Lanes::load(a.data() + i), ca);
+		V db = Lanes::sub(Lanes::load(b.data() + i), cb);
+		V d = Lanes::add(Lanes::add(Lanes::mul(dl, dl), Lanes::mul(da, da)), Lanes::mul(db, db));
+		V closer = Lanes::lt(d, best);
+		best = Lanes::select(closer, d, best);
+		best_index = Lanes::select(closer, index, best_index);
+		index = Lanes::add(index, step);
+	}
+	float bests[Lanes::N], indices[Lanes::N];
+	Lanes::store(bests, best);
+	Lanes::store(indices, best_index);
+	size_t k = 0;
+	for (size_t j = 1; j < Lanes::N; ++j)
+	{
+		if (bests[j] < bests[k] || (bests[j] == bests[k] && indices[j] < indices[k]))
+			k = j;
+	}
+	return (size_t)indices[k];
+}
+
+size_t PlanarPalette::nearest(Oklab lab) const
+{
+#if defined(QUASAR_COLOR_AVX2)
+	return nearest_lanes<AVXLanes>(lab);
+#elif defined(QUASAR_COLOR_SSE2)
+	return nearest_lanes<SSELanes>(lab);
+#else
+	size_t k = 0;
+	float best = FLT_MAX;
+	for (size_t i = 0; i < L.size(); ++i)
+	{
+		float d = lab_distance2(lab, { L[i], a[i], b[i] });
+		if (d < best)
+		{
+			best = d;
+			k = i;
+		}
+	}
+	return k;
+#endif
+}
+
+// Padding on cell bounds, far larger than the float error in computing them or in to_oklab() itself.
+static const float CELL_BOUNDS_EPSILON = 1e-4f;
+
+// Bounds of the Oklab image of the RGB box [lo, hi]. Every step of to_oklab() up to the cube roots increases with each channel,
+// so the corners bound the cube-rooted LMS values, and the final linear map is bounded term by term.
+static void oklab_bounds(PixelRGBA lo, PixelRGBA hi, Oklab& min, Oklab& max)
+{
+	static const float LMS_TO_LAB[3][3] = {
+		{ 0.2104542553f,  0.7936177850f, -0.0040720468f },
+		{ 1.9779984951f, -2.4285922050f,  0.4505937099f },
+		{ 0.0259040371f,  0.7827717662f, -0.8086757660f }
+	};
+	auto lms = [](Oklab lab, float* out) {
+		out[0] = lab.L + 0.3963377774f * lab.a + 0.2158037573f * lab.b;
+		out[1] = lab.L - 0.1055613458f * lab.a - 0.0638541728f * lab.b;
+		out[2] = lab.L - 0.0894841775f * lab.a - 1.2914855480f * lab.b;
+		};
+	float lms_lo[3], lms_hi[3];
+	lms(to_oklab(lo), lms_lo);
+	lms(to_oklab(hi), lms_hi);
+	float mins[3], maxs[3];
+	for (int row = 0; row < 3; ++row)
+	{
+		mins[row] = -CELL_BOUNDS_EPSILON;
+		maxs[row] = CELL_BOUNDS_EPSILON;
+		for (int k = 0; k < 3; ++k)
+		{
+			float c = LMS_TO_LAB[row][k];
+			mins[row] += c * (c >= 0.0f ? lms_lo[k] : lms_hi[k]);
+			maxs[row] += c * (c >= 0.0f ? lms_hi[k] : lms_lo[k]);
+		}
+	}
+	min = { mins[0], mins[1], mins[2] };
+	max = { maxs[0], maxs[1], maxs[2] };
+}
+
+static float box_min_distance2(const Oklab& p, const Oklab& min, const Oklab& max)
+{
+	float dl = std::max({ min.L - p.L, 0.0f, p.L - max.L });
+	float da = std::max({ min.a - p.a, 0.0f, p.a - max.a });
+	float db = std::max({ min.b - p.b, 0.0f, p.b - max.b });
+	return dl * dl + da * da + db * db;
+}
+
+static float box_max_distance2(const Oklab& p, const Oklab& min, const Oklab& max)
+{
+	float dl = std::max(p.L - min.L, max.L - p.L);
+	float da = std::max(p.a - min.a, max.a - p.a);
+	float db = std::max(p.b - min.b, max.b - p.b);
+	return dl * dl + da * da + db * db;
+}
+
+PaletteLookup::PaletteLookup(const std::vector<PixelRGBA>& colors)
+	: palette(colors)
+{
+	QUASAR_ASSERT(palette.size() <= MAX_COLORS);
+	labs.reserve(palette.size());
+	for (PixelRGBA color : palette)
+		labs.push_back(to_oklab(color));
+	planar = PlanarPalette(labs);
+	if (palette.empty())
+		return;
+
+	// A colour can only be nearest somewhere in a cell if its closest approach to the cell is within the farthest reach of the palette colour
+	// that is nearest in the worst case. Slabs of constant red are built on separate threads, and then concatenated in order.
+	static const size_t MIN_COLORS_FOR_THREADS = 16;
+	static const int CELL_WIDTH = 1 << CELL_BITS;
+	std::vector<std::vector<unsigned short>> slab_candidates(GRID_SIZE);
+	std::vector<unsigned int> cell_counts(GRID_SIZE * GRID_SIZE * GRID_SIZE);
+	std::atomic<int> next_slab = 0;
+	auto worker = [&]() {
+		std::vector<float> min_distances(palette.size());
+		for (int r = next_slab++; r < GRID_SIZE; r = next_slab++)
+		{
+			for (int g = 0; g < GRID_SIZE; ++g)
+			{
+				for (int b = 0; b < GRID_SIZE; ++b)
+				{
+					PixelRGBA lo = { Byte(r * CELL_WIDTH), Byte(g * CELL_WIDTH), Byte(b * CELL_WIDTH), 255 };
+					PixelRGBA hi = { Byte(lo.r + CELL_WIDTH - 1), Byte(lo.g + CELL_WIDTH - 1), Byte(lo.b + CELL_WIDTH - 1), 255 };
+					Oklab min, max;
+					oklab_bounds(lo, hi, min, max);
+					float bound = FLT_MAX;
+					for (size_t i = 0; i < labs.size(); ++i)
+					{
+						min_distances[i] = box_min_distance2(labs[i], min, max);
+						bound = std::min(bound, box_max_distance2(labs[i], min, max));
+					}
+					unsigned int count = 0;
+					for (size_t i = 0; i < labs.size(); ++i)
+					{
+						if (min_distances[i] <= bound)
+						{
+							slab_candidates[r].push_back((unsigned short)i);
+							++count;
+						}
+					}
+					cell_counts[cell_of(lo)] = count;
+				}
+			}
+		}
+		};
+	size_t num_threads = palette.size() < MIN_COLORS_FOR_THREADS ? 1 : std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u), GRID_SIZE);
+	std::vector<std::thread> threads;
+	threads.reserve(num_threads - 1);
+	for (size_t i = 1; i < num_threads; ++i)
+		threads.emplace_back(worker);
+	worker();
+	for (std::thread& thread : threads)
+		thread.join();
+
+	cell_starts.resize(cell_counts.size() + 1);
+	cell_starts[0] = 0;
+	for (size_t i = 0; i < cell_counts.size(); ++i)
+		cell_starts[i + 1] = cell_starts[i] + cell_counts[i];
+	candidates.reserve(cell_starts.back());
+	for (const std::vector<unsigned short>& slab : slab_candidates)
+		candidates.insert(candidates.end(), slab.begin(), slab.end());
+}
+
+size_t PaletteLookup::nearest(PixelRGBA color) const
+{
+	size_t cell = cell_of(color);
+	unsigned int begin = cell_starts[cell], end = cell_starts[cell + 1];
+	if (end - begin == 1)
+		return candidates[begin];
+	Oklab lab = to_oklab(color);
+	size_t best_index = candidates[begin];
+	float best = lab_distance2(lab, labs[best_index]);
+	for (unsigned int i = begin + 1; i < end; ++i)
+	{
+		float d = lab_distance2(lab, labs[candidates[i]]);
+		if (d < best)
+		{
+			best = d;
+			best_index = candidates[i];
+		}
+	}
+	return best_index;
+}
+
+template<typename Index>
+void PaletteLookup::nearest_batch(const Byte* pixels, CHPP chpp, Index* indices, size_t n) const
+{
+	QUASAR_ASSERT(palette.size() - 1 <= (size_t)std::numeric_limits<Index>::max());
+	const CHPP color_channels = std::min(chpp, 3);
+	PixelRGBA run_color{};
+	Index run_index = 0;
+	for (size_t i = 0; i < n; ++i, pixels += chpp)
+	{
+		PixelRGBA color{ 255, 255, 255, 255 };
+		for (CHPP c = 0; c < color_channels; ++c)
+			color.at(c) = pixels[c];
+		if (i == 0 || !(color == run_color))
+		{
+			run_color = color;
+			run_index = (Index)nearest(color);
+		}
+		indices[i] = run_index;
+	}
+}
+
+void PaletteLookup::nearest(const Byte* pixels, CHPP chpp, Byte* indices, size_t n) const
+{
+	nearest_batch(pixels, chpp, indices, n);
+}
+
+void PaletteLookup::nearest(const Byte* pixels, CHPP chpp, unsigned short* indices, size_t n) const
+{
+	nearest_batch(pixels, chpp, indices, n);
+}
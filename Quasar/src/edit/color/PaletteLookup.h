@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+
+#include "ColorBuffer.h"
+
+// Palette colours as planes of Oklab components, padded to a whole number of the widest SIMD lanes.
+// Answers nearest-colour queries for arbitrary Oklab points with a vectorized linear scan, which suits palettes that change every use.
+class PlanarPalette
+{
+	std::vector<float> L, a, b;
+
+public:
+	PlanarPalette() = default;
+	PlanarPalette(const std::vector<Oklab>& colors);
+
+	// Ties go to the lowest index. The palette must not be empty.
+	size_t nearest(Oklab lab) const;
+
+private:
+	template<typename Lanes>
+	size_t nearest_lanes(Oklab lab) const;
+};
+
+// Nearest palette colour in Oklab for sRGB pixels, through a grid over the RGB cube whose cells only list the palette colours that can be
+// nearest to some colour in the cell. Results match a linear scan exactly, including ties going to the lowest index. Alpha is ignored.
+class PaletteLookup
+{
+	std::vector<PixelRGBA> palette;
+	std::vector<Oklab> labs;
+	PlanarPalette planar;
+	std::vector<unsigned int> cell_starts; // offsets of each cell's list in candidates, plus the end of the last
+	std::vector<unsigned short> candidates;
+
+public:
+	static constexpr int CELL_BITS = 3;
+	static constexpr int GRID_SIZE = 256 >> CELL_BITS;
+	static constexpr size_t MAX_COLORS = 1 << 16;
+
+	PaletteLookup() = default;
+	explicit PaletteLookup(const std::vector<PixelRGBA>& colors);
+
+	const std::vector<PixelRGBA>& colors() const { return palette; }
+	const std::vector<Oklab>& oklab_colors() const { return labs; }
+	bool empty() const { return palette.empty(); }
+
+	// None of the queries may be made on an empty lookup.
+	size_t nearest(PixelRGBA color) const;
+	// For points that aren't sRGB pixels, like colours shifted by diffused dithering error. Falls back to the linear scan.
+	size_t nearest(Oklab lab) const { return planar.nearest(lab); }
+	// Batch queries over n pixels of chpp channels each, where channels missing from chpp < 3 read as 255. Runs of equal pixels are looked up once.
+	void nearest(const Byte* pixels, CHPP chpp, Byte* indices, size_t n) const;
+	void nearest(const Byte* pixels, CHPP chpp, unsigned short* indices, size_t n) const;
+
+private:
+	static size_t cell_of(PixelRGBA color) { return (color.r >> CELL_BITS) * GRID_SIZE * GRID_SIZE + (color.g >> CELL_BITS) * GRID_SIZE + (color.b >> CELL_BITS); }
+	template<typename Index>
+	void nearest_batch(const Byte* pixels, CHPP chpp, Index* indices, size_t n) const;
+};
@@ -0,0 +1,484 @@
+#include "Quantize.h"
+
+#include <atomic>
+#include <thread>
+
+#include "ColorHistogram.h"
+
+static float lab_axis(const Oklab& lab, int axis)
+{
+	return axis == 0 ? lab.L : axis == 1 ? lab.a : lab.b;
+}
+
+static float lab_distance2(const Oklab& x, const Oklab& y)
+{
+	float dl = x.L - y.L, da = x.a - y.a, db = x.b - y.b;
+	return dl * dl + da * da + db * db;
+}
+
+static PixelRGBA pixel_at(const Byte* p, CHPP chpp)
+{
+	PixelRGBA color{ 255, 255, 255, 255 };
+	for (CHPP c = 0; c < chpp; ++c)
+		color.at(c) = p[c];
+	return color;
+}
+
+template<typename Func>
+static void run_threads(unsigned int num_threads, Func f)
+{
+	std::vector<std::thread> threads;
+	threads.reserve(num_threads - 1);
+	for (unsigned int t = 1; t < num_threads; ++t)
+		threads.emplace_back(f, t);
+	f(0u);
+	for (std::thread& thread : threads)
+		thread.join();
+}
+
+static unsigned int thread_count(size_t work, size_t min_work_per_thread)
+{
+	return (unsigned int)std::clamp<size_t>(work / min_work_per_thread, 1, std::max(std::thread::hardware_concurrency(), 1u));
+}
+
+struct ColorSample
+{
+	PixelRGBA color;
+	Oklab lab;
+	float weight;
+};
+
+// Past this many distinct colours, the histogram is binned to 5 bits per channel before clustering, and each bin stands in with its mean colour.
+static const size_t MAX_SAMPLES = 1 << 15;
+
+// Distinct opaque colours of the non-transparent pixels in buf, weighted by pixel count.
+static std::vector<ColorSample> color_samples(const Buffer& buf)
+{
+	std::vector<ColorCount> histogram = color_histogram(buf);
+	std::erase_if(histogram, [](const ColorCount& cc) { return cc.color.a == 0; });
+	if (histogram.size() > MAX_SAMPLES)
+	{
+		struct Bin
+		{
+			unsigned long long r = 0, g = 0, b = 0, count = 0;
+		};
+		std::vector<Bin> bins(1 << 15);
+		for (const ColorCount& cc : histogram)
+		{
+			Bin& bin = bins[(cc.color.r >> 3) << 10 | (cc.color.g >> 3) << 5 | cc.color.b >> 3];
+			bin.r += (unsigned long long)cc.color.r * cc.count;
+			bin.g += (unsigned long long)cc.color.g * cc.count;
+			bin.b += (unsigned long long)cc.color.b * cc.count;
+			bin.count += cc.count;
+		}
+		histogram.clear();
+		for (const Bin& bin : bins)
+		{
+			if (bin.count)
+				histogram.push_back({ PixelRGBA{ (Byte)((bin.r + bin.count / 2) / bin.count), (Byte)((bin.g + bin.count / 2) / bin.count),
+					(Byte)((bin.b + bin.count / 2) / bin.count), 255 }, (unsigned int)bin.count });
+		}
+	}
+	else
+	{
+		// Pixels that differ only in alpha are the same colour here. Sorting also makes the results independent of histogram order.
+		for (ColorCount& cc : histogram)
+			cc.color.a = 255;
+		std::sort(histogram.begin(), histogram.end(), [](const ColorCount& x, const ColorCount& y) {
+			return std::tie(x.color.r, x.color.g, x.color.b) < std::tie(y.color.r, y.color.g, y.color.b);
+			});
+		size_t merged = 0;
+		for (size_t i = 0; i < histogram.size(); ++i)
+		{
+			if (merged > 0 && histogram[merged - 1].color == histogram[i].color)
+				histogram[merged - 1].count += histogram[i].count;
+			else
+				histogram[merged++] = histogram[i];
+		}
+		histogram.resize(merged);
+	}
+
+	std::vector<ColorSample> samples;
+	samples.reserve(histogram.size());
+	for (const ColorCount& cc : histogram)
+		samples.push_back({ cc.color, to_oklab(cc.color), (float)cc.count });
+	return samples;
+}
+
+struct MedianCutBox
+{
+	size_t begin, end;
+	Oklab mean;
+	double error; // weighted sum of squared distances to mean
+	int axis; // of greatest variance
+};
+
+static MedianCutBox median_cut_box(const std::vector<ColorSample>& samples, size_t begin, size_t end)
+{
+	double weight = 0.0, sum[3] = {}, sum2[3] = {};
+	for (size_t i = begin; i < end; ++i)
+	{
+		weight += samples[i].weight;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			double v = lab_axis(samples[i].lab, axis);
+			sum[axis] += samples[i].weight * v;
+			sum2[axis] += samples[i].weight * v * v;
+		}
+	}
+	MedianCutBox box{ begin, end, {}, 0.0, 0 };
+	double mean[3], variance[3];
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		mean[axis] = sum[axis] / weight;
+		variance[axis] = std::max(sum2[axis] / weight - mean[axis] * mean[axis], 0.0);
+		box.error += weight * variance[axis];
+		if (variance[axis] > variance[box.axis])
+			box.axis = axis;
+	}
+	box.mean = { (float)mean[0], (float)mean[1], (float)mean[2] };
+	return box;
+}
+
+// Reorders samples within boxes as it splits them.
+static std::vector<Oklab> median_cut(std::vector<ColorSample>& samples, size_t num_colors)
+{
+	std::vector<MedianCutBox> boxes = { median_cut_box(samples, 0, samples.size()) };
+	while (boxes.size() < num_colors)
+	{
+		// Splits the box contributing the most error at the weighted median of its widest axis.
+		size_t split = boxes.size();
+		for (size_t i = 0; i < boxes.size(); ++i)
+		{
+			if (boxes[i].end - boxes[i].begin > 1 && (split == boxes.size() || boxes[i].error > boxes[split].error))
+				split = i;
+		}
+		if (split == boxes.size() || boxes[split].error <= 0.0)
+			break;
+		MedianCutBox box = boxes[split];
+		std::sort(samples.begin() + box.begin, samples.begin() + box.end, [axis = box.axis](const ColorSample& x, const ColorSample& y) {
+			return lab_axis(x.lab, axis) < lab_axis(y.lab, axis);
+			});
+		double half = 0.0;
+		for (size_t i = box.begin; i < box.end; ++i)
+			half += samples[i].weight;
+		half *= 0.5;
+		size_t mid = box.begin + 1;
+		double below = samples[box.begin].weight;
+		while (mid < box.end - 1 && below < half)
+			below += samples[mid++].weight;
+		boxes[split] = median_cut_box(samples, box.begin, mid);
+		boxes.push_back(median_cut_box(samples, mid, box.end));
+	}
+
+	std::vector<Oklab> means;
+	means.reserve(boxes.size());
+	for (const MedianCutBox& box : boxes)
+		means.push_back(box.mean);
+	return means;
+}
+
+static std::vector<PixelRGBA> octree(const std::vector<ColorSample>& samples, size_t num_colors)
+{
+	static const int DEPTH = 8;
+	struct Node
+	{
+		double r = 0.0, g = 0.0, b = 0.0, weight = 0.0;
+		int children[8] = { -1, -1, -1, -1, -1, -1, -1, -1 };
+		int level = 0;
+		bool leaf = false;
+	};
+
+	// Every node accumulates the colours of its whole subtree, so folding a node into a leaf only means no longer descending into it.
+	std::vector<Node> nodes(1);
+	size_t num_leaves = 0;
+	for (const ColorSample& sample : samples)
+	{
+		int n = 0;
+		for (int level = 0; ; ++level)
+		{
+			nodes[n].r += sample.weight * sample.color.r;
+			nodes[n].g += sample.weight * sample.color.g;
+			nodes[n].b += sample.weight * sample.color.b;
+			nodes[n].weight += sample.weight;
+			if (level == DEPTH)
+			{
+				if (!nodes[n].leaf)
+				{
+					nodes[n].leaf = true;
+					++num_leaves;
+				}
+				break;
+			}
+			int shift = 7 - level;
+			int child = ((sample.color.r >> shift) & 1) << 2 | ((sample.color.g >> shift) & 1) << 1 | ((sample.color.b >> shift) & 1);
+			if (nodes[n].children[child] < 0)
+			{
+				nodes[n].children[child] = (int)nodes.size();
+				nodes.push_back({});
+				nodes.back().level = level + 1;
+			}
+			n = nodes[n].children[child];
+		}
+	}
+
+	// Deepest levels fold first, lightest nodes first within a level. A level is only reached once every node below it is a leaf.
+	std::vector<int> levels[DEPTH];
+	for (int n = 0; n < (int)nodes.size(); ++n)
+	{
+		if (!nodes[n].leaf)
+			levels[nodes[n].level].push_back(n);
+	}
+	for (int level = DEPTH - 1; level >= 0 && num_leaves > num_colors; --level)
+	{
+		std::stable_sort(levels[level].begin(), levels[level].end(), [&nodes](int x, int y) { return nodes[x].weight < nodes[y].weight; });
+		for (int n : levels[level])
+		{
+			if (num_leaves <= num_colors)
+				break;
+			size_t num_children = 0;
+			for (int child : nodes[n].children)
+			{
+				if (child >= 0)
+					++num_children;
+			}
+			nodes[n].leaf = true;
+			num_leaves -= num_children - 1;
+		}
+	}
+
+	std::vector<PixelRGBA> palette;
+	std::vector<int> stack = { 0 };
+	while (!stack.empty())
+	{
+		const Node& node = nodes[stack.back()];
+		stack.pop_back();
+		if (node.leaf)
+			palette.push_back({ (Byte)roundi(float(node.r / node.weight)), (Byte)roundi(float(node.g / node.weight)), (Byte)roundi(float(node.b / node.weight)), 255 });
+		else
+		{
+			for (int child : node.children)
+			{
+				if (child >= 0)
+					stack.push_back(child);
+			}
+		}
+	}
+	return palette;
+}
+
+// Lloyd's algorithm, with samples split across threads that each accumulate their own cluster sums.
+static std::vector<Oklab> k_means(const std::vector<ColorSample>& samples, std::vector<Oklab> centroids, int iterations)
+{
+	static const size_t MIN_SAMPLES_PER_THREAD = 1 << 11;
+	static const float CONVERGED_DISTANCE2 = 1e-8f;
+	struct ClusterSum
+	{
+		double L = 0.0, a = 0.0, b = 0.0, weight = 0.0;
+	};
+	unsigned int num_threads = thread_count(samples.size(), MIN_SAMPLES_PER_THREAD);
+	std::vector<std::vector<ClusterSum>> sums(num_threads);
+	for (int iteration = 0; iteration < iterations; ++iteration)
+	{
+		PlanarPalette planar(centroids);
+		run_threads(num_threads, [&](unsigned int t) {
+			std::vector<ClusterSum>& cluster_sums = sums[t];
+			cluster_sums.assign(centroids.size(), {});
+			size_t end = samples.size() * (t + 1) / num_threads;
+			for (size_t i = samples.size() * t / num_threads; i < end; ++i)
+			{
+				const ColorSample& sample = samples[i];
+				ClusterSum& sum = cluster_sums[planar.nearest(sample.lab)];
+				sum.L += sample.weight * sample.lab.L;
+				sum.a += sample.weight * sample.lab.a;
+				sum.b += sample.weight * sample.lab.b;
+				sum.weight += sample.weight;
+			}
+			});
+
+		float movement = 0.0f;
+		for (size_t k = 0; k < centroids.size(); ++k)
+		{
+			ClusterSum total;
+			for (const std::vector<ClusterSum>& cluster_sums : sums)
+			{
+				total.L += cluster_sums[k].L;
+				total.a += cluster_sums[k].a;
+				total.b += cluster_sums[k].b;
+				total.weight += cluster_sums[k].weight;
+			}
+			// LATER reseed empty clusters at the sample with the greatest error instead of leaving them where they are.
+			if (total.weight > 0.0)
+			{
+				Oklab centroid = { float(total.L / total.weight), float(total.a / total.weight), float(total.b / total.weight) };
+				movement = std::max(movement, lab_distance2(centroid, centroids[k]));
+				centroids[k] = centroid;
+			}
+		}
+		if (movement < CONVERGED_DISTANCE2)
+			break;
+	}
+	return centroids;
+}
+
+std::vector<PixelRGBA> quantize_palette(const Buffer& buf, const QuantizeOptions& options)
+{
+	size_t num_colors = (size_t)std::clamp(options.num_colors, 1, MAX_QUANTIZED_COLORS);
+	std::vector<ColorSample> samples = color_samples(buf);
+	std::vector<PixelRGBA> palette;
+	if (samples.size() <= num_colors)
+	{
+		for (const ColorSample& sample : samples)
+			palette.push_back(sample.color);
+	}
+	else
+	{
+		switch (options.method)
+		{
+		case QuantizeOptions::Method::MEDIAN_CUT:
+			for (Oklab lab : median_cut(samples, num_colors))
+				palette.push_back(from_oklab(lab));
+			break;
+		case QuantizeOptions::Method::OCTREE:
+			palette = octree(samples, num_colors);
+			break;
+		case QuantizeOptions::Method::K_MEANS:
+			for (Oklab lab : k_means(samples, median_cut(samples, num_colors), options.k_means_iterations))
+				palette.push_back(from_oklab(lab));
+			break;
+		}
+	}
+
+	// Distinct centroids can round to the same colour.
+	std::vector<std::pair<float, PixelRGBA>> by_lightness;
+	by_lightness.reserve(palette.size());
+	for (PixelRGBA color : palette)
+		by_lightness.push_back({ to_oklab(color).L, color });
+	std::sort(by_lightness.begin(), by_lightness.end(), [](const auto& x, const auto& y) {
+		return std::tie(x.first, x.second.r, x.second.g, x.second.b) < std::tie(y.first, y.second.r, y.second.g, y.second.b);
+		});
+	palette.clear();
+	for (const auto& [lightness, color] : by_lightness)
+	{
+		if (palette.empty() || !(palette.back() == color))
+			palette.push_back(color);
+	}
+	return palette;
+}
+
+// Error diffusion is sequential by nature, so this runs on one thread. Errors diffuse in Oklab, and fully transparent pixels neither take nor pass on error.
+template<typename Index>
+static void floyd_steinberg(const Buffer& buf, const PaletteLookup& lookup, std::vector<Index>& indices)
+{
+	const std::vector<Oklab>& palette = lookup.oklab_colors();
+	std::vector<Oklab> error(buf.width + 2), next_error(buf.width + 2);
+	auto diffuse = [](Oklab& to, const Oklab& diff, float fraction) {
+		to.L += diff.L * fraction;
+		to.a += diff.a * fraction;
+		to.b += diff.b * fraction;
+		};
+	for (Dim y = 0; y < buf.height; ++y)
+	{
+		std::fill(next_error.begin(), next_error.end(), Oklab{});
+		for (Dim x = 0; x < buf.width; ++x)
+		{
+			PixelRGBA color = pixel_at(buf.pos(x, y), buf.chpp);
+			Index& index = indices[buf.index_offset(x, y)];
+			if (color.a == 0)
+			{
+				index = (Index)lookup.nearest(color);
+				continue;
+			}
+			Oklab lab = to_oklab(color);
+			const Oklab& e = error[x + 1];
+			lab.L += e.L;
+			lab.a += e.a;
+			lab.b += e.b;
+			index = (Index)lookup.nearest(lab);
+			Oklab diff = { lab.L - palette[index].L, lab.a - palette[index].a, lab.b - palette[index].b };
+			diffuse(error[x + 2], diff, 7.0f / 16);
+			diffuse(next_error[x], diff, 3.0f / 16);
+			diffuse(next_error[x + 1], diff, 5.0f / 16);
+			diffuse(next_error[x + 2], diff, 1.0f / 16);
+		}
+		error.swap(next_error);
+	}
+}
+
+static const float BAYER_4X4[4][4] = {
+	{  0.0f,  8.0f,  2.0f, 10.0f },
+	{ 12.0f,  4.0f, 14.0f,  6.0f },
+	{  3.0f, 11.0f,  1.0f,  9.0f },
+	{ 15.0f,  7.0f, 13.0f,  5.0f }
+};
+
+template<typename Index>
+static std::vector<Index> remap(const Buffer& buf, const PaletteLookup& lookup, QuantizeOptions::Dither dither)
+{
+	QUASAR_ASSERT(!lookup.empty());
+	std::vector<Index> indices(buf.area());
+	if (dither == QuantizeOptions::Dither::FLOYD_STEINBERG)
+	{
+		floyd_steinberg(buf, lookup, indices);
+		return indices;
+	}
+
+	// Roughly one step between palette colours, as if they were spread evenly over the RGB cube.
+	const float spread = 255.0f / std::cbrt((float)lookup.colors().size());
+	static const size_t MIN_PIXELS_PER_THREAD = 1 << 16;
+	static const int ROWS_PER_TASK = 16;
+	std::atomic<int> next_row = 0;
+	run_threads(thread_count(buf.area(), MIN_PIXELS_PER_THREAD), [&](unsigned int) {
+		for (int y0 = next_row.fetch_add(ROWS_PER_TASK); y0 < buf.height; y0 = next_row.fetch_add(ROWS_PER_TASK))
+		{
+			for (Dim y = y0; y < std::min(y0 + ROWS_PER_TASK, buf.height); ++y)
+			{
+				Index* out = indices.data() + buf.index_offset(0, y);
+				if (dither == QuantizeOptions::Dither::NONE)
+				{
+					lookup.nearest(buf.pos(0, y), buf.chpp, out, buf.width);
+					continue;
+				}
+				for (Dim x = 0; x < buf.width; ++x)
+				{
+					PixelRGBA color = pixel_at(buf.pos(x, y), buf.chpp);
+					float offset = ((BAYER_4X4[y & 3][x & 3] + 0.5f) / 16 - 0.5f) * spread;
+					color.r = (Byte)std::clamp(roundi(color.r + offset), 0, 255);
+					color.g = (Byte)std::clamp(roundi(color.g + offset), 0, 255);
+					color.b = (Byte)std::clamp(roundi(color.b + offset), 0, 255);
+					out[x] = (Index)lookup.nearest(color);
+				}
+			}
+		}
+		});
+	return indices;
+}
+
+template<typename Index>
+static void apply_indices(const Buffer& buf, const std::vector<PixelRGBA>& palette, const std::vector<Index>& indices)
+{
+	const CHPP color_channels = std::min(buf.chpp, 3);
+	for (Dim i = 0; i < buf.area(); ++i)
+	{
+		Byte* p = buf.pixels + i * buf.chpp;
+		PixelRGBA color = palette[indices[i]];
+		for (CHPP c = 0; c < color_channels; ++c)
+			p[c] = color.at(c);
+	}
+}
+
+std::vector<Byte> remap_to_palette(const Buffer& buf, const PaletteLookup& lookup, QuantizeOptions::Dither dither)
+{
+	QUASAR_ASSERT(lookup.colors().size() <= MAX_QUANTIZED_COLORS);
+	return remap<Byte>(buf, lookup, dither);
+}
+
+void apply_palette_indices(const Buffer& buf, const std::vector<PixelRGBA>& palette, const std::vector<Byte>& indices)
+{
+	apply_indices(buf, palette, indices);
+}
+
+void snap_to_palette(const Buffer& buf, const PaletteLookup& lookup, QuantizeOptions::Dither dither)
+{
+	apply_indices(buf, lookup.colors(), remap<unsigned short>(buf, lookup, dither));
+}
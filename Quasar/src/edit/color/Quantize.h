@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vector>
+
+#include "PaletteLookup.h"
+
+struct QuantizeOptions
+{
+	enum class Method : char
+	{
+		MEDIAN_CUT,
+		OCTREE,
+		K_MEANS
+	} method = Method::K_MEANS;
+
+	enum class Dither : char
+	{
+		NONE,
+		ORDERED,
+		FLOYD_STEINBERG
+	} dither = Dither::NONE;
+
+	int num_colors = 16;
+	// K_MEANS only. Iterations stop early once the centroids settle. Seeded by median cut.
+	int k_means_iterations = 8;
+
+	bool operator==(const QuantizeOptions&) const = default;
+};
+
+constexpr int MAX_QUANTIZED_COLORS = 256;
+
+// Up to options.num_colors opaque colours, clamped to [1, MAX_QUANTIZED_COLORS], representing the non-transparent pixels of buf, ordered by lightness.
+// Images with no more distinct colours than that get exactly their own colours back. Fully transparent images get an empty palette.
+// Like Canvas::pixel_color_at(), channels missing from buffers with chpp < 3 read as 255.
+extern std::vector<PixelRGBA> quantize_palette(const Buffer& buf, const QuantizeOptions& options);
+// Index of the lookup's palette colour that each pixel of buf maps to, in row-major order. Alpha is ignored, and the palette must hold 1 to MAX_QUANTIZED_COLORS colours.
+extern std::vector<Byte> remap_to_palette(const Buffer& buf, const PaletteLookup& lookup, QuantizeOptions::Dither dither);
+// Overwrites the colour channels of buf with palette[indices[i]], leaving alpha untouched.
+extern void apply_palette_indices(const Buffer& buf, const std::vector<PixelRGBA>& palette, const std::vector<Byte>& indices);
+// Recolours buf in place with the nearest colours of a non-empty palette of any size, leaving alpha untouched.
+extern void snap_to_palette(const Buffer& buf, const PaletteLookup& lookup, QuantizeOptions::Dither dither);
@@ -0,0 +1,216 @@
+#include "Filters.h"
+
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+#include "../color/ColorBuffer.h"
+
+// Everything except HSL_SHIFT maps each colour channel independently, so it is baked into a byte lookup table once per apply.
+struct CompiledColorFilter
+{
+	const ColorFilter& filter;
+	bool hsl = false;
+	std::array<Byte, 256> lut = {};
+
+	CompiledColorFilter(const ColorFilter& filter);
+};
+
+static Byte to_byte(float v)
+{
+	return (Byte)std::clamp(roundi(v * 255), 0, 255);
+}
+
+static Byte curve_at(const std::vector<glm::ivec2>& curve, int x)
+{
+	// LATER smooth curves (monotone cubic) instead of linear segments.
+	if (curve.empty())
+		return (Byte)x;
+	if (x <= curve.front().x)
+		return (Byte)std::clamp(curve.front().y, 0, 255);
+	for (size_t i = 1; i < curve.size(); ++i)
+	{
+		if (x <= curve[i].x)
+		{
+			glm::ivec2 a = curve[i - 1], b = curve[i];
+			float t = b.x != a.x ? float(x - a.x) / (b.x - a.x) : 1.0f;
+			return (Byte)std::clamp(roundi(a.y + t * (b.y - a.y)), 0, 255);
+		}
+	}
+	return (Byte)std::clamp(curve.back().y, 0, 255);
+}
+
+CompiledColorFilter::CompiledColorFilter(const ColorFilter& filter)
+	: filter(filter)
+{
+	switch (filter.type)
+	{
+	case ColorFilter::Type::HSL_SHIFT:
+		hsl = true;
+		break;
+	case ColorFilter::Type::BRIGHTNESS_CONTRAST:
+	{
+		float contrast = std::clamp(filter.contrast, -1.0f, 0.99f);
+		float factor = (1.0f + contrast) / (1.0f - contrast);
+		for (int i = 0; i < 256; ++i)
+			lut[i] = to_byte((i * inv255 - 0.5f) * factor + 0.5f + filter.brightness);
+		break;
+	}
+	case ColorFilter::Type::LEVELS:
+	{
+		float in_range = float(std::max(filter.in_white - filter.in_black, 1));
+		float inv_gamma = 1.0f / std::max(filter.gamma, 0.01f);
+		for (int i = 0; i < 256; ++i)
+		{
+			float t = std::pow(std::clamp((i - filter.in_black) / in_range, 0.0f, 1.0f), inv_gamma);
+			lut[i] = (Byte)std::clamp(roundi(filter.out_black + t * (filter.out_white - filter.out_black)), 0, 255);
+		}
+		break;
+	}
+	case ColorFilter::Type::CURVES:
+		for (int i = 0; i < 256; ++i)
+			lut[i] = curve_at(filter.curve, i);
+		break;
+	case ColorFilter::Type::INVERT:
+		for (int i = 0; i < 256; ++i)
+			lut[i] = (Byte)(255 - i);
+		break;
+	case ColorFilter::Type::POSTERIZE:
+	{
+		float levels = float(std::max(filter.posterize_levels, 2) - 1);
+		for (int i = 0; i < 256; ++i)
+			lut[i] = to_byte(roundf(i * inv255 * levels) / levels);
+		break;
+	}
+	}
+}
+
+static float shift_towards_bounds(float value, float shift)
+{
+	return shift >= 0.0f ? value + shift * (1.0f - value) : value + shift * value;
+}
+
+// Like Canvas::pixel_color_at(), channels missing from buffers with chpp < 3 read as 255. Channel 3 is alpha and is only ever copied.
+static void filter_tile(const CompiledColorFilter& cf, const Buffer& src, const Buffer& dst, IntRect tile, int step, std::vector<float>& scratch)
+{
+	const CHPP chpp = src.chpp;
+	const CHPP color_channels = std::min(chpp, 3);
+	const int samples = (tile.w + step - 1) / step;
+	const Dim stride = dst.stride();
+	for (int y = tile.y; y < tile.y + tile.h; y += step)
+	{
+		const Byte* in = src.pos(tile.x, y);
+		Byte* out = dst.pos(tile.x, y);
+		if (cf.hsl)
+		{
+			float* h = scratch.data();
+			float* s = h + samples;
+			float* l = s + samples;
+			for (int i = 0; i < samples; ++i)
+			{
+				const Byte* p = in + i * step * chpp;
+				h[i] = p[0] * inv255;
+				s[i] = chpp > 1 ? p[1] * inv255 : 1.0f;
+				l[i] = chpp > 2 ? p[2] * inv255 : 1.0f;
+			}
+			rgb_to_hsl(h, s, l, h, s, l, samples);
+			for (int i = 0; i < samples; ++i)
+			{
+				h[i] += cf.filter.hue_shift;
+				h[i] -= std::floor(h[i]);
+				s[i] = shift_towards_bounds(s[i], cf.filter.saturation_shift);
+				l[i] = shift_towards_bounds(l[i], cf.filter.lightness_shift);
+			}
+			hsl_to_rgb(h, s, l, h, s, l, samples);
+			const float* planes[3] = { h, s, l };
+			for (int i = 0; i < samples; ++i)
+			{
+				const Byte* p = in + i * step * chpp;
+				Byte* q = out + i * step * chpp;
+				for (CHPP c = 0; c < color_channels; ++c)
+					q[c] = to_byte(planes[c][i]);
+				if (chpp > 3)
+					q[3] = p[3];
+			}
+		}
+		else
+		{
+			for (int i = 0; i < samples; ++i)
+			{
+				const Byte* p = in + i * step * chpp;
+				Byte* q = out + i * step * chpp;
+				for (CHPP c = 0; c < color_channels; ++c)
+					q[c] = cf.lut[p[c]];
+				if (chpp > 3)
+					q[3] = p[3];
+			}
+		}
+
+		if (step > 1)
+		{
+			for (int i = 0; i < samples; ++i)
+			{
+				Byte* q = out + i * step * chpp;
+				int block_w = std::min(step, tile.w - i * step);
+				for (int j = 1; j < block_w; ++j)
+					memcpy(q + j * chpp, q, chpp);
+			}
+			int block_h = std::min(step, tile.y + tile.h - y);
+			for (int j = 1; j < block_h; ++j)
+				memcpy(out + j * stride, out, tile.w * chpp);
+		}
+	}
+}
+
+glm::ivec2 color_filter_tile_grid(const Buffer& buf)
+{
+	return { (buf.width + COLOR_FILTER_TILE_SIZE - 1) / COLOR_FILTER_TILE_SIZE, (buf.height + COLOR_FILTER_TILE_SIZE - 1) / COLOR_FILTER_TILE_SIZE };
+}
+
+IntRect color_filter_tile_rect(const Buffer& buf, int tile)
+{
+	glm::ivec2 grid = color_filter_tile_grid(buf);
+	int x = (tile % grid.x) * COLOR_FILTER_TILE_SIZE;
+	int y = (tile / grid.x) * COLOR_FILTER_TILE_SIZE;
+	return { x, y, std::min(COLOR_FILTER_TILE_SIZE, buf.width - x), std::min(COLOR_FILTER_TILE_SIZE, buf.height - y) };
+}
+
+void apply_color_filter(const ColorFilter& filter, const Buffer& src, const Buffer& dst, const std::vector<int>& tiles, int step)
+{
+	if (tiles.empty())
+		return;
+	assert_same_chpp(src, dst);
+	QUASAR_ASSERT(src.width == dst.width && src.height == dst.height);
+	CompiledColorFilter cf(filter);
+	step = std::max(step, 1);
+
+	// Tiles are handed out through a shared counter rather than pre-split, since preview tiles at the image edge are cheaper than interior ones.
+	std::atomic<size_t> next_tile = 0;
+	auto worker = [&]() {
+		std::vector<float> scratch(3 * COLOR_FILTER_TILE_SIZE);
+		for (size_t i = next_tile++; i < tiles.size(); i = next_tile++)
+			filter_tile(cf, src, dst, color_filter_tile_rect(src, tiles[i]), step, scratch);
+		};
+	// Threads are spawned per call, so small jobs like reduced previews of a few tiles get fewer of them, or none.
+	static const size_t MIN_SAMPLES_PER_THREAD = 1 << 15;
+	size_t tile_side = (COLOR_FILTER_TILE_SIZE + step - 1) / step;
+	size_t num_threads = std::clamp<size_t>(tiles.size() * tile_side * tile_side / MIN_SAMPLES_PER_THREAD, 1,
+		std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u), tiles.size()));
+	std::vector<std::thread> threads;
+	threads.reserve(num_threads - 1);
+	for (size_t i = 1; i < num_threads; ++i)
+		threads.emplace_back(worker);
+	worker();
+	for (std::thread& thread : threads)
+		thread.join();
+}
+
+void apply_color_filter(const ColorFilter& filter, const Buffer& src, const Buffer& dst)
+{
+	glm::ivec2 grid = color_filter_tile_grid(src);
+	std::vector<int> tiles(grid.x * grid.y);
+	for (int i = 0; i < (int)tiles.size(); ++i)
+		tiles[i] = i;
+	apply_color_filter(filter, src, dst, tiles, 1);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "PixelBuffer.h"
+#include "variety/Geometry.h"
+
+struct ColorFilter
+{
+	enum class Type : char
+	{
+		HSL_SHIFT,
+		BRIGHTNESS_CONTRAST,
+		LEVELS,
+		CURVES,
+		INVERT,
+		POSTERIZE
+	} type = Type::INVERT;
+
+	// HSL_SHIFT: hue rotates by a fraction of the colour wheel. Saturation and lightness shifts in [-1, 1] move towards 0 or 1.
+	float hue_shift = 0.0f;
+	float saturation_shift = 0.0f;
+	float lightness_shift = 0.0f;
+	// BRIGHTNESS_CONTRAST: both in [-1, 1].
+	float brightness = 0.0f;
+	float contrast = 0.0f;
+	// LEVELS
+	int in_black = 0, in_white = 255;
+	float gamma = 1.0f;
+	int out_black = 0, out_white = 255;
+	// CURVES: (input, output) control points in [0, 255], sorted by input.
+	std::vector<glm::ivec2> curve = { { 0, 0 }, { 64, 64 }, { 128, 128 }, { 192, 192 }, { 255, 255 } };
+	// POSTERIZE
+	int posterize_levels = 4;
+
+	bool operator==(const ColorFilter&) const = default;
+};
+
+constexpr int COLOR_FILTER_TILE_SIZE = 64;
+
+// Number of COLOR_FILTER_TILE_SIZE tiles along each axis of buf. Tile t covers column t % grid.x and row t / grid.x.
+extern glm::ivec2 color_filter_tile_grid(const Buffer& buf);
+extern IntRect color_filter_tile_rect(const Buffer& buf, int tile);
+
+// Filters the listed tiles of src into dst, which must have the same dimensions and may be src itself. Tiles are spread across threads.
+// With step > 1, only one pixel per step x step block is filtered and then copied across the block, for cheap previews while dragging.
+// Alpha is never modified.
+extern void apply_color_filter(const ColorFilter& filter, const Buffer& src, const Buffer& dst, const std::vector<int>& tiles, int step = 1);
+extern void apply_color_filter(const ColorFilter& filter, const Buffer& src, const Buffer& dst);
@@ -3,52 +3,14 @@
 #include <stb/stb_image.h>
 #include <stb/stb_image_write.h>
 #include <memory>
+#include <cstring>
 
 #include "variety/GLutility.h"
 #include "variety/Geometry.h"
+#include "variety/Profiler.h"
 #include "PixelBufferPaths.h"
-
-inline static GLenum chpp_format(CHPP chpp)
-{
-	if (chpp == 4)
-		return GL_RGBA;
-	else if (chpp == 3)
-		return GL_RGB;
-	else if (chpp == 2)
-		return GL_RG;
-	else if (chpp == 1)
-		return GL_RED;
-	else
-		return 0;
-}
-
-inline static GLint chpp_alignment(CHPP chpp)
-{
-	if (chpp == 4)
-		return 4;
-	else if (chpp == 3)
-		return 1;
-	else if (chpp == 2)
-		return 2;
-	else if (chpp == 1)
-		return 1;
-	else
-		return 0;
-}
-
-inline static GLint chpp_internal_format(CHPP chpp)
-{
-	if (chpp == 4)
-		return GL_RGBA8;
-	else if (chpp == 3)
-		return GL_RGB8;
-	else if (chpp == 2)
-		return GL_RG8;
-	else if (chpp == 1)
-		return GL_R8;
-	else
-		return 0;
-}
+#include "TiledTexture.h"
+#include "edit/color/IndexedPalette.h"
 
 inline static void delete_buffer(Image& image)
 {
@@ -57,9 +19,14 @@ inline static void delete_buffer(Image& image)
 
 inline static void delete_texture(Image& image)
 {
-	QUASAR_GL(glDeleteTextures(1, &image.tid));
+	if (image.tid)
+		delete_texture(image.tid);
+	image.tid = 0;
+	image.tiles.reset();
 }
 
+Image::Image() = default;
+
 Image::Image(const FilePath& filepath, bool _gen_texture)
 {
 	// LATER handle gif file from memory
@@ -69,16 +36,18 @@ Image::Image(const FilePath& filepath, bool _gen_texture)
 }
 
 Image::Image(const Image& other)
-	: buf(other.buf)
+	: buf(other.buf), palette(other.palette)
 {
 	buf.pxnew();
 	subbuffer_copy(buf, other.buf);
-	if (other.tid != 0)
+	if (other.tiles)
+		gen_tiled_texture();
+	else if (other.tid != 0)
 		gen_texture();
 }
 
 Image::Image(Image&& other) noexcept
-	: buf(other.buf), tid(other.tid)
+	: buf(other.buf), tid(other.tid), tiles(std::move(other.tiles)), palette(std::move(other.palette))
 {
 	other.buf.pixels = nullptr;
 	other.buf.width = 0;
@@ -97,7 +66,10 @@ Image& Image::operator=(const Image& other)
 		buf.pxnew();
 		subbuffer_copy(buf, other.buf);
 		buf = other.buf;
-		if (other.tid != 0)
+		palette = other.palette;
+		if (other.tiles)
+			gen_tiled_texture();
+		else if (other.tid != 0)
 			gen_texture();
 	}
 	return *this;
@@ -113,6 +85,8 @@ Image& Image::operator=(Image&& other) noexcept
 		other.buf.pixels = nullptr;
 		tid = other.tid;
 		other.tid = 0;
+		tiles = std::move(other.tiles);
+		palette = std::move(other.palette);
 	}
 	return *this;
 }
@@ -125,7 +99,7 @@ Image::~Image()
 
 void Image::gen_texture(const TextureParams& texture_params)
 {
-	if (tid == 0)
+	if (tid == 0 && !tiles)
 	{
 		QUASAR_GL(glGenTextures(1, &tid));
 		resend_texture();
@@ -133,9 +107,21 @@ void Image::gen_texture(const TextureParams& texture_params)
 	}
 }
 
+void Image::gen_tiled_texture(const TextureParams& texture_params)
+{
+	if (!tiles)
+	{
+		delete_texture(*this);
+		tiles = std::make_unique<TiledTexture>(texture_params);
+		resend_texture();
+	}
+}
+
 void Image::update_texture_params(const TextureParams& texture_params) const
 {
-	if (tid)
+	if (tiles)
+		tiles->set_params(buf, texture_params);
+	else if (tid)
 	{
 		bind_texture(tid);
 		bind_texture_params(texture_params);
@@ -144,9 +130,13 @@ void Image::update_texture_params(const TextureParams& texture_params) const
 
 void Image::update_texture() const
 {
-	if (tid)
+	if (tiles)
+		tiles->update(buf, { 0, 0, buf.width, buf.height });
+	else if (tid)
 	{
+		QUASAR_PROFILE("texture upload");
 		bind_texture(tid);
+		QUASAR_GL(glPixelStorei(GL_UNPACK_ALIGNMENT, chpp_alignment(buf.chpp)));
 		QUASAR_GL(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, buf.width, buf.height, chpp_format(buf.chpp), GL_UNSIGNED_BYTE, buf.pixels));
 	}
 }
@@ -158,12 +148,15 @@ void Image::update_subtexture(IntRect rect) const
 
 void Image::update_subtexture(int x, int y, int w, int h) const
 {
-	if (tid && on_interval(x, 0, buf.width - 1) && on_interval(y, 0, buf.height - 1) && w >= 0 && h >= 0)
+	if (tiles)
+		tiles->update(buf, { x, y, w, h });
+	else if (tid && on_interval(x, 0, buf.width - 1) && on_interval(y, 0, buf.height - 1) && w >= 0 && h >= 0)
 	{
 		if (x + w >= buf.width)
 			w = buf.width - x;
 		if (y + h >= buf.height)
 			h = buf.height - y;
+		QUASAR_PROFILE("texture upload");
 		bind_texture(tid);
 		for (Dim r = y; r < y + h; ++r)
 		{
@@ -174,6 +167,12 @@ void Image::update_subtexture(int x, int y, int w, int h) const
 
 void Image::resend_texture()
 {
+	if (tiles)
+	{
+		tiles->resend(buf, (bool)palette);
+		return;
+	}
+	QUASAR_PROFILE("texture upload");
 	if (!tid)
 	{
 		QUASAR_GL(glGenTextures(1, &tid));
@@ -183,8 +182,43 @@ void Image::resend_texture()
 	QUASAR_GL(glTexImage2D(GL_TEXTURE_2D, 0, chpp_internal_format(buf.chpp), buf.width, buf.height, 0, chpp_format(buf.chpp), GL_UNSIGNED_BYTE, buf.pixels));
 }
 
+void Image::set_visible_region(IntRect region) const
+{
+	if (tiles)
+		tiles->set_visible(buf, region);
+}
+
+PixelRGBA Image::pixel_color_at(int x, int y) const
+{
+	Byte* pixel = buf.pos(x, y);
+	if (palette)
+		return palette->color(*pixel);
+	PixelRGBA px{ 255, 255, 255, 255 };
+	for (CHPP i = 0; i < buf.chpp; ++i)
+		px.at(i) = pixel[i];
+	return px;
+}
+
+void Image::set_pixel_color(int x, int y, PixelRGBA c) const
+{
+	Byte* pixel = buf.pos(x, y);
+	if (palette)
+		*pixel = palette->index_of(c);
+	else
+	{
+		for (CHPP i = 0; i < buf.chpp; ++i)
+			pixel[i] = c[i];
+	}
+}
+
 bool Image::write_to_file(const FilePath& filepath, ImageFormat format, JPGQuality jpg_quality) const
 {
+	if (palette)
+	{
+		Image direct;
+		direct.buf = expand_indexed_buffer(buf, *palette);
+		return direct.write_to_file(filepath, format, jpg_quality);
+	}
 	switch (format)
 	{
 	case ImageFormat::PNG:
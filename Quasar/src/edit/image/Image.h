@@ -2,10 +2,12 @@
 
 #include <string>
 #include <functional>
+#include <memory>
 
 #include "Macros.h"
 #include "variety/FileSystem.h"
 #include "PixelBuffer.h"
+#include "../color/Color.h"
 
 enum class MinFilter : GLint
 {
@@ -85,6 +87,48 @@ inline void bind_texture_params(const TextureParams& params)
 	QUASAR_GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, static_cast<GLint>(params.wrap_t)));
 }
 
+inline GLenum chpp_format(CHPP chpp)
+{
+	if (chpp == 4)
+		return GL_RGBA;
+	else if (chpp == 3)
+		return GL_RGB;
+	else if (chpp == 2)
+		return GL_RG;
+	else if (chpp == 1)
+		return GL_RED;
+	else
+		return 0;
+}
+
+inline GLint chpp_alignment(CHPP chpp)
+{
+	if (chpp == 4)
+		return 4;
+	else if (chpp == 3)
+		return 1;
+	else if (chpp == 2)
+		return 2;
+	else if (chpp == 1)
+		return 1;
+	else
+		return 0;
+}
+
+inline GLint chpp_internal_format(CHPP chpp)
+{
+	if (chpp == 4)
+		return GL_RGBA8;
+	else if (chpp == 3)
+		return GL_RGB8;
+	else if (chpp == 2)
+		return GL_RG8;
+	else if (chpp == 1)
+		return GL_R8;
+	else
+		return 0;
+}
+
 enum class ImageFormat
 {
 	PNG,
@@ -108,9 +152,13 @@ enum class JPGQuality
 struct Image
 {
 	Buffer buf;
+	// 0 on tiled images, whose textures are in tiles.
 	GLuint tid = 0;
+	std::unique_ptr<class TiledTexture> tiles;
+	// Set on indexed images, whose buffer holds one palette index per pixel (chpp 1) instead of colours.
+	std::shared_ptr<class IndexedPalette> palette;
 
-	Image() = default;
+	Image();
 	Image(const FilePath& filepath, bool gen_texture = true);
 	Image(const Image&);
 	Image(Image&&) noexcept;
@@ -119,15 +167,27 @@ struct Image
 	~Image();
 
 	operator bool() const { return buf.pixels != nullptr; }
+	bool indexed() const { return (bool)palette; }
+	bool tiled() const { return (bool)tiles; }
+
+	// Reads through the palette on indexed images. Channels missing from buffers with chpp < 4 read as 255.
+	PixelRGBA pixel_color_at(int x, int y) const;
+	// On indexed images, sets the pixel to the palette entry chosen by IndexedPalette::index_of().
+	void set_pixel_color(int x, int y, PixelRGBA c) const;
 
 	// texture operations
 
 	void gen_texture(const TextureParams& texture_params = {});
+	// Replaces the single texture with a TiledTexture, for images that may exceed GL_MAX_TEXTURE_SIZE. Fully transparent tiles of non-indexed images
+	// get no texture. The texture operations below apply to the tiles.
+	void gen_tiled_texture(const TextureParams& texture_params = {});
 	void update_texture_params(const TextureParams& texture_params = {}) const;
 	void update_texture() const;
 	void update_subtexture(struct IntRect rect) const;
 	void update_subtexture(int x, int y, int w, int h) const;
 	void resend_texture();
+	// Tiled textures defer uploads to tiles outside region until it overlaps them, and aren't drawn there. No-op on untiled images.
+	void set_visible_region(struct IntRect region) const;
 
 	bool write_to_file(const FilePath& filepath, ImageFormat format, JPGQuality jpg_quality = JPGQuality::HIGHEST) const;
 
@@ -0,0 +1,149 @@
+#include "MipPyramid.h"
+
+#include <cstring>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define QUASAR_MIPS_SSE2
+#endif
+
+#ifdef QUASAR_MIPS_SSE2
+static __m128 load_rgba(const Byte* p)
+{
+	int packed;
+	memcpy(&packed, p, 4);
+	__m128i zero = _mm_setzero_si128();
+	__m128i v = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+	return _mm_cvtepi32_ps(v);
+}
+
+// One RGBA pixel per iteration, with its channels in the four lanes. Returns the first x it didn't write.
+static Dim downsample_rgba_row_sse2(const Byte* row0, const Byte* row1, Byte* dst, Dim x, Dim x_end)
+{
+	const __m128 quarter = _mm_set1_ps(0.25f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 color_lanes = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+	for (; x < x_end; ++x)
+	{
+		__m128 p0 = load_rgba(row0 + 8 * x);
+		__m128 p1 = load_rgba(row0 + 8 * x + 4);
+		__m128 p2 = load_rgba(row1 + 8 * x);
+		__m128 p3 = load_rgba(row1 + 8 * x + 4);
+		__m128 a0 = _mm_shuffle_ps(p0, p0, _MM_SHUFFLE(3, 3, 3, 3));
+		__m128 a1 = _mm_shuffle_ps(p1, p1, _MM_SHUFFLE(3, 3, 3, 3));
+		__m128 a2 = _mm_shuffle_ps(p2, p2, _MM_SHUFFLE(3, 3, 3, 3));
+		__m128 a3 = _mm_shuffle_ps(p3, p3, _MM_SHUFFLE(3, 3, 3, 3));
+		__m128 weight = _mm_add_ps(_mm_add_ps(a0, a1), _mm_add_ps(a2, a3));
+		if (_mm_cvtss_f32(weight) == 0.0f)
+		{
+			memset(dst + 4 * x, 0, 4);
+			continue;
+		}
+		__m128 weighted = _mm_add_ps(_mm_add_ps(_mm_mul_ps(p0, a0), _mm_mul_ps(p1, a1)), _mm_add_ps(_mm_mul_ps(p2, a2), _mm_mul_ps(p3, a3)));
+		__m128 color = _mm_div_ps(weighted, weight);
+		__m128 alpha = _mm_mul_ps(weight, quarter);
+		__m128 out = _mm_add_ps(_mm_or_ps(_mm_and_ps(color_lanes, color), _mm_andnot_ps(color_lanes, alpha)), half);
+		__m128i v = _mm_cvttps_epi32(out);
+		v = _mm_packs_epi32(v, v);
+		v = _mm_packus_epi16(v, v);
+		int packed = _mm_cvtsi128_si32(v);
+		memcpy(dst + 4 * x, &packed, 4);
+	}
+	return x;
+}
+#endif
+
+static void downsample_rgba_row(const Byte* row0, const Byte* row1, Byte* dst, Dim x, Dim x_end)
+{
+#ifdef QUASAR_MIPS_SSE2
+	x = downsample_rgba_row_sse2(row0, row1, dst, x, x_end);
+#endif
+	for (; x < x_end; ++x)
+	{
+		const Byte* p[4] = { row0 + 8 * x, row0 + 8 * x + 4, row1 + 8 * x, row1 + 8 * x + 4 };
+		unsigned int weight = p[0][3] + p[1][3] + p[2][3] + p[3][3];
+		Byte* out = dst + 4 * x;
+		if (weight == 0)
+		{
+			memset(out, 0, 4);
+			continue;
+		}
+		for (int ch = 0; ch < 3; ++ch)
+			out[ch] = Byte((p[0][ch] * p[0][3] + p[1][ch] * p[1][3] + p[2][ch] * p[2][3] + p[3][ch] * p[3][3] + weight / 2) / weight);
+		out[3] = Byte((weight + 2) / 4);
+	}
+}
+
+static void downsample_row(const Byte* row0, const Byte* row1, Byte* dst, Dim x, Dim x_end, CHPP chpp)
+{
+	for (; x < x_end; ++x)
+	{
+		for (CHPP ch = 0; ch < chpp; ++ch)
+		{
+			unsigned int sum = row0[2 * chpp * x + ch] + row0[2 * chpp * x + chpp + ch] + row1[2 * chpp * x + ch] + row1[2 * chpp * x + chpp + ch];
+			dst[chpp * x + ch] = Byte((sum + 2) / 4);
+		}
+	}
+}
+
+// rect is in dst coordinates.
+static void downsample(const Buffer& src, const Buffer& dst, IntRect rect)
+{
+	for (Dim y = rect.y; y < rect.y + rect.h; ++y)
+	{
+		const Byte* row0 = src.pos(0, 2 * y);
+		const Byte* row1 = src.pos(0, 2 * y + 1);
+		Byte* out = dst.pos(0, y);
+		if (dst.chpp == 4)
+			downsample_rgba_row(row0, row1, out, rect.x, rect.x + rect.w);
+		else
+			downsample_row(row0, row1, out, rect.x, rect.x + rect.w, dst.chpp);
+	}
+}
+
+MipPyramid::~MipPyramid()
+{
+	clear();
+}
+
+void MipPyramid::clear()
+{
+	for (Buffer& level : levels)
+		delete[] level.pixels;
+	levels.clear();
+}
+
+void MipPyramid::build(const Buffer& base, int max_levels)
+{
+	clear();
+	for (int k = 1; k < max_levels && (base.width >> k) >= 1 && (base.height >> k) >= 1; ++k)
+	{
+		Buffer level;
+		level.width = base.width >> k;
+		level.height = base.height >> k;
+		level.chpp = base.chpp;
+		level.pxnew();
+		downsample(this->level(base, k - 1), level, { 0, 0, level.width, level.height });
+		levels.push_back(level);
+	}
+}
+
+void MipPyramid::update(const Buffer& base, IntRect rect, std::vector<IntRect>& level_rects)
+{
+	level_rects.clear();
+	if (!IntRect{ 0, 0, base.width, base.height }.intersect(rect, rect) || rect.w <= 0 || rect.h <= 0)
+		return;
+	level_rects.push_back(rect);
+	for (int k = 1; k < num_levels(); ++k)
+	{
+		const Buffer& level = levels[k - 1];
+		int x1 = rect.x / 2, y1 = rect.y / 2;
+		int x2 = std::min((rect.x + rect.w + 1) / 2, level.width), y2 = std::min((rect.y + rect.h + 1) / 2, level.height);
+		if (x1 >= x2 || y1 >= y2)
+			break;
+		rect = { x1, y1, x2 - x1, y2 - y1 };
+		downsample(this->level(base, k - 1), level, rect);
+		level_rects.push_back(rect);
+	}
+}
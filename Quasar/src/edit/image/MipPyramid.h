@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vector>
+
+#include "PixelBuffer.h"
+#include "variety/Geometry.h"
+
+// Box-filtered reductions of a buffer, kept on the CPU so that an edit only recomputes the pixels it covers on each level.
+// Level k is (width >> k) x (height >> k), each pixel averaging a 2x2 block of level k - 1, so odd rows and columns are dropped like GL mip levels.
+// RGBA pixels are averaged weighted by alpha, so that transparent pixels don't darken the edges of what they surround.
+// Level 0 is the base buffer itself, which the pyramid doesn't own.
+class MipPyramid
+{
+	std::vector<Buffer> levels; // levels 1 and up
+
+public:
+	MipPyramid() = default;
+	MipPyramid(const MipPyramid&) = delete;
+	MipPyramid(MipPyramid&&) noexcept = delete;
+	~MipPyramid();
+
+	// Allocates and computes up to max_levels levels, counting the base, while both dimensions stay >= 1.
+	void build(const Buffer& base, int max_levels);
+	// Recomputes what rect of the base covers on each level. level_rects receives that rect per level, starting with rect itself clipped to the base.
+	void update(const Buffer& base, IntRect rect, std::vector<IntRect>& level_rects);
+	void clear();
+
+	int num_levels() const { return int(levels.size()) + 1; }
+	// level(base, 0) is base.
+	const Buffer& level(const Buffer& base, int k) const { return k == 0 ? base : levels[k - 1]; }
+};
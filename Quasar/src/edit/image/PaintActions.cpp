@@ -445,10 +445,10 @@ void DiscreteEllipseFillInterpolator::at(int i, int& x, int& y) const
 	y = points[i].y;
 }
 
-PaintToolAction::PaintToolAction(const std::shared_ptr<Image>& image, IntBounds bbox, std::unordered_map<IPosition, std::pair<PixelRGBA, PixelRGBA>>&& painted_colors)
+PaintToolAction::PaintToolAction(const std::shared_ptr<Image>& image, IntBounds bbox, PixelMap<std::pair<PixelRGBA, PixelRGBA>>&& painted_colors)
 	: image(image), bbox(bbox), painted_colors(std::move(painted_colors))
 {
-	weight = sizeof(PaintToolAction) + this->painted_colors.size() * (sizeof(IPosition) + 2 * sizeof(PixelRGBA));
+	weight = sizeof(PaintToolAction) + this->painted_colors.allocated_bytes();
 }
 
 void PaintToolAction::forward()
@@ -457,7 +457,6 @@ void PaintToolAction::forward()
 		return;
 	if (auto img = image.lock())
 	{
-		Buffer& buf = img->buf;
 		int x1 = INT_MAX, y1 = INT_MAX, x2 = INT_MIN, y2 = INT_MIN;
 		for (auto iter = painted_colors.begin(); iter != painted_colors.end(); ++iter)
 		{
@@ -470,7 +469,7 @@ void PaintToolAction::forward()
 				y1 = y;
 			if (y > y2)
 				y2 = y;
-			buffer_set_pixel_color(buf, x, y, iter->second.second);
+			img->set_pixel_color(x, y, iter->second.second);
 		}
 		img->update_subtexture(x1, y1, x2 - x1 + 1, y2 - y1 + 1);
 	}
@@ -482,7 +481,6 @@ void PaintToolAction::backward()
 		return;
 	if (auto img = image.lock())
 	{
-		Buffer& buf = img->buf;
 		int x1 = INT_MAX, y1 = INT_MAX, x2 = INT_MIN, y2 = INT_MIN;
 		for (auto iter = painted_colors.begin(); iter != painted_colors.end(); ++iter)
 		{
@@ -495,16 +493,16 @@ void PaintToolAction::backward()
 				y1 = y;
 			if (y > y2)
 				y2 = y;
-			buffer_set_pixel_color(buf, x, y, iter->second.first);
+			img->set_pixel_color(x, y, iter->second.first);
 		}
 		img->update_subtexture(x1, y1, x2 - x1 + 1, y2 - y1 + 1);
 	}
 }
 
-OneColorPenAction::OneColorPenAction(const std::shared_ptr<Image>& image, PixelRGBA color, IPosition start, IPosition finish, std::unordered_map<IPosition, PixelRGBA>&& painted_colors)
+OneColorPenAction::OneColorPenAction(const std::shared_ptr<Image>& image, PixelRGBA color, IPosition start, IPosition finish, PixelMap<PixelRGBA>&& painted_colors)
 	: image(image), color(color), painted_colors(std::move(painted_colors))
 {
-	weight = sizeof(OneColorPenAction) + this->painted_colors.size() * (sizeof(IPosition) + sizeof(PixelRGBA));
+	weight = sizeof(OneColorPenAction) + this->painted_colors.allocated_bytes();
 	bbox = abs_bounds(start, finish);
 }
 
@@ -514,9 +512,8 @@ void OneColorPenAction::forward()
 		return;
 	if (auto img = image.lock())
 	{
-		Buffer& buf = img->buf;
 		for (const auto& iter : painted_colors)
-			buffer_set_pixel_color(buf, iter.first.x, iter.first.y, color);
+			img->set_pixel_color(iter.first.x, iter.first.y, color);
 		img->update_subtexture(bbox.x1, bbox.y1, bbox.x2 - bbox.x1 + 1, bbox.y2 - bbox.y1 + 1);
 	}
 }
@@ -527,17 +524,16 @@ void OneColorPenAction::backward()
 		return;
 	if (auto img = image.lock())
 	{
-		Buffer& buf = img->buf;
 		for (const auto& iter : painted_colors)
-			buffer_set_pixel_color(buf, iter.first.x, iter.first.y, iter.second);
+			img->set_pixel_color(iter.first.x, iter.first.y, iter.second);
 		img->update_subtexture(bbox.x1, bbox.y1, bbox.x2 - bbox.x1 + 1, bbox.y2 - bbox.y1 + 1);
 	}
 }
 
-OneColorPencilAction::OneColorPencilAction(const std::shared_ptr<Image>& image, IPosition start, IPosition finish, std::unordered_map<IPosition, std::pair<PixelRGBA, PixelRGBA>>&& painted_colors)
+OneColorPencilAction::OneColorPencilAction(const std::shared_ptr<Image>& image, IPosition start, IPosition finish, PixelMap<std::pair<PixelRGBA, PixelRGBA>>&& painted_colors)
 	: image(image), painted_colors(std::move(painted_colors))
 {
-	weight = sizeof(OneColorPencilAction) + this->painted_colors.size() * (sizeof(IPosition) + 2 * sizeof(PixelRGBA));
+	weight = sizeof(OneColorPencilAction) + this->painted_colors.allocated_bytes();
 	bbox = abs_bounds(start, finish);
 }
 
@@ -547,9 +543,8 @@ void OneColorPencilAction::forward()
 		return;
 	if (auto img = image.lock())
 	{
-		Buffer& buf = img->buf;
 		for (const auto& iter : painted_colors)
-			buffer_set_pixel_color(buf, iter.first.x, iter.first.y, iter.second.first);
+			img->set_pixel_color(iter.first.x, iter.first.y, iter.second.first);
 		img->update_subtexture(bbox.x1, bbox.y1, bbox.x2 - bbox.x1 + 1, bbox.y2 - bbox.y1 + 1);
 	}
 }
@@ -560,9 +555,8 @@ void OneColorPencilAction::backward()
 		return;
 	if (auto img = image.lock())
 	{
-		Buffer& buf = img->buf;
 		for (const auto& iter : painted_colors)
-			buffer_set_pixel_color(buf, iter.first.x, iter.first.y, iter.second.second);
+			img->set_pixel_color(iter.first.x, iter.first.y, iter.second.second);
 		img->update_subtexture(bbox.x1, bbox.y1, bbox.x2 - bbox.x1 + 1, bbox.y2 - bbox.y1 + 1);
 	}
 }
@@ -3,6 +3,7 @@
 #include <array>
 
 #include "variety/History.h"
+#include "variety/PixelMap.h"
 #include "Image.h"
 #include "../color/Color.h"
 
@@ -74,8 +75,8 @@ struct PaintToolAction : public ActionBase
 {
 	std::weak_ptr<Image> image;
 	IntBounds bbox;
-	std::unordered_map<IPosition, std::pair<PixelRGBA, PixelRGBA>> painted_colors;
-	PaintToolAction(const std::shared_ptr<Image>& image, IntBounds bbox, std::unordered_map<IPosition, std::pair<PixelRGBA, PixelRGBA>>&& painted_colors);
+	PixelMap<std::pair<PixelRGBA, PixelRGBA>> painted_colors;
+	PaintToolAction(const std::shared_ptr<Image>& image, IntBounds bbox, PixelMap<std::pair<PixelRGBA, PixelRGBA>>&& painted_colors);
 	virtual void forward() override;
 	virtual void backward() override;
 };
@@ -85,8 +86,8 @@ struct OneColorPenAction : public ActionBase
 	std::weak_ptr<Image> image;
 	PixelRGBA color;
 	IntBounds bbox;
-	std::unordered_map<IPosition, PixelRGBA> painted_colors;
-	OneColorPenAction(const std::shared_ptr<Image>& image, PixelRGBA color, IPosition start, IPosition finish, std::unordered_map<IPosition, PixelRGBA>&& painted_colors);
+	PixelMap<PixelRGBA> painted_colors;
+	OneColorPenAction(const std::shared_ptr<Image>& image, PixelRGBA color, IPosition start, IPosition finish, PixelMap<PixelRGBA>&& painted_colors);
 	virtual void forward() override;
 	virtual void backward() override;
 };
@@ -95,8 +96,8 @@ struct OneColorPencilAction : public ActionBase
 {
 	std::weak_ptr<Image> image;
 	IntBounds bbox;
-	std::unordered_map<IPosition, std::pair<PixelRGBA, PixelRGBA>> painted_colors;
-	OneColorPencilAction(const std::shared_ptr<Image>& image, IPosition start, IPosition finish, std::unordered_map<IPosition, std::pair<PixelRGBA, PixelRGBA>>&& painted_colors);
+	PixelMap<std::pair<PixelRGBA, PixelRGBA>> painted_colors;
+	OneColorPencilAction(const std::shared_ptr<Image>& image, IPosition start, IPosition finish, PixelMap<std::pair<PixelRGBA, PixelRGBA>>&& painted_colors);
 	virtual void forward() override;
 	virtual void backward() override;
 };
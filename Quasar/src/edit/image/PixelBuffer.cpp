@@ -1,6 +1,7 @@
 #include "PixelBuffer.h"
 
 #include <memory>
+#include <cstring>
 
 #include "PixelBufferPaths.h"
 
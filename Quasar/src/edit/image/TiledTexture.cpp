@@ -0,0 +1,236 @@
+#include "TiledTexture.h"
+
+#include "variety/GLutility.h"
+#include "variety/Profiler.h"
+
+static bool transparent(const Buffer& buf, IntRect rect)
+{
+	for (Dim y = rect.y; y < rect.y + rect.h; ++y)
+	{
+		const Byte* row = buf.pos(rect.x, y);
+		for (Dim x = 0; x < rect.w; ++x)
+		{
+			if (row[4 * x + 3])
+				return false;
+		}
+	}
+	return true;
+}
+
+static bool samples_mipmaps(MinFilter filter)
+{
+	return filter != MinFilter::Nearest && filter != MinFilter::Linear;
+}
+
+// Levels a tile can have before its smaller dimension reaches 1.
+static int max_tile_levels(IntRect rect)
+{
+	int levels = 1;
+	for (int dim = std::min(rect.w, rect.h); dim > 1; dim >>= 1)
+		++levels;
+	return levels;
+}
+
+static IntRect level_rect(IntRect rect, int k)
+{
+	return { rect.x >> k, rect.y >> k, rect.w >> k, rect.h >> k };
+}
+
+// Pixels of level k that average any pixel of rect.
+static IntRect level_cover(IntRect rect, int k)
+{
+	int x1 = rect.x >> k, y1 = rect.y >> k;
+	int x2 = (rect.x + rect.w + (1 << k) - 1) >> k, y2 = (rect.y + rect.h + (1 << k) - 1) >> k;
+	return { x1, y1, x2 - x1, y2 - y1 };
+}
+
+static bool overlap(IntRect a, IntRect b, IntRect& result)
+{
+	return a.intersect(b, result) && result.w > 0 && result.h > 0;
+}
+
+static IntRect bounding(IntRect a, IntRect b)
+{
+	if (a.w <= 0 || a.h <= 0)
+		return b;
+	int x1 = std::min(a.x, b.x), y1 = std::min(a.y, b.y);
+	int x2 = std::max(a.x + a.w, b.x + b.w), y2 = std::max(a.y + a.h, b.y + b.h);
+	return { x1, y1, x2 - x1, y2 - y1 };
+}
+
+TiledTexture::~TiledTexture()
+{
+	clear();
+}
+
+void TiledTexture::clear()
+{
+	for (const Tile& tile : tiles)
+	{
+		if (tile.tid)
+			delete_texture(tile.tid);
+	}
+	tiles.clear();
+	cols = 0;
+	rows = 0;
+	width = 0;
+	height = 0;
+	chpp = 0;
+	mips.clear();
+}
+
+void TiledTexture::resend(const Buffer& buf, bool indexed_)
+{
+	QUASAR_PROFILE("texture upload");
+	clear();
+	indexed = indexed_;
+	width = buf.width;
+	height = buf.height;
+	chpp = buf.chpp;
+	cols = (width + TILE_SIZE - 1) / TILE_SIZE;
+	rows = (height + TILE_SIZE - 1) / TILE_SIZE;
+	tiles.resize(size_t(cols) * rows);
+	if (mipmapped())
+		mips.build(buf, max_tile_levels({ 0, 0, TILE_SIZE, TILE_SIZE }));
+	for (int r = 0; r < rows; ++r)
+	{
+		for (int c = 0; c < cols; ++c)
+		{
+			Tile& tile = tiles[c + r * cols];
+			tile.rect = { c * TILE_SIZE, r * TILE_SIZE, std::min(TILE_SIZE, width - c * TILE_SIZE), std::min(TILE_SIZE, height - r * TILE_SIZE) };
+			if (is_visible(tile))
+				refresh(buf, tile, tile.rect);
+			else
+				tile.pending = tile.rect;
+		}
+	}
+}
+
+void TiledTexture::update(const Buffer& buf, IntRect rect)
+{
+	if (buf.width != width || buf.height != height || buf.chpp != chpp)
+	{
+		resend(buf, indexed);
+		return;
+	}
+	if (!overlap({ 0, 0, width, height }, rect, rect))
+		return;
+	QUASAR_PROFILE("texture upload");
+	if (mipmapped())
+		mips.update(buf, rect, level_rects);
+	for (int r = rect.y / TILE_SIZE; r <= (rect.y + rect.h - 1) / TILE_SIZE; ++r)
+	{
+		for (int c = rect.x / TILE_SIZE; c <= (rect.x + rect.w - 1) / TILE_SIZE; ++c)
+		{
+			Tile& tile = tiles[c + r * cols];
+			IntRect part;
+			if (!overlap(tile.rect, rect, part))
+				continue;
+			if (is_visible(tile))
+				refresh(buf, tile, part);
+			else
+				tile.pending = bounding(tile.pending, part);
+		}
+	}
+}
+
+void TiledTexture::set_visible(const Buffer& buf, IntRect visible_)
+{
+	if (culling && visible == visible_)
+		return;
+	culling = true;
+	visible = visible_;
+	if (buf.width != width || buf.height != height || buf.chpp != chpp)
+		return; // the next update resends
+	for (Tile& tile : tiles)
+	{
+		if (tile.pending.w > 0 && is_visible(tile))
+		{
+			QUASAR_PROFILE("texture upload");
+			refresh(buf, tile, tile.pending);
+			tile.pending = {};
+		}
+	}
+}
+
+bool TiledTexture::is_visible(const Tile& tile) const
+{
+	IntRect part;
+	return !culling || overlap(tile.rect, visible, part);
+}
+
+// Uploads the part of the tile that changed, allocating the tile's texture if it had none.
+void TiledTexture::refresh(const Buffer& buf, Tile& tile, IntRect part) const
+{
+	if (tile.tid)
+	{
+		IntRect level_part;
+		for (int k = 0; k < tile.levels; ++k)
+		{
+			if (overlap(level_rect(tile.rect, k), level_cover(part, k), level_part))
+				upload(mips.level(buf, k), tile, k, level_part);
+		}
+	}
+	else if (!skips_transparent() || !transparent(buf, part))
+	{
+		allocate(buf, tile);
+		upload_all_levels(buf, tile);
+	}
+}
+
+void TiledTexture::set_params(const Buffer& buf, const TextureParams& params_)
+{
+	bool was_mipmapped = mipmapped();
+	params = params_;
+	if (was_mipmapped != mipmapped() && !tiles.empty())
+	{
+		resend(buf, indexed);
+		return;
+	}
+	for (const Tile& tile : tiles)
+	{
+		if (tile.tid)
+		{
+			bind_texture(tile.tid);
+			bind_texture_params(sampling_params());
+		}
+	}
+}
+
+bool TiledTexture::mipmapped() const
+{
+	return !indexed && samples_mipmaps(params.min_filter);
+}
+
+TextureParams TiledTexture::sampling_params() const
+{
+	// palette indexes can't be interpolated
+	return indexed ? TextureParams{} : params;
+}
+
+void TiledTexture::allocate(const Buffer& buf, Tile& tile) const
+{
+	QUASAR_GL(glGenTextures(1, &tile.tid));
+	bind_texture(tile.tid);
+	tile.levels = mipmapped() ? std::min(mips.num_levels(), max_tile_levels(tile.rect)) : 1;
+	for (int k = 0; k < tile.levels; ++k)
+		QUASAR_GL(glTexImage2D(GL_TEXTURE_2D, k, chpp_internal_format(buf.chpp), tile.rect.w >> k, tile.rect.h >> k, 0, chpp_format(buf.chpp), GL_UNSIGNED_BYTE, nullptr));
+	QUASAR_GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, tile.levels - 1));
+	bind_texture_params(sampling_params());
+}
+
+void TiledTexture::upload_all_levels(const Buffer& buf, const Tile& tile) const
+{
+	for (int k = 0; k < tile.levels; ++k)
+		upload(mips.level(buf, k), tile, k, level_rect(tile.rect, k));
+}
+
+// rect is in the pixels of level k.
+void TiledTexture::upload(const Buffer& level, const Tile& tile, int k, IntRect rect) const
+{
+	bind_texture(tile.tid);
+	QUASAR_GL(glPixelStorei(GL_UNPACK_ALIGNMENT, chpp_alignment(level.chpp)));
+	QUASAR_GL(glPixelStorei(GL_UNPACK_ROW_LENGTH, level.width));
+	QUASAR_GL(glTexSubImage2D(GL_TEXTURE_2D, k, rect.x - (tile.rect.x >> k), rect.y - (tile.rect.y >> k), rect.w, rect.h, chpp_format(level.chpp), GL_UNSIGNED_BYTE, level.pos(rect.x, rect.y)));
+	QUASAR_GL(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
+}
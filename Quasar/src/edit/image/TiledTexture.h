@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vector>
+
+#include "Image.h"
+#include "MipPyramid.h"
+#include "variety/Geometry.h"
+
+// GPU storage of a buffer as a grid of textures, TILE_SIZE pixels on a side except along the right and top edges, so that images beyond
+// GL_MAX_TEXTURE_SIZE can be displayed, and an edit only re-uploads the tiles it touches. The pixels stay in the image's contiguous buffer.
+// Tiles of RGBA buffers whose pixels all have zero alpha get no texture until something is drawn on them, and aren't drawn.
+// If the min filter samples mipmaps, the levels are taken from a MipPyramid over the whole buffer, which an edit updates and re-uploads
+// only where it covers. Indexed buffers are never tiled transparent or mipmapped, and are always sampled nearest.
+// Once given a visible region, tiles outside it are neither uploaded nor drawn. Their edits accumulate until they scroll into view.
+class TiledTexture
+{
+public:
+	static constexpr int TILE_SIZE = 512;
+
+	struct Tile
+	{
+		GLuint tid = 0;
+		IntRect rect; // pixels of the buffer
+		int levels = 1;
+		IntRect pending; // edits not uploaded yet, while the tile was off-screen
+	};
+
+private:
+	std::vector<Tile> tiles; // row-major, from the bottom left
+	int cols = 0;
+	int rows = 0;
+	Dim width = 0;
+	Dim height = 0;
+	CHPP chpp = 0;
+	TextureParams params;
+	bool indexed = false;
+	MipPyramid mips;
+	std::vector<IntRect> level_rects; // scratch for mips.update()
+	bool culling = false;
+	IntRect visible;
+
+public:
+	TiledTexture(const TextureParams& params) : params(params) {}
+	TiledTexture(const TiledTexture&) = delete;
+	TiledTexture(TiledTexture&&) noexcept = delete;
+	~TiledTexture();
+
+	// Rebuilds the grid to the buffer's dimensions and format, and uploads every tile.
+	void resend(const Buffer& buf, bool indexed);
+	// Uploads the part of rect that lies in each tile it overlaps. Tiles without a texture are uploaded whole once they have visible pixels.
+	// Resends everything if the buffer's dimensions or format changed.
+	void update(const Buffer& buf, IntRect rect);
+	// Resends everything if switching between sampled and unsampled mipmaps.
+	void set_params(const Buffer& buf, const TextureParams& params);
+	// Uploads the pending edits of tiles that visible now overlaps.
+	void set_visible(const Buffer& buf, IntRect visible);
+
+	const std::vector<Tile>& get_tiles() const { return tiles; }
+	bool is_visible(const Tile& tile) const;
+
+private:
+	bool skips_transparent() const { return !indexed && chpp == 4; }
+	bool mipmapped() const;
+	TextureParams sampling_params() const;
+	void clear();
+	void refresh(const Buffer& buf, Tile& tile, IntRect part) const;
+	void allocate(const Buffer& buf, Tile& tile) const;
+	void upload_all_levels(const Buffer& buf, const Tile& tile) const;
+	void upload(const Buffer& level, const Tile& tile, int k, IntRect rect) const;
+};
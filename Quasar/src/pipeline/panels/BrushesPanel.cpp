@@ -4,7 +4,6 @@
 
 #include <ImplUtility.h>
 #include "edit/color/Color.h"
-#include "../render/Uniforms.h"
 #include "variety/GLutility.h"
 #include "user/Machine.h"
 #include "Easel.h"
@@ -225,9 +224,6 @@ void BrushesPanel::draw()
 void BrushesPanel::_send_view()
 {
 	vp = vp_matrix();
-	Uniforms::send_matrix3(bkg_shader, "u_VP", vp);
-	Uniforms::send_matrix3(round_rect_shader, "u_VP", vp);
-	unbind_shader();
 	sync_widget();
 }
 
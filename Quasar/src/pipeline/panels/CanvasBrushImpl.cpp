@@ -35,6 +35,8 @@ static void standard_outline_brush_pencil(Canvas& canvas, int x, int y, Discrete
 
 	interp.finish = { x, y };
 	interp.sync_with_endpoints();
+	if (update_storage)
+		binfo.storage_2c.reserve(interp.length);
 	auto looperand = update_storage ? &_standard_outline_brush_pencil_looperand_update_storage : &_standard_outline_brush_pencil_looperand_dont_update_storage;
 	for (unsigned int i = 0; i < interp.length; ++i)
 	{
@@ -71,6 +73,8 @@ static void standard_outline_brush_pen(Canvas& canvas, int x, int y, DiscreteInt
 
 	interp.finish = { x, y };
 	interp.sync_with_endpoints();
+	if (update_storage)
+		binfo.storage_1c.reserve(interp.length);
 	auto looperand = update_storage ? &_standard_outline_brush_pen_looperand_update_storage : &_standard_outline_brush_pen_looperand_dont_update_storage;
 	for (unsigned int i = 0; i < interp.length; ++i)
 	{
@@ -107,6 +111,8 @@ static void standard_outline_brush_eraser(Canvas& canvas, int x, int y, Discrete
 
 	interp.finish = { x, y };
 	interp.sync_with_endpoints();
+	if (update_storage)
+		binfo.storage_1c.reserve(interp.length);
 	auto looperand = update_storage ? &_standard_outline_brush_eraser_looperand_update_storage : &_standard_outline_brush_eraser_looperand_dont_update_storage;
 	for (unsigned int i = 0; i < interp.length; ++i)
 	{
@@ -132,6 +138,7 @@ static void standard_submit_filled_pencil(Canvas& canvas, DiscreteInterpolator&
 		interp.start = binfo.starting_pos;
 		interp.finish = binfo.last_brush_pos;
 		interp.sync_with_endpoints();
+		binfo.storage_2c.reserve(abs_bounds(interp.start, interp.finish));
 		IPosition pos{};
 		for (unsigned int i = 0; i < interp.length; ++i)
 		{
@@ -162,6 +169,7 @@ static void standard_submit_filled_pen(Canvas& canvas, DiscreteInterpolator& int
 		interp.start = binfo.starting_pos;
 		interp.finish = binfo.last_brush_pos;
 		interp.sync_with_endpoints();
+		binfo.storage_1c.reserve(abs_bounds(interp.start, interp.finish));
 		IPosition pos{};
 		for (unsigned int i = 0; i < interp.length; ++i)
 		{
@@ -189,6 +197,7 @@ static void standard_submit_filled_eraser(Canvas& canvas, DiscreteInterpolator&
 		interp.start = binfo.starting_pos;
 		interp.finish = binfo.last_brush_pos;
 		interp.sync_with_endpoints();
+		binfo.storage_1c.reserve(abs_bounds(interp.start, interp.finish));
 		IPosition pos{};
 		for (unsigned int i = 0; i < interp.length; ++i)
 		{
@@ -221,12 +230,9 @@ void CBImpl::Camera::brush(Canvas& canvas, int x, int y)
 // <<<==================================<<< PAINT >>>==================================>>>
 // LATER Paint should use standard submission techniques specific to pencil, pen, and eraser, in the exact same way as Line, RectFill, RectOutline, etc.
 
-static Buffer paint_brush_prefix(Canvas& canvas, int x, int y)
+static void paint_brush_prefix(Canvas& canvas, int x, int y)
 {
 	BrushInfo& binfo = canvas.binfo;
-	Buffer image_shifted_buf = canvas.image->buf;
-	image_shifted_buf.pixels += image_shifted_buf.byte_offset(x, y);
-	
 	if (x < binfo.brushing_bbox.x1)
 		binfo.brushing_bbox.x1 = x;
 	if (x > binfo.brushing_bbox.x2)
@@ -235,12 +241,12 @@ static Buffer paint_brush_prefix(Canvas& canvas, int x, int y)
 		binfo.brushing_bbox.y1 = y;
 	if (y > binfo.brushing_bbox.y2)
 		binfo.brushing_bbox.y2 = y;
-
-	return image_shifted_buf;
 }
 
-static void paint_brush_suffix(Canvas& canvas, int x, int y, PixelRGBA initial_c, PixelRGBA final_c)
+// The final color is read back from the image, since indexed images store the nearest palette entry rather than the color painted.
+static void paint_brush_suffix(Canvas& canvas, int x, int y, PixelRGBA initial_c)
 {
+	PixelRGBA final_c = canvas.pixel_color_at(x, y);
 	canvas.image->update_subtexture(x, y, 1, 1);
 	auto iter = canvas.binfo.storage_2c.find({ x, y });
 	if (iter == canvas.binfo.storage_2c.end())
@@ -251,51 +257,37 @@ static void paint_brush_suffix(Canvas& canvas, int x, int y, PixelRGBA initial_c
 
 void CBImpl::Paint::brush_pencil(Canvas& canvas, int x, int y)
 {
-	BrushInfo& binfo = canvas.binfo;
-	Buffer image_shifted_buf = paint_brush_prefix(canvas, x, y);
-	PixelRGBA initial_c{ 0, 0, 0, 0 };
-	PixelRGBA final_c{ 0, 0, 0, 0 };
+	paint_brush_prefix(canvas, x, y);
+	PixelRGBA initial_c = canvas.pixel_color_at(x, y);
+	PixelRGBA blended_c{ 0, 0, 0, 0 };
 	PixelRGBA color = canvas.cursor_state == Canvas::CursorState::DOWN_PRIMARY ? canvas.pric_pxs : canvas.altc_pxs;
 	float applied_alpha = canvas.applied_color().alpha;
-	for (CHPP i = 0; i < image_shifted_buf.chpp; ++i)
+	for (CHPP i = 0; i < 4; ++i)
 	{
-		initial_c.at(i) = image_shifted_buf.pixels[i];
 		if (i < 3)
-			image_shifted_buf.pixels[i] = std::clamp(roundi(color[i] * applied_alpha + image_shifted_buf.pixels[i] * (1 - applied_alpha)), 0, 255);
+			blended_c.at(i) = std::clamp(roundi(color[i] * applied_alpha + initial_c[i] * (1 - applied_alpha)), 0, 255);
 		else
-			image_shifted_buf.pixels[i] = std::clamp(roundi(applied_alpha * 255 + image_shifted_buf.pixels[i] * (1 - applied_alpha)), 0, 255);
-		final_c.at(i) = image_shifted_buf.pixels[i];
+			blended_c.at(i) = std::clamp(roundi(applied_alpha * 255 + initial_c[i] * (1 - applied_alpha)), 0, 255);
 	}
-	paint_brush_suffix(canvas, x, y, initial_c, final_c);
+	canvas.image->set_pixel_color(x, y, blended_c);
+	paint_brush_suffix(canvas, x, y, initial_c);
 }
 
 void CBImpl::Paint::brush_pen(Canvas& canvas, int x, int y)
 {
-	BrushInfo& binfo = canvas.binfo;
-	Buffer image_shifted_buf = paint_brush_prefix(canvas, x, y);
-	PixelRGBA initial_c{ 0, 0, 0, 0 };
+	paint_brush_prefix(canvas, x, y);
+	PixelRGBA initial_c = canvas.pixel_color_at(x, y);
 	PixelRGBA color = canvas.cursor_state == Canvas::CursorState::DOWN_PRIMARY ? canvas.pric_pen_pxs : canvas.altc_pen_pxs;
-	for (CHPP i = 0; i < image_shifted_buf.chpp; ++i)
-	{
-		initial_c.at(i) = image_shifted_buf.pixels[i];
-		image_shifted_buf.pixels[i] = color[i];
-	}
-	paint_brush_suffix(canvas, x, y, initial_c, color);
+	canvas.image->set_pixel_color(x, y, color);
+	paint_brush_suffix(canvas, x, y, initial_c);
 }
 
 void CBImpl::Paint::brush_eraser(Canvas& canvas, int x, int y)
 {
-	BrushInfo& binfo = canvas.binfo;
-	Buffer image_shifted_buf = paint_brush_prefix(canvas, x, y);
-	PixelRGBA initial_c{ 0, 0, 0, 0 };
-	PixelRGBA final_c{ 0, 0, 0, 0 };
-	// LATER define more utilities for these sorts of things, like swap/get/set.
-	for (CHPP i = 0; i < image_shifted_buf.chpp; ++i)
-	{
-		initial_c.at(i) = image_shifted_buf.pixels[i];
-		image_shifted_buf.pixels[i] = 0;
-	}
-	paint_brush_suffix(canvas, x, y, initial_c, final_c);
+	paint_brush_prefix(canvas, x, y);
+	PixelRGBA initial_c = canvas.pixel_color_at(x, y);
+	canvas.image->set_pixel_color(x, y, PixelRGBA{ 0, 0, 0, 0 });
+	paint_brush_suffix(canvas, x, y, initial_c);
 }
 
 void CBImpl::Paint::brush_select(Canvas& canvas, int x, int y)
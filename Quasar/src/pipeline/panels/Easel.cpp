@@ -8,7 +8,6 @@
 #include "user/Machine.h"
 #include "BrushesPanel.h"
 #include "Palette.h"
-#include "../render/Uniforms.h"
 #include "../render/FlatSprite.h"
 
 constexpr GLuint CHECKERBOARD_TSLOT = 0;
@@ -16,9 +15,15 @@ constexpr GLuint CURSOR_ERASER_TSLOT = 1;
 constexpr GLuint CURSOR_SELECT_TSLOT = 2;
 constexpr GLuint BRUSH_PREVIEW_TSLOT = 3;
 constexpr GLuint CANVAS_SPRITE_TSLOT = 4;
+constexpr GLuint CANVAS_PALETTE_TSLOT = 5;
+
+// Magnified pixels stay sharp, while zooming out averages them instead of dropping most. Indexed images ignore this and sample nearest.
+static const TextureParams CANVAS_TEXTURE_PARAMS = { MinFilter::LinearMipmapLinear, MagFilter::Nearest };
 
 Canvas::Canvas(Shader* cursor_shader)
 	: sprite_shader(FileSystem::shader_path("flatsprite.vert"), FileSystem::shader_path("flatsprite.frag.tmpl"), { { "$NUM_TEXTURE_SLOTS", std::to_string(GLC.max_texture_image_units) } }),
+	indexed_sprite_shader(FileSystem::shader_path("flatsprite.vert"), FileSystem::shader_path("flatsprite_indexed.frag.tmpl"),
+		{ { "$NUM_TEXTURE_SLOTS", std::to_string(GLC.max_texture_image_units) }, { "$PALETTE_TEXTURE_SLOT", std::to_string(CANVAS_PALETTE_TSLOT) } }),
 	Widget(_W_COUNT), brush_under_tool_and_tip(&CBImpl::Camera::brush), eraser_cursor_img(std::make_shared<Image>())
 {
 	binfo.preview_image = std::make_shared<Image>();
@@ -47,6 +52,8 @@ void Canvas::initialize_widget(Shader* cursor_shader)
 	fs_wget(*this, CURSOR_SELECT).set_texture_slot(CURSOR_SELECT_TSLOT).image = std::make_shared<Image>(FileSystem::texture_path("select.png"));
 	assign_widget(this, BRUSH_PREVIEW, std::make_shared<FlatSprite>(&sprite_shader));
 	fs_wget(*this, BRUSH_PREVIEW).set_texture_slot(BRUSH_PREVIEW_TSLOT).image = binfo.preview_image;
+	assign_widget(this, INDEXED_SPRITE, std::make_shared<FlatSprite>(&indexed_sprite_shader));
+	fs_wget(*this, INDEXED_SPRITE).set_texture_slot(CANVAS_SPRITE_TSLOT);
 	assign_widget(this, SPRITE, std::make_shared<FlatSprite>(&sprite_shader));
 	fs_wget(*this, SPRITE).set_texture_slot(CANVAS_SPRITE_TSLOT);
 }
@@ -96,10 +103,15 @@ void Canvas::initialize_eraser_cursor_img()
 
 void Canvas::draw()
 {
-	fs_wget(*this, CHECKERBOARD).draw(CHECKERBOARD_TSLOT);
-	fs_wget(*this, SPRITE).draw(CANVAS_SPRITE_TSLOT);
+	// Layers keep the stacking order. Quads with the same shader and no clashing texture slots share a draw call.
+	fs_wget(*this, CHECKERBOARD).submit(sprite_batch, CHECKERBOARD_TSLOT, 0);
+	if (image && image->indexed())
+		fs_wget(*this, INDEXED_SPRITE).submit(sprite_batch, CANVAS_SPRITE_TSLOT, 1, { CANVAS_PALETTE_TSLOT, image->palette->texture() });
+	else
+		fs_wget(*this, SPRITE).submit(sprite_batch, CANVAS_SPRITE_TSLOT, 1);
 	if (binfo.show_preview)
-		fs_wget(*this, BRUSH_PREVIEW).draw(BRUSH_PREVIEW_TSLOT);
+		fs_wget(*this, BRUSH_PREVIEW).submit(sprite_batch, BRUSH_PREVIEW_TSLOT, 2);
+	sprite_batch.flush();
 	minor_gridlines.draw();
 	major_gridlines.draw();
 	if (cursor_in_canvas)
@@ -114,24 +126,19 @@ void Canvas::draw_cursor()
 	switch (binfo.tip)
 	{
 	case BrushTip::PENCIL:
-		ur_wget(*this, CURSOR_PENCIL).draw();
+		get<W_UnitRenderable>(CURSOR_PENCIL)->submit(sprite_batch, 0);
 		break;
 	case BrushTip::PEN:
-		ur_wget(*this, CURSOR_PEN).draw();
+		get<W_UnitRenderable>(CURSOR_PEN)->submit(sprite_batch, 0);
 		break;
 	case BrushTip::ERASER:
-		fs_wget(*this, CURSOR_ERASER).draw(CURSOR_ERASER_TSLOT);
+		fs_wget(*this, CURSOR_ERASER).submit(sprite_batch, CURSOR_ERASER_TSLOT, 0);
 		break;
 	case BrushTip::SELECT:
-		fs_wget(*this, CURSOR_SELECT).draw(CURSOR_SELECT_TSLOT);
+		fs_wget(*this, CURSOR_SELECT).submit(sprite_batch, CURSOR_SELECT_TSLOT, 0);
 		break;
 	}
-}
-
-void Canvas::send_vp(const glm::mat3& vp)
-{
-	Uniforms::send_matrix3(sprite_shader, "u_VP", vp);
-	sync_cursor_with_widget();
+	sprite_batch.flush();
 }
 
 void Canvas::sync_cursor_with_widget()
@@ -150,14 +157,20 @@ void Canvas::sync_ur(size_t subw)
 void Canvas::set_image(const std::shared_ptr<Image>& img)
 {
 	fs_wget(*this, SPRITE).image = img;
+	fs_wget(*this, INDEXED_SPRITE).image = img;
 	image = img;
+	if (image)
+		image->gen_tiled_texture(CANVAS_TEXTURE_PARAMS);
 	sync_gfx_with_image();
 }
 
 void Canvas::set_image(std::shared_ptr<Image>&& img)
 {
 	fs_wget(*this, SPRITE).image = img;
+	fs_wget(*this, INDEXED_SPRITE).image = img;
 	image = std::move(img);
+	if (image)
+		image->gen_tiled_texture(CANVAS_TEXTURE_PARAMS);
 	sync_gfx_with_image();
 }
 
@@ -165,9 +178,12 @@ void Canvas::sync_sprite_with_image()
 {
 	if (image)
 	{
-		FlatSprite& sprite = fs_wget(*this, SPRITE);
-		sprite.self.transform.scale = { image->buf.width, image->buf.height };
-		sprite.update_transform();
+		for (size_t subw : { INDEXED_SPRITE, SPRITE })
+		{
+			FlatSprite& sprite = fs_wget(*this, subw);
+			sprite.self.transform.scale = { image->buf.width, image->buf.height };
+			sprite.update_transform();
+		}
 	}
 }
 
@@ -175,8 +191,14 @@ void Canvas::sync_checkerboard_with_image()
 {
 	if (image)
 	{
-		set_checkerboard_uv_size(0.5f * image->buf.width * checker_size_inv.x, 0.5f * image->buf.height * checker_size_inv.y);
-		fs_wget(*this, CHECKERBOARD).self.transform.scale = { image->buf.width, image->buf.height };
+		// Only covers the visible region, with UVs that keep the checkers anchored to the image's corner.
+		IntRect region;
+		if (!visible_region.intersect({ 0, 0, image->buf.width, image->buf.height }, region))
+			region = {};
+		set_checkerboard_uvs(Bounds{ 0.5f * region.x * checker_size_inv.x, 0.5f * (region.x + region.w) * checker_size_inv.x,
+			0.5f * region.y * checker_size_inv.y, 0.5f * (region.y + region.h) * checker_size_inv.y });
+		fs_wget(*this, CHECKERBOARD).self.transform.position = Position(region.x + 0.5f * region.w, region.y + 0.5f * region.h) - 0.5f * Position(image->buf.width, image->buf.height);
+		fs_wget(*this, CHECKERBOARD).self.transform.scale = { region.w, region.h };
 		fs_wget(*this, CHECKERBOARD).update_transform().set_modulation(ColorFrame()).ur->send_buffer();
 	}
 	else
@@ -187,24 +209,29 @@ void Canvas::sync_brush_preview_with_image()
 {
 	if (image)
 	{
+		// The previews are RGBA whatever the canvas format, since indexed canvases paint their previews in direct colour.
 		Buffer& pbuf = binfo.preview_image->buf;
-		if (!pbuf.same_dimensions_as(image->buf))
+		if (pbuf.width != image->buf.width || pbuf.height != image->buf.height || pbuf.chpp != 4)
 		{
 			delete[] pbuf.pixels;
-			pbuf = image->buf;
+			pbuf = {};
+			pbuf.width = image->buf.width;
+			pbuf.height = image->buf.height;
+			pbuf.chpp = 4;
 			pbuf.pxnew();
 		}
 		memset(pbuf.pixels, 0, pbuf.bytes());
-		binfo.preview_image->gen_texture();
+		binfo.preview_image->gen_tiled_texture();
 		binfo.preview_image->resend_texture();
 
 		Buffer& ebuf = binfo.eraser_preview_image->buf;
-		if (!ebuf.same_dimensions_as(image->buf))
+		if (ebuf.width != BrushInfo::eraser_preview_img_sx * image->buf.width || ebuf.height != BrushInfo::eraser_preview_img_sy * image->buf.height || ebuf.chpp != 4)
 		{
 			delete[] ebuf.pixels;
-			ebuf = image->buf;
-			ebuf.width *= BrushInfo::eraser_preview_img_sx;
-			ebuf.height *= BrushInfo::eraser_preview_img_sy;
+			ebuf = {};
+			ebuf.width = BrushInfo::eraser_preview_img_sx * image->buf.width;
+			ebuf.height = BrushInfo::eraser_preview_img_sy * image->buf.height;
+			ebuf.chpp = 4;
 			ebuf.pxnew();
 		}
 		static const Byte eraser_preview_arr[BrushInfo::eraser_preview_img_sx * BrushInfo::eraser_preview_img_sy * 4] = {
@@ -216,7 +243,7 @@ void Canvas::sync_brush_preview_with_image()
 				for (Dim h = 0; h < BrushInfo::eraser_preview_img_sy; ++h)
 					memcpy(ebuf.pos(BrushInfo::eraser_preview_img_sx * x, BrushInfo::eraser_preview_img_sy * y + h),
 						eraser_preview_arr + h * BrushInfo::eraser_preview_img_sx * 4, BrushInfo::eraser_preview_img_sx * 4);
-		binfo.eraser_preview_image->gen_texture();
+		binfo.eraser_preview_image->gen_tiled_texture();
 		binfo.eraser_preview_image->resend_texture();
 
 		fs_wget(*this, BRUSH_PREVIEW).self.transform.scale = { image->buf.width, image->buf.height };
@@ -237,6 +264,7 @@ void Canvas::sync_transform()
 {
 	fs_wget(*this, CHECKERBOARD).update_transform().ur->send_buffer();
 	fs_wget(*this, BRUSH_PREVIEW).update_transform().ur->send_buffer();
+	fs_wget(*this, INDEXED_SPRITE).update_transform().ur->send_buffer();
 	fs_wget(*this, SPRITE).update_transform().ur->send_buffer();
 	sync_cursor_with_widget();
 }
@@ -250,6 +278,20 @@ void Canvas::sync_gfx_with_image()
 	sync_transform();
 }
 
+void Canvas::set_visible_region(IntRect region)
+{
+	if (!image)
+		return;
+	image->set_visible_region(region);
+	binfo.preview_image->set_visible_region(region);
+	binfo.eraser_preview_image->set_visible_region(region.scaled(BrushInfo::eraser_preview_img_sx, BrushInfo::eraser_preview_img_sy));
+	if (region != visible_region)
+	{
+		visible_region = region;
+		sync_checkerboard_with_image();
+	}
+}
+
 void Canvas::create_checkerboard_image()
 {
 	auto img = std::make_shared<Image>();
@@ -261,7 +303,7 @@ void Canvas::create_checkerboard_image()
 	wp_at(CHECKERBOARD).transform.scale = { img->buf.width, img->buf.height };
 	fs_wget(*this, CHECKERBOARD).image = std::move(img);
 	fs_wget(*this, CHECKERBOARD).update_transform();
-	set_checkerboard_uv_size(0, 0);
+	set_checkerboard_uvs(Bounds{ 0, 0, 0, 0 });
 }
 
 void Canvas::sync_checkerboard_colors() const
@@ -300,15 +342,15 @@ void Canvas::sync_checkerboard_texture() const
 	}
 }
 
-void Canvas::set_checkerboard_uv_size(float width, float height) const
+void Canvas::set_checkerboard_uvs(Bounds uvs) const
 {
-	fs_wget(*this, CHECKERBOARD).set_uvs(Bounds{ 0.0f, width, 0.0f, height });
+	fs_wget(*this, CHECKERBOARD).set_uvs(uvs);
 }
 
 void Canvas::set_checker_size(glm::ivec2 checker_size)
 {
 	checker_size_inv = { 1.0f / checker_size.x, 1.0f / checker_size.y };
-	major_gridlines.line_spacing = checker_size;
+	major_gridlines.set_line_spacing(checker_size);
 }
 
 void Canvas::update_brush_tool_and_tip()
@@ -472,12 +514,7 @@ RGBA Canvas::applied_color() const
 
 RGBA Canvas::color_under_cursor() const
 {
-	IPosition pos = brush_pos_under_cursor();
-	Byte* pixel = image->buf.pos(pos.x, pos.y);
-	PixelRGBA px{ 255, 255, 255, 255 };
-	for (CHPP i = 0; i < image->buf.chpp; ++i)
-		px.at(i) = pixel[i];
-	return px.to_rgba();
+	return pixel_color_at(brush_pos_under_cursor()).to_rgba();
 }
 
 PixelRGBA Canvas::pixel_color_at(IPosition pos) const
@@ -487,11 +524,7 @@ PixelRGBA Canvas::pixel_color_at(IPosition pos) const
 
 PixelRGBA Canvas::pixel_color_at(int x, int y) const
 {
-	Byte* pixel = image->buf.pos(x, y);
-	PixelRGBA px{ 255, 255, 255, 255 };
-	for (CHPP i = 0; i < image->buf.chpp; ++i)
-		px.at(i) = pixel[i];
-	return px;
+	return image->pixel_color_at(x, y);
 }
 
 void Canvas::set_cursor_color(RGBA color)
@@ -536,7 +569,7 @@ void Canvas::cursor_press(MouseButton button)
 				MPalette->set_alt_color(color_under_cursor());
 		}
 	}
-	else
+	else if (!MEasel->filter_preview.active) // strokes would land on preview pixels, which are overwritten when the filter is applied or cancelled
 	{
 		bool begin = false;
 		if (button == MouseButton::LEFT && cursor_state != CursorState::DOWN_ALTERNATE)
@@ -567,6 +600,18 @@ void Canvas::cursor_release(MouseButton button)
 	}
 }
 
+bool Canvas::cursor_submit()
+{
+	if (cursor_state != CursorState::UP)
+	{
+		brush_submit();
+		cursor_state = CursorState::UP;
+		set_cursor_color(primary_color);
+		return true;
+	}
+	return false;
+}
+
 bool Canvas::cursor_cancel()
 {
 	if (cursor_state != CursorState::UP)
@@ -840,23 +885,26 @@ void Easel::draw()
 	ur_wget(widget, BACKGROUND).draw();
 	Canvas& cnvs = canvas();
 	if (cnvs.visible)
+	{
+		cnvs.set_visible_region(visible_image_rect());
 		cnvs.draw();
+	}
 }
 
 void Easel::_send_view()
 {
 	vp = vp_matrix();
-	canvas().send_vp(vp);
-	Uniforms::send_matrix3(color_square_shader, "u_VP", vp);
-	Uniforms::send_matrix3(canvas().minor_gridlines.shader, "u_VP", vp);
-	Uniforms::send_matrix3(canvas().major_gridlines.shader, "u_VP", vp);
-	unbind_shader();
 	sync_widget();
 }
 
 void Easel::process()
 {
 	update_panning();
+	if (Image* img = canvas_image())
+	{
+		if (img->indexed())
+			img->palette->sync();
+	}
 	if (cursor_in_clipping())
 		canvas().hover_pixel_under_cursor();
 	else
@@ -877,6 +925,7 @@ void Easel::sync_ur(size_t subw)
 
 void Easel::sync_canvas_transform()
 {
+	mark_dirty();
 	canvas().sync_transform();
 	canvas().minor_gridlines.send_flat_transform(canvas().self.transform);
 	canvas().major_gridlines.send_flat_transform(canvas().self.transform);
@@ -900,6 +949,7 @@ bool Easel::minor_gridlines_are_visible() const
 void Easel::set_minor_gridlines_visibility(bool visible)
 {
 	canvas().minor_gridlines.set_visible(visible, canvas().self.transform, canvas().image->buf.width, canvas().image->buf.height);
+	mark_dirty();
 }
 
 bool Easel::major_gridlines_are_visible() const
@@ -910,6 +960,7 @@ bool Easel::major_gridlines_are_visible() const
 void Easel::set_major_gridlines_visibility(bool visible)
 {
 	canvas().major_gridlines.set_visible(visible, canvas().self.transform, canvas().image->buf.width, canvas().image->buf.height);
+	mark_dirty();
 }
 
 void Easel::begin_panning()
@@ -1015,6 +1066,7 @@ void Easel::reset_camera()
 
 void Easel::flip_image_horizontally()
 {
+	cancel_color_filter();
 	struct FlipHorizontallyAction : public ActionBase
 	{
 		Easel* easel;
@@ -1057,6 +1109,7 @@ void Easel::flip_image_horizontally()
 
 void Easel::flip_image_vertically()
 {
+	cancel_color_filter();
 	struct FlipVerticallyAction : public ActionBase
 	{
 		Easel* easel;
@@ -1099,6 +1152,7 @@ void Easel::flip_image_vertically()
 
 void Easel::rotate_image_90()
 {
+	cancel_color_filter();
 	struct Rotate90Action : public ActionBase
 	{
 		Easel* easel;
@@ -1139,6 +1193,7 @@ void Easel::rotate_image_90()
 
 void Easel::rotate_image_180()
 {
+	cancel_color_filter();
 	struct Rotate180Action : public ActionBase
 	{
 		Easel* easel;
@@ -1181,6 +1236,7 @@ void Easel::rotate_image_180()
 
 void Easel::rotate_image_270()
 {
+	cancel_color_filter();
 	struct Rotate270Action : public ActionBase
 	{
 		Easel* easel;
@@ -1218,3 +1274,277 @@ void Easel::rotate_image_270()
 	else
 		Machine.history.execute(std::make_shared<Rotate270Action>(this));
 }
+
+IntRect Easel::visible_image_rect() const
+{
+	const Image* img = canvas_image();
+	if (!img)
+		return {};
+	Position half_size = 0.5f * Position(img->buf.width, img->buf.height);
+	Position corners[4] = { Position(bounds.x1, bounds.y1), Position(bounds.x2, bounds.y1), Position(bounds.x1, bounds.y2), Position(bounds.x2, bounds.y2) };
+	float x1 = FLT_MAX, y1 = FLT_MAX, x2 = -FLT_MAX, y2 = -FLT_MAX;
+	for (Position corner : corners)
+	{
+		Position local = canvas().local_of(to_world_coordinates(corner)) + half_size;
+		x1 = std::min(x1, local.x);
+		x2 = std::max(x2, local.x);
+		y1 = std::min(y1, local.y);
+		y2 = std::max(y2, local.y);
+	}
+	IntRect visible{ floori(x1), floori(y1), floori(x2) - floori(x1) + 1, floori(y2) - floori(y1) + 1 };
+	IntRect clipped;
+	if (!visible.intersect({ 0, 0, img->buf.width, img->buf.height }, clipped) || clipped.w <= 0 || clipped.h <= 0)
+		return {};
+	return clipped;
+}
+
+bool Easel::filter_preview_valid()
+{
+	if (!filter_preview.active)
+		return false;
+	// The canvas image was replaced or resized underneath the preview, so the source no longer lines up with it.
+	const Image* img = canvas_image();
+	if (!img || img != filter_preview.image || !filter_preview.source.same_dimensions_as(img->buf))
+	{
+		discard_filter_preview();
+		return false;
+	}
+	return true;
+}
+
+void Easel::discard_filter_preview()
+{
+	delete[] filter_preview.source.pixels;
+	filter_preview.source = {};
+	filter_preview.tile_steps.clear();
+	filter_preview.image = nullptr;
+	filter_preview.active = false;
+}
+
+void Easel::preview_color_filter(const ColorFilter& filter, bool reduced)
+{
+	// Filters work on colour channels, which indexed images don't have. Their palette can be edited instead.
+	Image* img = canvas_image();
+	if (!img || img->indexed())
+		return;
+	glm::ivec2 grid = color_filter_tile_grid(img->buf);
+	if (!filter_preview_valid())
+	{
+		// A stroke held through opening the dialog would keep painting over preview pixels, so it is submitted before the source is taken.
+		canvas().cursor_submit();
+		filter_preview.source = img->buf;
+		filter_preview.source.pxnew();
+		subbuffer_copy(filter_preview.source, img->buf);
+		filter_preview.tile_steps.assign(grid.x * grid.y, 0);
+		filter_preview.image = img;
+		filter_preview.filter = filter;
+		filter_preview.active = true;
+	}
+	else if (!(filter_preview.filter == filter))
+	{
+		filter_preview.filter = filter;
+		std::fill(filter_preview.tile_steps.begin(), filter_preview.tile_steps.end(), 0);
+	}
+
+	// Only tiles in view that are stale or were previewed at a coarser step are recomputed.
+	IntRect visible = visible_image_rect();
+	if (visible.w <= 0 || visible.h <= 0)
+		return;
+	int step = reduced ? FILTER_PREVIEW_REDUCED_STEP : 1;
+	std::vector<int> tiles;
+	IntBounds dirty = { INT_MAX, INT_MIN, INT_MAX, INT_MIN };
+	for (int ty = visible.y / COLOR_FILTER_TILE_SIZE; ty <= (visible.y + visible.h - 1) / COLOR_FILTER_TILE_SIZE; ++ty)
+	{
+		for (int tx = visible.x / COLOR_FILTER_TILE_SIZE; tx <= (visible.x + visible.w - 1) / COLOR_FILTER_TILE_SIZE; ++tx)
+		{
+			int& tile_step = filter_preview.tile_steps[tx + ty * grid.x];
+			if (tile_step == 0 || tile_step > step)
+			{
+				tile_step = step;
+				tiles.push_back(tx + ty * grid.x);
+				dirty.x1 = std::min(dirty.x1, tx);
+				dirty.x2 = std::max(dirty.x2, tx);
+				dirty.y1 = std::min(dirty.y1, ty);
+				dirty.y2 = std::max(dirty.y2, ty);
+			}
+		}
+	}
+	if (tiles.empty())
+		return;
+	::apply_color_filter(filter, filter_preview.source, img->buf, tiles, step);
+	int x = dirty.x1 * COLOR_FILTER_TILE_SIZE, y = dirty.y1 * COLOR_FILTER_TILE_SIZE;
+	img->update_subtexture(x, y, std::min((dirty.x2 + 1) * COLOR_FILTER_TILE_SIZE, img->buf.width) - x, std::min((dirty.y2 + 1) * COLOR_FILTER_TILE_SIZE, img->buf.height) - y);
+	mark_dirty();
+}
+
+// Owns the canvas buffer from before a whole-image edit, and swaps it with the canvas image's buffer both ways.
+struct SwapCanvasBufferAction : public ActionBase
+{
+	Easel* easel;
+	Buffer buf;
+	SwapCanvasBufferAction(Easel* easel, Buffer buf) : easel(easel), buf(buf) { weight = sizeof(SwapCanvasBufferAction) + buf.bytes(); }
+	~SwapCanvasBufferAction() { delete[] buf.pixels; }
+	virtual void forward() override { execute(); }
+	virtual void backward() override { execute(); }
+	void execute()
+	{
+		if (easel)
+		{
+			std::swap(buf, easel->canvas_image()->buf);
+			easel->canvas_image()->update_texture();
+		}
+	}
+	QUASAR_ACTION_EQUALS_OVERRIDE(SwapCanvasBufferAction)
+};
+
+void Easel::commit_color_filter()
+{
+	if (!filter_preview_valid())
+		return;
+	Image* img = canvas_image();
+	std::vector<int> tiles;
+	for (int i = 0; i < (int)filter_preview.tile_steps.size(); ++i)
+	{
+		if (filter_preview.tile_steps[i] != 1)
+			tiles.push_back(i);
+	}
+	::apply_color_filter(filter_preview.filter, filter_preview.source, img->buf, tiles, 1);
+	img->update_texture();
+	mark_dirty();
+
+	Machine.history.push(std::make_shared<SwapCanvasBufferAction>(this, filter_preview.source));
+	filter_preview.source = {};
+	discard_filter_preview();
+}
+
+void Easel::cancel_color_filter()
+{
+	if (!filter_preview_valid())
+		return;
+	Image* img = canvas_image();
+	subbuffer_copy(img->buf, filter_preview.source);
+	img->update_texture();
+	mark_dirty();
+	discard_filter_preview();
+}
+
+void Easel::apply_color_filter(const ColorFilter& filter)
+{
+	cancel_color_filter();
+	preview_color_filter(filter, false);
+	commit_color_filter();
+}
+
+std::vector<PixelRGBA> Easel::quantize_image(const QuantizeOptions& options)
+{
+	canvas().cursor_submit(); // a held stroke would otherwise be submitted later with pre-quantization pixels as its previous state
+	cancel_color_filter();
+	Image* img = canvas_image();
+	if (!img || img->indexed())
+		return {};
+	std::vector<PixelRGBA> palette = quantize_palette(img->buf, options);
+	if (palette.empty())
+		return palette;
+
+	Buffer prev = img->buf;
+	prev.pxnew();
+	subbuffer_copy(prev, img->buf);
+	apply_palette_indices(img->buf, palette, remap_to_palette(img->buf, PaletteLookup(palette), options.dither));
+	img->update_texture();
+
+	Machine.history.push(std::make_shared<SwapCanvasBufferAction>(this, prev));
+	return palette;
+}
+
+void Easel::snap_image_to_palette(const PaletteLookup& lookup, QuantizeOptions::Dither dither)
+{
+	canvas().cursor_submit(); // see quantize_image()
+	cancel_color_filter();
+	Image* img = canvas_image();
+	if (!img || img->indexed() || lookup.empty())
+		return;
+
+	Buffer prev = img->buf;
+	prev.pxnew();
+	subbuffer_copy(prev, img->buf);
+	snap_to_palette(img->buf, lookup, dither);
+	img->update_texture();
+
+	Machine.history.push(std::make_shared<SwapCanvasBufferAction>(this, prev));
+}
+
+void Easel::index_image(const std::shared_ptr<ColorSubscheme>& subscheme, QuantizeOptions::Dither dither)
+{
+	canvas().cursor_submit(); // the stroke was painted in direct colour, so it must land before the buffer changes format
+	cancel_color_filter();
+	Image* img = canvas_image();
+	if (!img || img->indexed())
+		return;
+	auto palette = std::make_shared<IndexedPalette>(subscheme);
+	if (palette->empty())
+		return;
+
+	Buffer prev = img->buf;
+	img->buf = index_buffer(prev, *palette, dither);
+	img->palette = std::move(palette);
+	img->resend_texture();
+
+	struct IndexImageAction : public ActionBase
+	{
+		Easel* easel;
+		Buffer buf;
+		std::shared_ptr<IndexedPalette> palette;
+		IndexImageAction(Easel* easel, Buffer buf) : easel(easel), buf(buf) { weight = sizeof(IndexImageAction) + buf.bytes(); }
+		~IndexImageAction() { delete[] buf.pixels; }
+		virtual void forward() override { execute(); }
+		virtual void backward() override { execute(); }
+		void execute()
+		{
+			if (easel)
+			{
+				std::swap(buf, easel->canvas_image()->buf);
+				std::swap(palette, easel->canvas_image()->palette);
+				easel->canvas_image()->resend_texture();
+			}
+		}
+		QUASAR_ACTION_EQUALS_OVERRIDE(IndexImageAction)
+	};
+	Machine.history.push(std::make_shared<IndexImageAction>(this, prev));
+}
+
+void Easel::unindex_image()
+{
+	canvas().cursor_submit();
+	cancel_color_filter();
+	Image* img = canvas_image();
+	if (!img || !img->indexed())
+		return;
+
+	Buffer prev = img->buf;
+	img->buf = expand_indexed_buffer(prev, *img->palette);
+	std::shared_ptr<IndexedPalette> palette = std::move(img->palette);
+	img->resend_texture();
+
+	struct UnindexImageAction : public ActionBase
+	{
+		Easel* easel;
+		Buffer buf;
+		std::shared_ptr<IndexedPalette> palette;
+		UnindexImageAction(Easel* easel, Buffer buf, const std::shared_ptr<IndexedPalette>& palette)
+			: easel(easel), buf(buf), palette(palette) { weight = sizeof(UnindexImageAction) + buf.bytes(); }
+		~UnindexImageAction() { delete[] buf.pixels; }
+		virtual void forward() override { execute(); }
+		virtual void backward() override { execute(); }
+		void execute()
+		{
+			if (easel)
+			{
+				std::swap(buf, easel->canvas_image()->buf);
+				std::swap(palette, easel->canvas_image()->palette);
+				easel->canvas_image()->resend_texture();
+			}
+		}
+		QUASAR_ACTION_EQUALS_OVERRIDE(UnindexImageAction)
+	};
+	Machine.history.push(std::make_shared<UnindexImageAction>(this, prev, palette));
+}
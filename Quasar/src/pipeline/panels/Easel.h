@@ -9,6 +9,9 @@
 #include "../widgets/Widget.h"
 #include "edit/image/Image.h"
 #include "edit/image/PaintActions.h"
+#include "edit/image/Filters.h"
+#include "edit/color/Quantize.h"
+#include "edit/color/IndexedPalette.h"
 #include "variety/History.h"
 
 struct BrushInfo
@@ -24,8 +27,8 @@ struct BrushInfo
 	std::shared_ptr<Image> preview_image;
 	std::shared_ptr<Image> eraser_preview_image;
 	static const int eraser_preview_img_sx = 2, eraser_preview_img_sy = 2;
-	std::unordered_map<IPosition, PixelRGBA> storage_1c;
-	std::unordered_map<IPosition, std::pair<PixelRGBA, PixelRGBA>> storage_2c;
+	PixelMap<PixelRGBA> storage_1c;
+	PixelMap<std::pair<PixelRGBA, PixelRGBA>> storage_2c;
 
 	struct
 	{
@@ -44,11 +47,14 @@ struct Canvas : public Widget
 {
 	friend struct Easel;
 	Shader sprite_shader; // LATER have one shader for internal sprites like checkerboard/cursors/previews, and a second for the actual sprites (used for multiple layers/frames).
+	Shader indexed_sprite_shader; // draws indexed images through their palette texture
+	SpriteBatch sprite_batch;
 	RGBA checker1, checker2;
 	Gridlines minor_gridlines;
 	Gridlines major_gridlines;
 
 	std::shared_ptr<Image> image;
+	IntRect visible_region; // pixels of the image inside the easel, set before each draw
 
 	bool visible = false;
 	bool cursor_in_canvas = false;
@@ -83,7 +89,6 @@ public:
 
 	virtual void draw() override;
 	void draw_cursor();
-	void send_vp(const glm::mat3& vp);
 	void sync_cursor_with_widget();
 	void sync_ur(size_t subw);
 
@@ -95,11 +100,12 @@ public:
 	void sync_gridlines_with_image();
 	void sync_transform();
 	void sync_gfx_with_image();
+	void set_visible_region(IntRect region);
 
 	void create_checkerboard_image();
 	void sync_checkerboard_colors() const;
 	void sync_checkerboard_texture() const;
-	void set_checkerboard_uv_size(float width, float height) const;
+	void set_checkerboard_uvs(Bounds uvs) const;
 
 	void update_brush_tool_and_tip();
 	
@@ -123,6 +129,8 @@ public:
 	void cursor_press(MouseButton button);
 	void cursor_release(MouseButton button);
 	bool cursor_cancel();
+	// Ends a stroke still in progress by submitting it, so that whole-image edits start from a settled buffer and history.
+	bool cursor_submit();
 
 	RGBA primary_color, alternate_color;
 	PixelRGBA pric_pxs = {};
@@ -147,6 +155,7 @@ public:
 		BRUSH_PREVIEW,
 		ERASER_PREVIEW,
 		SELECT_PREVIEW,
+		INDEXED_SPRITE,
 		SPRITE, // LATER SPRITE_START
 		_W_COUNT
 	};
@@ -231,6 +240,38 @@ public:
 	void rotate_image_180();
 	void rotate_image_270();
 
+	struct
+	{
+		ColorFilter filter;
+		Buffer source; // canvas pixels before filtering: restored on cancel, kept by the undo action on commit
+		std::vector<int> tile_steps; // step each tile of the canvas image was last previewed at, or 0 if stale
+		bool active = false;
+	private:
+		friend Easel;
+		const Image* image = nullptr;
+	} filter_preview;
+
+	static constexpr int FILTER_PREVIEW_REDUCED_STEP = 4;
+
+	IntRect visible_image_rect() const;
+	void preview_color_filter(const ColorFilter& filter, bool reduced);
+	void commit_color_filter();
+	void cancel_color_filter();
+	void apply_color_filter(const ColorFilter& filter);
+	// Reduces the canvas image to a quantized palette, which is returned. Alpha is kept.
+	std::vector<PixelRGBA> quantize_image(const QuantizeOptions& options);
+	void snap_image_to_palette(const PaletteLookup& lookup, QuantizeOptions::Dither dither);
+	// Converts the canvas image to indices into the first colours of subscheme, after which editing those colours recolours the image.
+	void index_image(const std::shared_ptr<ColorSubscheme>& subscheme, QuantizeOptions::Dither dither);
+	// Converts an indexed canvas image back to direct RGBA colour.
+	void unindex_image();
+
+private:
+	bool filter_preview_valid();
+	void discard_filter_preview();
+
+public:
+
 	Canvas& canvas() { return *widget.get<Canvas>(CANVAS); }
 	const Canvas& canvas() const { return *widget.get<Canvas>(CANVAS); }
 
@@ -2,6 +2,7 @@
 
 #include "user/Machine.h"
 #include "user/ControlScheme.h"
+#include "variety/Profiler.h"
 
 MenuPanel::MenuPanel()
 {
@@ -79,6 +80,37 @@ void MenuPanel::draw()
 			if (ImGui::MenuItem("Rotate 90", "", false, Machine.canvas_image_ready())) { Machine.rotate_90(); }
 			if (ImGui::MenuItem("Rotate 180", "", false, Machine.canvas_image_ready())) { Machine.rotate_180(); }
 			if (ImGui::MenuItem("Rotate 270", "", false, Machine.canvas_image_ready())) { Machine.rotate_270(); }
+			ImGui::Separator();
+			if (ImGui::BeginMenu("Adjust colors", Machine.canvas_image_ready() && !Machine.canvas_is_indexed()))
+			{
+				if (ImGui::MenuItem("Hue/Saturation/Lightness...")) { open_color_filter_dialog(ColorFilter::Type::HSL_SHIFT); }
+				if (ImGui::MenuItem("Brightness/Contrast...")) { open_color_filter_dialog(ColorFilter::Type::BRIGHTNESS_CONTRAST); }
+				if (ImGui::MenuItem("Levels...")) { open_color_filter_dialog(ColorFilter::Type::LEVELS); }
+				if (ImGui::MenuItem("Curves...")) { open_color_filter_dialog(ColorFilter::Type::CURVES); }
+				if (ImGui::MenuItem("Posterize...")) { open_color_filter_dialog(ColorFilter::Type::POSTERIZE); }
+				if (ImGui::MenuItem("Invert")) { Machine.invert_colors(); }
+				ImGui::EndMenu();
+			}
+			if (ImGui::MenuItem("Reduce colors...", "", false, Machine.canvas_image_ready() && !Machine.canvas_is_indexed())) { Machine.cancel_color_filter(); quantize_dialog.open = true; }
+			if (ImGui::BeginMenu("Snap to palette", Machine.canvas_image_ready() && !Machine.canvas_is_indexed()))
+			{
+				if (ImGui::MenuItem("No dithering")) { Machine.snap_canvas_to_palette(QuantizeOptions::Dither::NONE); }
+				if (ImGui::MenuItem("Ordered dithering")) { Machine.snap_canvas_to_palette(QuantizeOptions::Dither::ORDERED); }
+				if (ImGui::MenuItem("Floyd-Steinberg dithering")) { Machine.snap_canvas_to_palette(QuantizeOptions::Dither::FLOYD_STEINBERG); }
+				ImGui::EndMenu();
+			}
+			if (Machine.canvas_is_indexed())
+			{
+				if (ImGui::MenuItem("Convert to direct color")) { Machine.unindex_canvas(); }
+			}
+			else if (ImGui::BeginMenu("Index to palette", Machine.canvas_image_ready()))
+			{
+				if (ImGui::MenuItem("No dithering")) { Machine.index_canvas(QuantizeOptions::Dither::NONE); }
+				if (ImGui::MenuItem("Ordered dithering")) { Machine.index_canvas(QuantizeOptions::Dither::ORDERED); }
+				if (ImGui::MenuItem("Floyd-Steinberg dithering")) { Machine.index_canvas(QuantizeOptions::Dither::FLOYD_STEINBERG); }
+				ImGui::EndMenu();
+			}
+			if (ImGui::MenuItem("Extract palette from canvas", "", false, Machine.canvas_image_ready())) { Machine.palette_extract_from_canvas(); }
 			ImGui::EndMenu();
 		}
 		if (ImGui::BeginMenu("View"))
@@ -126,6 +158,8 @@ void MenuPanel::draw()
 			{
 				if (ImGui::MenuItem("Show major gridlines", "SHIFT+G", false, Machine.canvas_image_ready())) { Machine.show_major_gridlines(); }
 			}
+			ImGui::Separator();
+			ImGui::MenuItem("Frame profiler", "", &Profiler.overlay_open);
 			ImGui::EndMenu();
 		}
 		if (ImGui::BeginMenu("Help"))
@@ -159,6 +193,9 @@ void MenuPanel::draw()
 
 		ImGui::EndMainMenuBar();
 	}
+	draw_color_filter_dialog();
+	draw_quantize_dialog();
+	Profiler.draw_overlay();
 }
 
 Scale MenuPanel::minimum_screen_display() const
@@ -178,3 +215,129 @@ void MenuPanel::main_menu_setup()
 	else
 		submenus_open = true;
 }
+
+void MenuPanel::open_color_filter_dialog(ColorFilter::Type type)
+{
+	Machine.cancel_color_filter();
+	color_filter_dialog.filter = {};
+	color_filter_dialog.filter.type = type;
+	color_filter_dialog.open = true;
+}
+
+void MenuPanel::draw_color_filter_dialog()
+{
+	if (!color_filter_dialog.open)
+		return;
+	if (!Machine.canvas_image_ready())
+	{
+		Machine.cancel_color_filter();
+		color_filter_dialog.open = false;
+		return;
+	}
+
+	static const char* titles[] = { "Hue/Saturation/Lightness", "Brightness/Contrast", "Levels", "Curves", "Invert", "Posterize" };
+	ColorFilter& filter = color_filter_dialog.filter;
+	bool keep_open = true;
+	bool apply = false;
+	ImGui::SetNextWindowPos(ImGui::GetMainViewport()->GetCenter(), ImGuiCond_Appearing, ImVec2(0.5f, 0.5f));
+	if (ImGui::Begin(titles[(int)filter.type], &keep_open, ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_AlwaysAutoResize))
+	{
+		switch (filter.type)
+		{
+		case ColorFilter::Type::HSL_SHIFT:
+			ImGui::SliderFloat("Hue", &filter.hue_shift, -0.5f, 0.5f);
+			ImGui::SliderFloat("Saturation", &filter.saturation_shift, -1.0f, 1.0f);
+			ImGui::SliderFloat("Lightness", &filter.lightness_shift, -1.0f, 1.0f);
+			break;
+		case ColorFilter::Type::BRIGHTNESS_CONTRAST:
+			ImGui::SliderFloat("Brightness", &filter.brightness, -1.0f, 1.0f);
+			ImGui::SliderFloat("Contrast", &filter.contrast, -1.0f, 1.0f);
+			break;
+		case ColorFilter::Type::LEVELS:
+			ImGui::SliderInt("Input black", &filter.in_black, 0, filter.in_white - 1);
+			ImGui::SliderInt("Input white", &filter.in_white, filter.in_black + 1, 255);
+			ImGui::SliderFloat("Gamma", &filter.gamma, 0.1f, 10.0f, "%.2f", ImGuiSliderFlags_Logarithmic);
+			ImGui::SliderInt("Output black", &filter.out_black, 0, 255);
+			ImGui::SliderInt("Output white", &filter.out_white, 0, 255);
+			break;
+		case ColorFilter::Type::CURVES:
+			// LATER draggable control points on a curve graph. For now, outputs are edited at fixed inputs.
+			for (size_t i = 0; i < filter.curve.size(); ++i)
+			{
+				if (i > 0)
+					ImGui::SameLine();
+				ImGui::PushID((int)i);
+				ImGui::VSliderInt("##curve", ImVec2(24, 160), &filter.curve[i].y, 0, 255);
+				ImGui::PopID();
+			}
+			break;
+		case ColorFilter::Type::POSTERIZE:
+			ImGui::SliderInt("Levels", &filter.posterize_levels, 2, 32);
+			break;
+		case ColorFilter::Type::INVERT:
+			break;
+		}
+		// Coarse preview while a slider is held, then full resolution once it is released.
+		Machine.preview_color_filter(filter, ImGui::IsAnyItemActive());
+		apply = ImGui::Button("Apply");
+		ImGui::SameLine();
+		if (ImGui::Button("Cancel"))
+			keep_open = false;
+	}
+	ImGui::End();
+
+	if (apply)
+	{
+		Machine.commit_color_filter();
+		color_filter_dialog.open = false;
+	}
+	else if (!keep_open)
+	{
+		Machine.cancel_color_filter();
+		color_filter_dialog.open = false;
+	}
+}
+
+void MenuPanel::draw_quantize_dialog()
+{
+	if (!quantize_dialog.open)
+		return;
+	if (!Machine.canvas_image_ready())
+	{
+		quantize_dialog.open = false;
+		return;
+	}
+
+	static const char* methods[] = { "Median cut", "Octree", "K-means" };
+	static const char* dithers[] = { "None", "Ordered", "Floyd-Steinberg" };
+	QuantizeOptions& options = quantize_dialog.options;
+	bool keep_open = true;
+	bool apply = false;
+	ImGui::SetNextWindowPos(ImGui::GetMainViewport()->GetCenter(), ImGuiCond_Appearing, ImVec2(0.5f, 0.5f));
+	if (ImGui::Begin("Reduce colors", &keep_open, ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_AlwaysAutoResize))
+	{
+		// LATER live preview. Unlike colour filters, quantization is global, so it can't be previewed tile by tile.
+		int method = (int)options.method;
+		if (ImGui::Combo("Method", &method, methods, IM_ARRAYSIZE(methods)))
+			options.method = (QuantizeOptions::Method)method;
+		ImGui::SliderInt("Colors", &options.num_colors, 2, MAX_QUANTIZED_COLORS);
+		if (options.method == QuantizeOptions::Method::K_MEANS)
+			ImGui::SliderInt("Iterations", &options.k_means_iterations, 1, 32);
+		int dither = (int)options.dither;
+		if (ImGui::Combo("Dither", &dither, dithers, IM_ARRAYSIZE(dithers)))
+			options.dither = (QuantizeOptions::Dither)dither;
+		apply = ImGui::Button("Apply");
+		ImGui::SameLine();
+		if (ImGui::Button("Cancel"))
+			keep_open = false;
+	}
+	ImGui::End();
+
+	if (apply)
+	{
+		Machine.quantize_canvas(options);
+		quantize_dialog.open = false;
+	}
+	else if (!keep_open)
+		quantize_dialog.open = false;
+}
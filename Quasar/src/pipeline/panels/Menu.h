@@ -2,6 +2,8 @@
 
 #include "Panel.h"
 #include "user/Platform.h"
+#include "edit/image/Filters.h"
+#include "edit/color/Quantize.h"
 
 struct MenuPanel : public Panel
 {
@@ -12,6 +14,18 @@ private:
 	bool _close_menu = false;
 	bool submenus_open = false;
 
+	struct
+	{
+		ColorFilter filter;
+		bool open = false;
+	} color_filter_dialog;
+
+	struct
+	{
+		QuantizeOptions options;
+		bool open = false;
+	} quantize_dialog;
+
 public:
 	MenuPanel();
 	MenuPanel(const MenuPanel&) = delete;
@@ -19,8 +33,12 @@ public:
 
 	virtual void _send_view() override;
 	virtual void draw() override;
+	virtual bool draws_gui() const override { return true; }
 	virtual Scale minimum_screen_display() const override;
 
 private:
 	void main_menu_setup();
+	void open_color_filter_dialog(ColorFilter::Type type);
+	void draw_color_filter_dialog();
+	void draw_quantize_dialog();
 };
@@ -6,7 +6,6 @@
 #include "user/Machine.h"
 #include "variety/GLutility.h"
 #include "Easel.h"
-#include "../render/Uniforms.h"
 #include "../widgets/ColorPicker.h"
 #include "../widgets/ColorPalette.h"
 
@@ -45,8 +44,8 @@ PalettePanel::PalettePanel()
 	use_primary = [this]() { return color_picker(this).get_editing_color() == ColorPicker::EditingColor::PRIMARY; };
 	use_alternate = [this]() { return color_picker(this).get_editing_color() == ColorPicker::EditingColor::ALTERNATE; };
 	swap_picker_colors = [this]() { color_picker(this).swap_picker_colors(); };
-	emit_modified_primary = [this](RGBA rgba) {	MEasel->canvas().set_primary_color(rgba); };
-	emit_modified_alternate = [this](RGBA rgba) { MEasel->canvas().set_alternate_color(rgba); };
+	emit_modified_primary = [this](RGBA rgba) {	MEasel->canvas().set_primary_color(rgba); MEasel->mark_dirty(); };
+	emit_modified_alternate = [this](RGBA rgba) { MEasel->canvas().set_alternate_color(rgba); MEasel->mark_dirty(); };
 }
 
 void PalettePanel::initialize()
@@ -145,6 +144,26 @@ void PalettePanel::delete_subpalette()
 	color_palette(this).delete_current_subpalette(true);
 }
 
+void PalettePanel::extract_subpalette(const Buffer& buf)
+{
+	color_palette(this).extract_subpalette(buf, extracted_palette_max_colors, true);
+}
+
+void PalettePanel::append_subpalette(const std::string& name_prefix, const std::vector<PixelRGBA>& colors)
+{
+	color_palette(this).append_subpalette(name_prefix, colors, true);
+}
+
+ColorSubscheme& PalettePanel::current_subscheme()
+{
+	return *color_palette(this).current_subpalette().subscheme;
+}
+
+const std::shared_ptr<ColorSubscheme>& PalettePanel::current_subscheme_ref()
+{
+	return color_palette(this).current_subpalette().subscheme;
+}
+
 void PalettePanel::set_pri_color(RGBA color)
 {
 	color_picker(this).set_pri_color(color, false);
@@ -192,7 +211,5 @@ void PalettePanel::sync_widget()
 void PalettePanel::_send_view()
 {
 	vp = vp_matrix();
-	Uniforms::send_matrix3(bkg_shader, "u_VP", vp);
-	unbind_shader();
 	sync_widget();
 }
@@ -2,6 +2,7 @@
 
 #include "Panel.h"
 #include "user/Platform.h"
+#include "edit/color/ColorScheme.h"
 #include "../render/FlatSprite.h"
 #include "../render/Shader.h"
 #include "../widgets/Widget.h"
@@ -26,6 +27,8 @@ struct PalettePanel : public Panel
 	std::function<void(RGBA)> emit_modified_primary;
 	std::function<void(RGBA)> emit_modified_alternate;
 
+	size_t extracted_palette_max_colors = 256; // SETTINGS
+
 	PalettePanel();
 	PalettePanel(const PalettePanel&) = delete;
 	PalettePanel(PalettePanel&&) noexcept = delete;
@@ -33,6 +36,7 @@ struct PalettePanel : public Panel
 	virtual void initialize() override;
 	virtual void _send_view() override;
 	virtual void draw() override;
+	virtual bool draws_gui() const override { return true; }
 	void process();
 	void render_widget();
 	virtual Scale minimum_screen_display() const override;
@@ -43,6 +47,10 @@ struct PalettePanel : public Panel
 	void new_subpalette();
 	void rename_subpalette();
 	void delete_subpalette();
+	void extract_subpalette(const struct Buffer& buf);
+	void append_subpalette(const std::string& name_prefix, const std::vector<PixelRGBA>& colors);
+	ColorSubscheme& current_subscheme();
+	const std::shared_ptr<ColorSubscheme>& current_subscheme_ref();
 
 	void set_pri_color(RGBA color);
 	void set_alt_color(RGBA color);
@@ -1,13 +1,26 @@
 #include "Panel.h"
 
+#include <typeinfo>
+
 #include "user/Machine.h"
+#include "variety/GLutility.h"
+#include "variety/Profiler.h"
+
+Panel::Panel()
+	: view_block(sizeof(ViewBlockData))
+{
+}
 
 void Panel::render()
 {
-	if (visible)
+	if (visible && (dirty || draws_gui()))
 	{
+		QUASAR_PROFILE_GPU(typeid(*this).name());
 		bounds.clip().scissor();
+		QUASAR_GL(glClear(GL_COLOR_BUFFER_BIT));
+		view_block.bind_base(UniformBlockBinding::VIEW);
 		draw();
+		dirty = false;
 	}
 }
 
@@ -48,7 +61,10 @@ glm::mat3 Panel::vp_matrix_inverse() const
 
 void Panel::send_view()
 {
+	mark_dirty();
 	view.position = to_view_coordinates(bounds.clip().center_point());
+	ViewBlockData view_data(vp_matrix());
+	view_block.send(0, sizeof(view_data), &view_data);
 	_send_view();
 }
 
@@ -82,6 +98,12 @@ Scale Panel::to_screen_size(Scale world_size) const
 	return Machine.to_screen_size(world_size, vp_matrix());
 }
 
+PanelGroup::~PanelGroup()
+{
+	QUASAR_GL(glDeleteFramebuffers(1, &framebuffer));
+	delete_texture(framebuffer_texture);
+}
+
 void PanelGroup::sync_panels()
 {
 	for (auto& panel : panels)
@@ -90,8 +112,83 @@ void PanelGroup::sync_panels()
 
 void PanelGroup::render()
 {
+	QUASAR_PROFILE("panels");
+	if (!sync_framebuffer())
+		return;
+	QUASAR_GL(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer));
 	for (auto& panel : panels)
 		panel->render();
+	QUASAR_GL(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0));
+	QUASAR_GL(glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer));
+	Machine.main_window_clip().scissor(); // blits are scissored
+	QUASAR_GL(glBlitFramebuffer(0, 0, framebuffer_width, framebuffer_height, 0, 0, framebuffer_width, framebuffer_height, GL_COLOR_BUFFER_BIT, GL_NEAREST));
+	QUASAR_GL(glBindFramebuffer(GL_READ_FRAMEBUFFER, 0));
+}
+
+// (Re)allocates the framebuffer to the window size, which loses its contents, so every panel is dirtied. Returns false while the window has no area.
+bool PanelGroup::sync_framebuffer()
+{
+	int width = MainWindow->width();
+	int height = MainWindow->height();
+	if (width <= 0 || height <= 0)
+		return false;
+	if (framebuffer && width == framebuffer_width && height == framebuffer_height)
+		return true;
+
+	if (!framebuffer)
+	{
+		QUASAR_GL(glGenFramebuffers(1, &framebuffer));
+		QUASAR_GL(glGenTextures(1, &framebuffer_texture));
+	}
+	bind_texture(framebuffer_texture);
+	QUASAR_GL(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+	QUASAR_GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+	QUASAR_GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+	QUASAR_GL(glBindFramebuffer(GL_FRAMEBUFFER, framebuffer));
+	QUASAR_GL(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, framebuffer_texture, 0));
+	GLenum status;
+	QUASAR_GL(status = glCheckFramebufferStatus(GL_FRAMEBUFFER));
+	QUASAR_GL(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		LOG << LOG.error << LOG.start << "Panel framebuffer is incomplete (status " << status << ")." << LOG.endl;
+		return false;
+	}
+	framebuffer_width = width;
+	framebuffer_height = height;
+
+	// areas that no panel covers still show the clear color
+	Machine.main_window_clip().scissor();
+	QUASAR_GL(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer));
+	QUASAR_GL(glClear(GL_COLOR_BUFFER_BIT));
+	QUASAR_GL(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0));
+	mark_all_dirty();
+	return true;
+}
+
+void PanelGroup::mark_all_dirty()
+{
+	for (auto& panel : panels)
+		panel->mark_dirty();
+}
+
+void PanelGroup::mark_dirty_at(Position screen_pos)
+{
+	for (auto& panel : panels)
+	{
+		if (panel->bounds.clip().contains_point(screen_pos))
+			panel->mark_dirty();
+	}
+}
+
+bool PanelGroup::any_dirty() const
+{
+	for (const auto& panel : panels)
+	{
+		if (panel->visible && panel->dirty)
+			return true;
+	}
+	return false;
 }
 
 void PanelGroup::set_projection()
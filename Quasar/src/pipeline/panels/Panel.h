@@ -4,6 +4,7 @@
 #include <memory>
 
 #include "variety/Geometry.h"
+#include "../render/Uniforms.h"
 
 struct PanelGroup;
 
@@ -11,10 +12,14 @@ struct Panel
 {
 	PanelGroup* pgroup = nullptr;
 	bool visible = true;
+	// Set when what the panel last drew is out of date. Clean panels skip drawing, and keep their pixels in the group's framebuffer.
+	bool dirty = true;
 	FlatTransform view{};
 	IntBounds bounds{};
+	// ViewBlock holding vp_matrix(), bound while the panel draws
+	UniformBuffer view_block;
 
-	Panel() = default;
+	Panel();
 	Panel(const Panel&) = delete;
 	Panel(Panel&&) noexcept = delete;
 	virtual ~Panel() = default;
@@ -22,6 +27,9 @@ struct Panel
 	virtual void initialize() {}
 	virtual void draw() = 0;
 	void render();
+	void mark_dirty() { dirty = true; }
+	// ImGui doesn't keep draw data between frames, so panels that issue ImGui windows from draw() must draw every frame.
+	virtual bool draws_gui() const { return false; }
 	glm::mat3 vp_matrix() const;
 	glm::mat3 vp_matrix_inverse() const;
 	virtual void _send_view() = 0;
@@ -43,16 +51,32 @@ struct Panel
 	virtual Scale minimum_screen_display() const { return {}; }
 };
 
+// Panels draw into a window-sized framebuffer, which is blitted to the window every frame, so that a panel only draws when it is dirty.
 struct PanelGroup
 {
 	std::vector<std::unique_ptr<Panel>> panels;
 	glm::mat3 projection{};
 
+private:
+	GLuint framebuffer = 0;
+	GLuint framebuffer_texture = 0;
+	int framebuffer_width = 0;
+	int framebuffer_height = 0;
+
+public:
 	PanelGroup() = default;
 	PanelGroup(const PanelGroup&) = delete;
 	PanelGroup(PanelGroup&&) noexcept = delete;
+	~PanelGroup();
 
 	void sync_panels();
 	void render();
 	void set_projection();
+
+	void mark_all_dirty();
+	void mark_dirty_at(Position screen_pos);
+	bool any_dirty() const;
+
+private:
+	bool sync_framebuffer();
 };
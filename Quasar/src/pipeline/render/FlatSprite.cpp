@@ -4,6 +4,7 @@
 
 #include "ImplUtility.h"
 #include "variety/GLutility.h"
+#include "edit/image/TiledTexture.h"
 
 constexpr size_t SHADER_POS_TEXTURE = 0;
 constexpr size_t SHADER_POS_VERT_POS = 1;
@@ -21,6 +22,7 @@ FlatSprite::FlatSprite(Shader* shader)
 
 void FlatSprite::draw(GLuint texture_slot)
 {
+	QUASAR_ASSERT(!image || !image->tiled()); // tiled images can only be submitted to a SpriteBatch
 	if (image)
 	{
 		bind_texture(image->tid, texture_slot);
@@ -28,6 +30,68 @@ void FlatSprite::draw(GLuint texture_slot)
 	}
 }
 
+// Cuts the sprite's quad along the tile edges. Each piece samples its whole tile.
+static void submit_tiles(const FlatSprite& sprite, SpriteBatch& batch, GLuint texture_slot, int layer, const SpriteBatch::TextureBinding* extra_texture)
+{
+	const UnitRenderable& ur = *sprite.ur;
+	const Image& image = *sprite.image;
+	glm::vec2 pos1, pos2, uv1, uv2;
+	ur.get_attribute(0, SHADER_POS_VERT_POS, glm::value_ptr(pos1));
+	ur.get_attribute(3, SHADER_POS_VERT_POS, glm::value_ptr(pos2));
+	ur.get_attribute(0, SHADER_POS_UV, glm::value_ptr(uv1));
+	ur.get_attribute(3, SHADER_POS_UV, glm::value_ptr(uv2));
+	if (uv1.x == uv2.x || uv1.y == uv2.y)
+		return;
+
+	const unsigned short stride = ur.shader->stride;
+	const unsigned short pos_offset = ur.shader->attribute_offsets[SHADER_POS_VERT_POS];
+	const unsigned short uv_offset = ur.shader->attribute_offsets[SHADER_POS_UV];
+	std::vector<GLfloat> quad(ur.varr, ur.varr + 4 * stride);
+	for (const TiledTexture::Tile& tile : image.tiles->get_tiles())
+	{
+		if (!tile.tid || !image.tiles->is_visible(tile))
+			continue;
+		// tile bounds in the sprite's UV space, clipped to the sprite
+		glm::vec2 tile1 = { float(tile.rect.x) / image.buf.width, float(tile.rect.y) / image.buf.height };
+		glm::vec2 tile2 = { float(tile.rect.x + tile.rect.w) / image.buf.width, float(tile.rect.y + tile.rect.h) / image.buf.height };
+		glm::vec2 clip1 = glm::max(tile1, glm::min(uv1, uv2));
+		glm::vec2 clip2 = glm::min(tile2, glm::max(uv1, uv2));
+		if (clip1.x >= clip2.x || clip1.y >= clip2.y)
+			continue;
+		for (unsigned short v = 0; v < 4; ++v)
+		{
+			glm::vec2 uv = { v % 2 ? clip2.x : clip1.x, v / 2 ? clip2.y : clip1.y };
+			glm::vec2 pos = pos1 + (uv - uv1) / (uv2 - uv1) * (pos2 - pos1);
+			glm::vec2 tile_uv = (uv - tile1) / (tile2 - tile1);
+			GLfloat* vertex = quad.data() + v * stride;
+			vertex[pos_offset] = pos.x;
+			vertex[pos_offset + 1] = pos.y;
+			vertex[uv_offset] = tile_uv.x;
+			vertex[uv_offset + 1] = tile_uv.y;
+		}
+		if (extra_texture)
+			batch.submit(ur.shader, quad.data(), layer, { { texture_slot, tile.tid }, *extra_texture });
+		else
+			batch.submit(ur.shader, quad.data(), layer, { { texture_slot, tile.tid } });
+	}
+}
+
+void FlatSprite::submit(SpriteBatch& batch, GLuint texture_slot, int layer) const
+{
+	if (image && image->tiled())
+		submit_tiles(*this, batch, texture_slot, layer, nullptr);
+	else if (image)
+		batch.submit(*ur, layer, { { texture_slot, image->tid } });
+}
+
+void FlatSprite::submit(SpriteBatch& batch, GLuint texture_slot, int layer, SpriteBatch::TextureBinding extra_texture) const
+{
+	if (image && image->tiled())
+		submit_tiles(*this, batch, texture_slot, layer, &extra_texture);
+	else if (image)
+		batch.submit(*ur, layer, { { texture_slot, image->tid }, extra_texture });
+}
+
 const FlatSprite& FlatSprite::update_transform() const
 {
 	Utils::set_vertex_pos_attributes(*ur, global_matrix(), 0, SHADER_POS_VERT_POS, false);
@@ -15,6 +15,10 @@ struct FlatSprite : public W_UnitRenderable
 	FlatSprite(FlatSprite&&) noexcept = delete;
 
 	void draw(GLuint texture_slot);
+	// Tiled images are submitted as one quad per tile that has a texture.
+	void submit(SpriteBatch& batch, GLuint texture_slot, int layer) const;
+	// Also binds extra_texture to every quad, e.g. the palette of an indexed image.
+	void submit(SpriteBatch& batch, GLuint texture_slot, int layer, SpriteBatch::TextureBinding extra_texture) const;
 	
 	const FlatSprite& update_transform() const;
 	FlatSprite& update_transform();
@@ -1,11 +1,33 @@
 #include "Gridlines.h"
 
-#include "Uniforms.h"
+static Shader gridlines_shader(bool procedural)
+{
+	if (procedural)
+		return Shader(FileSystem::shader_path("gridlines_procedural.vert"), FileSystem::shader_path("gridlines_procedural.frag"));
+	else
+		return Shader(FileSystem::shader_path("gridlines.vert"), FileSystem::shader_path("gridlines.frag"));
+}
 
-Gridlines::Gridlines()
-	: shader(FileSystem::shader_path("gridlines.vert"), FileSystem::shader_path("gridlines.frag"))
+Gridlines::Gridlines(bool procedural)
+	: procedural(procedural), shader(gridlines_shader(procedural))
 {
-	initialize_dynamic_vao(vao, vb, 0, shader.stride, varr, shader.attributes);
+	uniforms.flat_transform = UniformHandle<glm::vec4>(shader, "u_FlatTransform");
+	uniforms.color = UniformHandle<glm::vec4>(shader, "u_Color");
+	uniforms.line_width = UniformHandle<float>(shader, "u_LineWidth");
+	if (procedural)
+	{
+		uniforms.grid_size = UniformHandle<glm::vec2>(shader, "u_GridSize");
+		uniforms.line_spacing = UniformHandle<glm::vec2>(shader, "u_LineSpacing");
+	}
+	if (procedural)
+	{
+		// unit square, stretched over the image in the vertex shader
+		static const GLfloat corners[] = { 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f };
+		initialize_dynamic_vao(vao, vb, 4, shader.stride, corners, shader.attributes);
+	}
+	else
+		initialize_dynamic_vao(vao, vb, 0, shader.stride, varr, shader.attributes);
+	set_line_width(line_width);
 }
 
 Gridlines::~Gridlines()
@@ -18,16 +40,54 @@ Gridlines::~Gridlines()
 
 void Gridlines::resize_grid(Scale scale)
 {
+	update_scale(scale);
+	if (procedural)
+	{
+		uniforms.grid_size.send(glm::vec2(width, height));
+		uniforms.line_spacing.send(line_spacing);
+		return;
+	}
+
 	delete[] varr;
 	varr = new GLfloat[num_vertices() * shader.stride];
-	update_scale(scale);
 #pragma warning(push)
 #pragma warning(disable : 6386)
+	// Each line is a zero-width quad along its centre, whose vertices the vertex shader pushes out by half the line width in the direction of i_Expand.
+	GLfloat* setter = varr;
+	auto vertex = [&setter, stride = shader.stride](float x, float y, float expand_x, float expand_y) {
+		setter[0] = x;
+		setter[1] = y;
+		setter[2] = expand_x;
+		setter[3] = expand_y;
+		setter += stride;
+		};
+
+	float x1 = -width * 0.5f;
+	float y1 = -height * 0.5f;
+	float x2 = width * 0.5f;
+	float y2 = height * 0.5f;
+	for (GLsizei i = 0; i < num_cols(); ++i)
+	{
+		float x = i + 1 < num_cols() ? x1 + i * line_spacing.x : x2;
+		vertex(x, y1, -1.0f, -1.0f);
+		vertex(x, y1, 1.0f, -1.0f);
+		vertex(x, y2, -1.0f, 1.0f);
+		vertex(x, y2, 1.0f, 1.0f);
+	}
+	for (GLsizei i = 0; i < num_rows(); ++i)
+	{
+		float y = i + 1 < num_rows() ? y1 + i * line_spacing.y : y2;
+		vertex(x1, y, -1.0f, -1.0f);
+		vertex(x1, y, -1.0f, 1.0f);
+		vertex(x2, y, 1.0f, -1.0f);
+		vertex(x2, y, 1.0f, 1.0f);
+	}
+
 	delete[] arrays_firsts;
 	delete[] arrays_counts;
 	arrays_firsts = new GLint[num_quads()];
 	arrays_counts = new GLsizei[num_quads()];
-	for (unsigned short i = 0; i < num_quads(); ++i)
+	for (GLsizei i = 0; i < num_quads(); ++i)
 	{
 		arrays_firsts[i] = 4 * i;
 		arrays_counts[i] = 4;
@@ -35,99 +95,17 @@ void Gridlines::resize_grid(Scale scale)
 #pragma warning(pop)
 }
 
+// Lines are line_width screen pixels wide when zoomed in, and line_width image pixels wide when zoomed out. They are hidden once they would
+// cover the spaces between them. The shaders compute the same widths from u_FlatTransform.
 void Gridlines::update_scale(Scale scale) const
 {
-	if (!varr) return;
-	GLfloat* setter = varr;
-
-#pragma warning(push)
-#pragma warning(disable : 6386)
 	float lwx = 0.5f * line_width;
 	if (scale.x > 1.0f)
 		lwx /= scale.x;
 	float lwy = 0.5f * line_width;
 	if (scale.y > 1.0f)
 		lwy /= scale.y;
-	if (2.0f * lwx >= scale.x * line_spacing.x - self_intersection_threshold || 2.0f * lwy >= scale.y * line_spacing.y - self_intersection_threshold)
-	{
-		_nonobstructing = false;
-		return;
-	}
-	_nonobstructing = true;
-
-	float x1 = -width * 0.5f - lwx;
-	float y1 = -height * 0.5f - lwy;
-	float x2 = -width * 0.5f + lwx;
-	float y2 = height * 0.5f + lwy;
-
-	for (unsigned short i = 0; i < num_cols() - 1; ++i)
-	{
-		float delta = i * line_spacing.x;
-		setter[0] = x1 + delta;
-		setter[1] = y1;
-		setter += shader.stride;
-		setter[0] = x2 + delta;
-		setter[1] = y1;
-		setter += shader.stride;
-		setter[0] = x1 + delta;
-		setter[1] = y2;
-		setter += shader.stride;
-		setter[0] = x2 + delta;
-		setter[1] = y2;
-		setter += shader.stride;
-	}
-
-	x1 = width * 0.5f - lwx;
-	x2 = width * 0.5f + lwx;
-	setter[0] = x1;
-	setter[1] = y1;
-	setter += shader.stride;
-	setter[0] = x2;
-	setter[1] = y1;
-	setter += shader.stride;
-	setter[0] = x1;
-	setter[1] = y2;
-	setter += shader.stride;
-	setter[0] = x2;
-	setter[1] = y2;
-	setter += shader.stride;
-
-	x1 = -width * 0.5f - lwx;
-	y1 = -height * 0.5f - lwy;
-	x2 = width * 0.5f + lwx;
-	y2 = -height * 0.5f + lwy;
-	for (unsigned short i = 0; i < num_rows() - 1; ++i)
-	{
-		float delta = i * line_spacing.y;
-		setter[0] = x1;
-		setter[1] = y1 + delta;
-		setter += shader.stride;
-		setter[0] = x1;
-		setter[1] = y2 + delta;
-		setter += shader.stride;
-		setter[0] = x2;
-		setter[1] = y1 + delta;
-		setter += shader.stride;
-		setter[0] = x2;
-		setter[1] = y2 + delta;
-		setter += shader.stride;
-	}
-
-	y1 = height * 0.5f - lwy;
-	y2 = height * 0.5f + lwy;
-	setter[0] = x1;
-	setter[1] = y1;
-	setter += shader.stride;
-	setter[0] = x1;
-	setter[1] = y2;
-	setter += shader.stride;
-	setter[0] = x2;
-	setter[1] = y1;
-	setter += shader.stride;
-	setter[0] = x2;
-	setter[1] = y2;
-	setter += shader.stride;
-#pragma warning(pop)
+	_nonobstructing = 2.0f * lwx < scale.x * line_spacing.x - self_intersection_threshold && 2.0f * lwy < scale.y * line_spacing.y - self_intersection_threshold;
 }
 
 void Gridlines::draw() const
@@ -136,23 +114,42 @@ void Gridlines::draw() const
 	{
 		bind_shader(shader);
 		bind_vao_buffers(vao, vb);
-		QUASAR_GL(glMultiDrawArrays(GL_TRIANGLE_STRIP, arrays_firsts, arrays_counts, num_quads()));
+		if (procedural)
+		{
+			QUASAR_GL(glDrawArrays(GL_TRIANGLE_STRIP, 0, 4));
+		}
+		else
+		{
+			QUASAR_GL(glMultiDrawArrays(GL_TRIANGLE_STRIP, arrays_firsts, arrays_counts, num_quads()));
+		}
 	}
 }
 
-unsigned short Gridlines::num_cols() const
+GLsizei Gridlines::num_cols() const
 {
-	return unsigned short(std::ceil(width / line_spacing.x)) + 1;
+	return GLsizei(std::ceil(width / line_spacing.x)) + 1;
 }
 
-unsigned short Gridlines::num_rows() const
+GLsizei Gridlines::num_rows() const
 {
-	return unsigned short(std::ceil(height / line_spacing.y)) + 1;
+	return GLsizei(std::ceil(height / line_spacing.y)) + 1;
 }
 
 void Gridlines::set_color(ColorFrame color) const
 {
-	Uniforms::send_4(shader, "u_Color", color.rgba().as_vec(), 0, true);
+	uniforms.color.send(color.rgba().as_vec());
+}
+
+void Gridlines::set_line_spacing(glm::vec2 spacing)
+{
+	line_spacing = spacing;
+	_sync_with_image = true;
+}
+
+void Gridlines::set_line_width(float width)
+{
+	line_width = width;
+	uniforms.line_width.send(line_width);
 }
 
 void Gridlines::send_buffer() const
@@ -166,9 +163,8 @@ void Gridlines::send_flat_transform(FlatTransform canvas_transform) const
 {
 	if (_visible)
 	{
-		Uniforms::send_4(shader, "u_FlatTransform", canvas_transform.packed());
+		uniforms.flat_transform.send(canvas_transform.packed());
 		update_scale(canvas_transform.scale);
-		send_buffer();
 		_send_flat_transform = false;
 	}
 	else
@@ -182,7 +178,8 @@ void Gridlines::sync_with_image(int w, int h, Scale canvas_scale)
 		width = w;
 		height = h;
 		resize_grid(canvas_scale);
-		send_buffer();
+		if (!procedural)
+			send_buffer();
 		_sync_with_image = false;
 	}
 	else
@@ -2,30 +2,41 @@
 
 #include "variety/GLutility.h"
 #include "variety/Geometry.h"
-#include "Shader.h"
+#include "Uniforms.h"
 #include "edit/color/Color.h"
 
+// Gridlines over the canvas image. Line widths are applied in the vertex shader from the canvas transform, so panning and zooming
+// only send u_FlatTransform. In procedural mode a single quad covers the image and the fragment shader decides which pixels lie on a line.
+// Otherwise, one quad per line is built on the CPU, and only rebuilt when the image size or line spacing changes.
 struct Gridlines
 {
-	unsigned short width = 0, height = 0;
+	const bool procedural;
+	int width = 0, height = 0;
 	GLuint vao = 0, vb = 0;
 	Shader shader;
 	GLfloat* varr = nullptr;
-	glm::vec2 line_spacing = { 1.0f, 1.0f };
-	float line_width = 1.0f; // SETTINGS
 	float self_intersection_threshold = 1.0f; // SETTINGS
 
 	GLint* arrays_firsts = nullptr;
 	GLsizei* arrays_counts = nullptr;
 
 private:
+	struct
+	{
+		UniformHandle<glm::vec4> flat_transform, color;
+		UniformHandle<float> line_width;
+		UniformHandle<glm::vec2> grid_size, line_spacing; // procedural only
+	} uniforms;
+
+	glm::vec2 line_spacing = { 1.0f, 1.0f };
+	float line_width = 1.0f; // SETTINGS
 	bool _visible = false;
 	mutable bool _nonobstructing = true;
 	mutable bool _send_flat_transform = false;
 	mutable bool _sync_with_image = false;
 
 public:
-	Gridlines();
+	Gridlines(bool procedural = true);
 	Gridlines(const Gridlines&) = delete;
 	Gridlines(Gridlines&&) noexcept = delete;
 	~Gridlines();
@@ -35,12 +46,17 @@ public:
 	void draw() const;
 
 	bool visible() const { return _visible; }
-	unsigned short num_cols() const;
-	unsigned short num_rows() const;
-	GLsizei num_quads() const { return num_rows() + num_cols(); }
+	GLsizei num_cols() const;
+	GLsizei num_rows() const;
+	GLsizei num_quads() const { return procedural ? 1 : num_rows() + num_cols(); }
 	GLsizei num_vertices() const { return num_quads() * 4; }
 
 	void set_color(ColorFrame color) const;
+	glm::vec2 get_line_spacing() const { return line_spacing; }
+	// Takes effect at the next sync_with_image().
+	void set_line_spacing(glm::vec2 spacing);
+	float get_line_width() const { return line_width; }
+	void set_line_width(float width);
 
 	void send_buffer() const;
 	void send_flat_transform(FlatTransform canvas_transform) const;
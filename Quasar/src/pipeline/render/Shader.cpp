@@ -143,6 +143,8 @@ Shader::Shader(const Shader& other)
 		QUASAR_GL(glDeleteProgram(rid));
 		rid = 0;
 	}
+	else
+		bind_uniform_blocks();
 }
 
 Shader::Shader(Shader&& other) noexcept
@@ -192,6 +194,7 @@ void Shader::setup()
 	load_vertex_attributes();
 	setup_attribute_offsets();
 	load_uniforms();
+	bind_uniform_blocks();
 }
 
 void Shader::load_vertex_attributes()
@@ -237,3 +240,12 @@ void Shader::load_uniforms()
 			uniform_locations.emplace(name, location);
 	}
 }
+
+void Shader::bind_uniform_blocks()
+{
+	QUASAR_GL(GLuint view_block = glGetUniformBlockIndex(rid, "ViewBlock"));
+	if (view_block != GL_INVALID_INDEX)
+	{
+		QUASAR_GL(glUniformBlockBinding(rid, view_block, UniformBlockBinding::VIEW));
+	}
+}
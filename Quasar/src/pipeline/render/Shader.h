@@ -7,6 +7,14 @@
 #include "Macros.h"
 #include "variety/FileSystem.h"
 
+// Fixed binding points of the uniform blocks that shaders share.
+namespace UniformBlockBinding
+{
+	constexpr GLuint GRADIENT_COLORS = 0;
+	// Shaders that declare a ViewBlock are attached to it on load. Each panel binds its own view to it before drawing.
+	constexpr GLuint VIEW = 1;
+}
+
 struct Shader
 {
 	GLuint rid = 0;
@@ -30,4 +38,5 @@ private:
 	void load_vertex_attributes();
 	void setup_attribute_offsets();
 	void load_uniforms();
+	void bind_uniform_blocks();
 };
@@ -0,0 +1,128 @@
+#include "SpriteBatch.h"
+
+#include <algorithm>
+
+#include "variety/GLutility.h"
+
+SpriteBatch::SpriteBatch(GLsizeiptr initial_capacity)
+{
+	QUASAR_GL(glGenVertexArrays(1, &vao));
+	QUASAR_GL(glGenBuffers(1, &ib));
+	allocate(initial_capacity);
+}
+
+SpriteBatch::~SpriteBatch()
+{
+	if (fence)
+	{
+		QUASAR_GL(glDeleteSync(fence));
+	}
+	bind_array_buffer(vb);
+	QUASAR_GL(glUnmapBuffer(GL_ARRAY_BUFFER));
+	delete_vao_buffers(vao, vb, ib);
+}
+
+void SpriteBatch::submit(const UnitRenderable& ur, int layer, std::initializer_list<TextureBinding> textures)
+{
+	QUASAR_ASSERT(ur.get_num_vertices() == 4);
+	queue.push(layer, ur.shader, ur.shader->stride, ur.varr, textures);
+}
+
+void SpriteBatch::submit(const Shader* shader, const GLfloat* quad_vertices, int layer, std::initializer_list<TextureBinding> textures)
+{
+	queue.push(layer, shader, shader->stride, quad_vertices, textures);
+}
+
+void SpriteBatch::wait_for_fence()
+{
+	if (fence)
+	{
+		GLenum status;
+		do
+		{
+			QUASAR_GL(status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000));
+		} while (status == GL_TIMEOUT_EXPIRED);
+		QUASAR_GL(glDeleteSync(fence));
+		fence = nullptr;
+	}
+}
+
+void SpriteBatch::allocate(GLsizeiptr bytes)
+{
+	wait_for_fence();
+	if (vb)
+	{
+		bind_array_buffer(vb);
+		QUASAR_GL(glUnmapBuffer(GL_ARRAY_BUFFER));
+		delete_buffer(vb);
+	}
+	static const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	QUASAR_GL(glGenBuffers(1, &vb));
+	bind_array_buffer(vb);
+	QUASAR_GL(glBufferStorage(GL_ARRAY_BUFFER, bytes, nullptr, flags));
+	QUASAR_GL(mapped = (GLfloat*)glMapBufferRange(GL_ARRAY_BUFFER, 0, bytes, flags));
+	capacity = bytes;
+	head = 0;
+}
+
+// Expects vao and ib to be bound.
+void SpriteBatch::reserve_indices(size_t num_quads)
+{
+	if (num_quads <= index_capacity)
+		return;
+	index_capacity = std::max(num_quads, 2 * index_capacity);
+	// two triangles per triangle strip quad, in the order glDrawArrays(GL_TRIANGLE_STRIP) would draw them
+	std::vector<GLuint> indices(6 * index_capacity);
+	for (GLuint i = 0; i < index_capacity; ++i)
+	{
+		indices[i * 6    ] = 0 + 4 * i;
+		indices[i * 6 + 1] = 1 + 4 * i;
+		indices[i * 6 + 2] = 2 + 4 * i;
+		indices[i * 6 + 3] = 2 + 4 * i;
+		indices[i * 6 + 4] = 1 + 4 * i;
+		indices[i * 6 + 5] = 3 + 4 * i;
+	}
+	QUASAR_GL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW));
+}
+
+void SpriteBatch::flush()
+{
+	if (queue.empty())
+		return;
+	queue.build();
+	const std::vector<GLfloat>& packed = queue.packed_vertices();
+	GLsizeiptr bytes = packed.size() * sizeof(GLfloat);
+	if (bytes > capacity)
+		allocate(std::max(bytes, 2 * capacity));
+	else if (head + bytes > capacity)
+	{
+		wait_for_fence();
+		head = 0;
+	}
+	memcpy((char*)mapped + head, packed.data(), bytes);
+
+	bind_vao_buffers(vao, vb, ib);
+	reserve_indices(queue.max_draw_quads());
+	for (const SpriteBatchQueue::Draw& draw : queue.get_draws())
+	{
+		bind_shader(*draw.shader);
+		for (const TextureBinding& texture : draw.textures)
+			bind_texture(texture.texture, texture.slot);
+		GLuint num_attributes = (GLuint)draw.shader->attributes.size();
+		for (GLuint i = num_attributes; i < num_enabled_attributes; ++i)
+		{
+			QUASAR_GL(glDisableVertexAttribArray(i));
+		}
+		num_enabled_attributes = num_attributes;
+		attrib_pointers(draw.shader->attributes, draw.stride, head + draw.vertices_offset * sizeof(GLfloat));
+		QUASAR_GL(glDrawElements(GL_TRIANGLES, GLsizei(6 * draw.num_quads), GL_UNSIGNED_INT, nullptr));
+	}
+	head += bytes;
+	if (fence)
+	{
+		QUASAR_GL(glDeleteSync(fence));
+	}
+	QUASAR_GL(fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+	unbind_vao_buffers();
+	queue.clear();
+}
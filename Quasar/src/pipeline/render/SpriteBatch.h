@@ -0,0 +1,38 @@
+#pragma once
+
+#include "SpriteBatchQueue.h"
+#include "Renderable.h"
+
+// Draws quads from many UnitRenderables through one persistently mapped vertex buffer, in as few draw calls as SpriteBatchQueue allows.
+// The buffer is written as a ring. Wrapping around waits on the fence of the last flush, and a flush that doesn't fit grows the buffer.
+// Quads are drawn with the texture bindings they were submitted with, and the uniforms and uniform blocks bound at flush().
+class SpriteBatch
+{
+	SpriteBatchQueue queue;
+	GLuint vao = 0, vb = 0, ib = 0;
+	GLfloat* mapped = nullptr;
+	GLsizeiptr capacity = 0; // bytes
+	GLsizeiptr head = 0; // bytes
+	GLsync fence = nullptr;
+	size_t index_capacity = 0; // quads
+	GLuint num_enabled_attributes = 0;
+
+public:
+	typedef SpriteBatchQueue::TextureBinding TextureBinding;
+
+	SpriteBatch(GLsizeiptr initial_capacity = 1 << 16);
+	SpriteBatch(const SpriteBatch&) = delete;
+	SpriteBatch(SpriteBatch&&) noexcept = delete;
+	~SpriteBatch();
+
+	// ur must have 4 vertices. Its current vertices are copied, so it can change before flush().
+	void submit(const UnitRenderable& ur, int layer, std::initializer_list<TextureBinding> textures = {});
+	// quad_vertices holds 4 vertices laid out as shader expects. They are copied.
+	void submit(const Shader* shader, const GLfloat* quad_vertices, int layer, std::initializer_list<TextureBinding> textures = {});
+	void flush();
+
+private:
+	void wait_for_fence();
+	void allocate(GLsizeiptr bytes);
+	void reserve_indices(size_t num_quads);
+};
@@ -0,0 +1,98 @@
+#include "SpriteBatchQueue.h"
+
+#include <algorithm>
+#include <numeric>
+#include <functional>
+
+#include "Macros.h"
+
+void SpriteBatchQueue::push(int layer, const Shader* shader, unsigned short stride, const GLfloat* quad_vertices, std::initializer_list<TextureBinding> textures)
+{
+	QUASAR_ASSERT(textures.size() <= MAX_QUAD_TEXTURES);
+	Quad quad;
+	quad.layer = layer;
+	quad.shader = shader;
+	quad.stride = stride;
+	quad.vertices_offset = vertices.size();
+	for (const TextureBinding& texture : textures)
+		quad.textures[quad.num_textures++] = texture;
+	quads.push_back(quad);
+	vertices.insert(vertices.end(), quad_vertices, quad_vertices + 4 * stride);
+	built = false;
+}
+
+static bool can_join(const SpriteBatchQueue::Draw& draw, const SpriteBatchQueue::Quad& quad)
+{
+	if (draw.shader != quad.shader)
+		return false;
+	for (unsigned char i = 0; i < quad.num_textures; ++i)
+	{
+		for (const SpriteBatchQueue::TextureBinding& bound : draw.textures)
+		{
+			if (bound.slot == quad.textures[i].slot && bound.texture != quad.textures[i].texture)
+				return false;
+		}
+	}
+	return true;
+}
+
+void SpriteBatchQueue::build()
+{
+	if (built)
+		return;
+	std::vector<size_t> order(quads.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [this](size_t i, size_t j) {
+		const Quad& a = quads[i];
+		const Quad& b = quads[j];
+		if (a.layer != b.layer)
+			return a.layer < b.layer;
+		if (a.shader != b.shader)
+			return std::less<const Shader*>{}(a.shader, b.shader);
+		GLuint ta = a.num_textures ? a.textures[0].texture : 0;
+		GLuint tb = b.num_textures ? b.textures[0].texture : 0;
+		return ta < tb;
+		});
+
+	packed.clear();
+	packed.reserve(vertices.size());
+	draws.clear();
+	for (size_t i : order)
+	{
+		const Quad& quad = quads[i];
+		if (draws.empty() || !can_join(draws.back(), quad))
+		{
+			Draw draw;
+			draw.shader = quad.shader;
+			draw.stride = quad.stride;
+			draw.vertices_offset = packed.size();
+			draws.push_back(std::move(draw));
+		}
+		Draw& draw = draws.back();
+		for (unsigned char t = 0; t < quad.num_textures; ++t)
+		{
+			if (std::find(draw.textures.begin(), draw.textures.end(), quad.textures[t]) == draw.textures.end())
+				draw.textures.push_back(quad.textures[t]);
+		}
+		packed.insert(packed.end(), vertices.begin() + quad.vertices_offset, vertices.begin() + quad.vertices_offset + 4 * quad.stride);
+		++draw.num_quads;
+	}
+	built = true;
+}
+
+void SpriteBatchQueue::clear()
+{
+	quads.clear();
+	vertices.clear();
+	packed.clear();
+	draws.clear();
+	built = false;
+}
+
+size_t SpriteBatchQueue::max_draw_quads() const
+{
+	size_t max_quads = 0;
+	for (const Draw& draw : draws)
+		max_quads = std::max(max_quads, draw.num_quads);
+	return max_quads;
+}
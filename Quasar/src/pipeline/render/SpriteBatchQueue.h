@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <initializer_list>
+
+#include "Macros.h"
+
+struct Shader;
+
+// The CPU side of SpriteBatch, which makes no GL calls. Quads are 4 vertices in triangle strip order, laid out as their shader expects.
+// build() stable-sorts them by layer, then shader, then texture, and merges neighbouring quads into one draw while they share a shader
+// and no two of them need different textures in the same slot. Quads within a layer may be reordered, but a quad is never drawn before
+// one in a lower layer.
+class SpriteBatchQueue
+{
+public:
+	struct TextureBinding
+	{
+		GLuint slot = 0;
+		GLuint texture = 0;
+
+		bool operator==(const TextureBinding&) const = default;
+	};
+
+	static constexpr size_t MAX_QUAD_TEXTURES = 2;
+
+	struct Quad
+	{
+		int layer = 0;
+		const Shader* shader = nullptr;
+		unsigned short stride = 0;
+		size_t vertices_offset = 0; // into the pushed vertices, in floats
+		std::array<TextureBinding, MAX_QUAD_TEXTURES> textures = {};
+		unsigned char num_textures = 0;
+	};
+
+	struct Draw
+	{
+		const Shader* shader = nullptr;
+		unsigned short stride = 0;
+		size_t vertices_offset = 0; // into packed_vertices(), in floats
+		size_t num_quads = 0;
+		std::vector<TextureBinding> textures;
+	};
+
+private:
+	std::vector<Quad> quads;
+	std::vector<GLfloat> vertices;
+	std::vector<GLfloat> packed;
+	std::vector<Draw> draws;
+	bool built = false;
+
+public:
+	void push(int layer, const Shader* shader, unsigned short stride, const GLfloat* quad_vertices, std::initializer_list<TextureBinding> textures = {});
+	void build();
+	void clear();
+
+	bool empty() const { return quads.empty(); }
+	size_t num_quads() const { return quads.size(); }
+	// Valid after build(). Each draw's vertices are contiguous, and draws are in order.
+	const std::vector<Draw>& get_draws() const { return draws; }
+	const std::vector<GLfloat>& packed_vertices() const { return packed; }
+	size_t max_draw_quads() const;
+};
@@ -9,72 +9,79 @@ static void uniform_does_not_exist(const char* uniform, size_t shader)
 	LOG << LOG.error << LOG.start << "Uniform \"" << uniform << "\" does not exist in shader (" << shader << ")." << LOG.endl;
 }
 
-void Uniforms::send_1(const Shader& shader, const char* uniform, float value, GLint uniform_offset, bool unbind)
+template<typename T>
+UniformHandle<T>::UniformHandle(const Shader& shader, const char* uniform, GLint uniform_offset)
+	: program(shader)
 {
 	auto iter = shader.uniform_locations.find(uniform);
 	if (iter != shader.uniform_locations.end())
-	{
-		bind_shader(shader);
-		QUASAR_GL(glUniform1fv(iter->second + uniform_offset, 1, &value));
-		if (unbind)
-			unbind_shader();
-	}
+		location = iter->second + uniform_offset;
 	else
 		uniform_does_not_exist(uniform, shader);
 }
 
-void Uniforms::send_2(const Shader& shader, const char* uniform, glm::vec2 value, GLint uniform_offset, bool unbind)
+static void program_uniform(GLuint program, GLint location, float value)
 {
-	auto iter = shader.uniform_locations.find(uniform);
-	if (iter != shader.uniform_locations.end())
-	{
-		bind_shader(shader);
-		QUASAR_GL(glUniform2fv(iter->second + uniform_offset, 1, glm::value_ptr(value)));
-		if (unbind)
-			unbind_shader();
-	}
-	else
-		uniform_does_not_exist(uniform, shader);
+	QUASAR_GL(glProgramUniform1fv(program, location, 1, &value));
 }
 
-void Uniforms::send_3(const Shader& shader, const char* uniform, glm::vec3 value, GLint uniform_offset, bool unbind)
+static void program_uniform(GLuint program, GLint location, const glm::vec2& value)
 {
-	auto iter = shader.uniform_locations.find(uniform);
-	if (iter != shader.uniform_locations.end())
-	{
-		bind_shader(shader);
-		QUASAR_GL(glUniform3fv(iter->second + uniform_offset, 1, glm::value_ptr(value)));
-		if (unbind)
-			unbind_shader();
-	}
-	else
-		uniform_does_not_exist(uniform, shader);
+	QUASAR_GL(glProgramUniform2fv(program, location, 1, glm::value_ptr(value)));
 }
 
-void Uniforms::send_4(const Shader& shader, const char* uniform, glm::vec4 value, GLint uniform_offset, bool unbind)
+static void program_uniform(GLuint program, GLint location, const glm::vec3& value)
 {
-	auto iter = shader.uniform_locations.find(uniform);
-	if (iter != shader.uniform_locations.end())
-	{
-		bind_shader(shader);
-		QUASAR_GL(glUniform4fv(iter->second + uniform_offset, 1, glm::value_ptr(value)));
-		if (unbind)
-			unbind_shader();
-	}
-	else
-		uniform_does_not_exist(uniform, shader);
+	QUASAR_GL(glProgramUniform3fv(program, location, 1, glm::value_ptr(value)));
 }
 
-void Uniforms::send_matrix3(const Shader& shader, const char* uniform, const glm::mat3& value, GLint uniform_offset, bool unbind)
+static void program_uniform(GLuint program, GLint location, const glm::vec4& value)
 {
-	auto iter = shader.uniform_locations.find(uniform);
-	if (iter != shader.uniform_locations.end())
-	{
-		bind_shader(shader);
-		QUASAR_GL(glUniformMatrix3fv(iter->second + uniform_offset, 1, GL_FALSE, glm::value_ptr(value)));
-		if (unbind)
-			unbind_shader();
-	}
-	else
-		uniform_does_not_exist(uniform, shader);
+	QUASAR_GL(glProgramUniform4fv(program, location, 1, glm::value_ptr(value)));
+}
+
+static void program_uniform(GLuint program, GLint location, const glm::mat3& value)
+{
+	QUASAR_GL(glProgramUniformMatrix3fv(program, location, 1, GL_FALSE, glm::value_ptr(value)));
+}
+
+template<typename T>
+void UniformHandle<T>::send(const T& value) const
+{
+	if (location < 0 || (sent && last_value == value))
+		return;
+	program_uniform(program, location, value);
+	last_value = value;
+	sent = true;
+}
+
+template class UniformHandle<float>;
+template class UniformHandle<glm::vec2>;
+template class UniformHandle<glm::vec3>;
+template class UniformHandle<glm::vec4>;
+template class UniformHandle<glm::mat3>;
+
+UniformBuffer::UniformBuffer(GLsizeiptr size, const void* data)
+	: size(size)
+{
+	QUASAR_GL(glGenBuffers(1, &ubo));
+	bind_uniform_buffer(ubo);
+	QUASAR_GL(glBufferData(GL_UNIFORM_BUFFER, size, data, GL_DYNAMIC_DRAW));
+}
+
+UniformBuffer::~UniformBuffer()
+{
+	delete_buffer(ubo);
+}
+
+void UniformBuffer::bind_base(GLuint binding) const
+{
+	bind_uniform_buffer_base(binding, ubo);
+}
+
+void UniformBuffer::send(GLintptr offset, GLsizeiptr length, const void* data) const
+{
+	QUASAR_ASSERT(offset + length <= size);
+	bind_uniform_buffer(ubo);
+	QUASAR_GL(glBufferSubData(GL_UNIFORM_BUFFER, offset, length, data));
 }
@@ -2,11 +2,48 @@
 
 #include "Shader.h"
 
-namespace Uniforms
+// A uniform location looked up once, when the owner of the shader is constructed. Values go through glProgramUniform*(), so the shader is never bound,
+// and a value equal to the last one sent is skipped. All sends to the uniform should go through the same handle, or that last value goes stale.
+// Defined for float, glm::vec2, glm::vec3, glm::vec4 and glm::mat3.
+template<typename T>
+class UniformHandle
 {
-	extern void send_1(const Shader& shader, const char* uniform, float value, GLint uniform_offset = 0, bool unbind = false);
-	extern void send_2(const Shader& shader, const char* uniform, glm::vec2 value, GLint uniform_offset = 0, bool unbind = false);
-	extern void send_3(const Shader& shader, const char* uniform, glm::vec3 value, GLint uniform_offset = 0, bool unbind = false);
-	extern void send_4(const Shader& shader, const char* uniform, glm::vec4 value, GLint uniform_offset = 0, bool unbind = false);
-	extern void send_matrix3(const Shader& shader, const char* uniform, const glm::mat3& value, GLint uniform_offset = 0, bool unbind = false);
-}
+	GLuint program = 0;
+	GLint location = -1;
+	mutable T last_value{};
+	mutable bool sent = false;
+
+public:
+	UniformHandle() = default;
+	UniformHandle(const Shader& shader, const char* uniform, GLint uniform_offset = 0);
+
+	bool valid() const { return location >= 0; }
+	void send(const T& value) const;
+	// Forces the next send through, e.g. after the program was relinked.
+	void invalidate() const { sent = false; }
+};
+
+// A GL uniform buffer for std140 blocks, whose layout the owner mirrors on the CPU. Blocks are attached by binding point, which
+// UniformBlockBinding lists, so one buffer serves every shader that declares the block.
+class UniformBuffer
+{
+	GLuint ubo = 0;
+	GLsizeiptr size = 0;
+
+public:
+	UniformBuffer(GLsizeiptr size, const void* data = nullptr);
+	UniformBuffer(const UniformBuffer&) = delete;
+	UniformBuffer(UniformBuffer&&) noexcept = delete;
+	~UniformBuffer();
+
+	void bind_base(GLuint binding) const;
+	void send(GLintptr offset, GLsizeiptr length, const void* data) const;
+};
+
+// The ViewBlock's u_VP. A std140 mat3 is laid out as three vec4 columns.
+struct ViewBlockData
+{
+	glm::vec4 vp_columns[3];
+
+	ViewBlockData(const glm::mat3& vp) : vp_columns{ glm::vec4(vp[0], 0.0f), glm::vec4(vp[1], 0.0f), glm::vec4(vp[2], 0.0f) } {}
+};
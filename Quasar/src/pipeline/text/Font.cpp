@@ -1,126 +1,234 @@
 #include "Font.h"
 
+#include <algorithm>
+#include <charconv>
+#include <string_view>
+
 #include "variety/IO.h"
 
-static bool read_kern_part(const std::string& p, int& k)
+static constexpr size_t KERN_LINE_CAPACITY = 256;
+static constexpr size_t KERN_READ_CHUNK = 4096;
+
+struct KerningFileContext
+{
+	const FilePath& filepath;
+	std::vector<KerningPair>& pairs;
+	size_t line_number = 0;
+
+	void error(size_t column, const char* message) const
+	{
+		LOG << LOG.warning << LOG.start << "Kerning file \"" << filepath.c_str() << "\" (" << line_number << ":" << column << "): " << message << LOG.endl;
+	}
+};
+
+static bool is_kern_space(char c)
+{
+	return c == ' ' || c == '\t';
+}
+
+static bool read_kern_escape(char c, int& k)
+{
+	switch (c)
+	{
+	case '\\': k = '\\'; return true;
+	case '\'': k = '\''; return true;
+	case '"': k = '\"'; return true;
+	case '?': k = '\?'; return true;
+	case 'a': k = '\a'; return true;
+	case 'b': k = '\b'; return true;
+	case 'f': k = '\f'; return true;
+	case 'n': k = '\n'; return true;
+	case 'r': k = '\r'; return true;
+	case 't': k = '\t'; return true;
+	case 'v': k = '\v'; return true;
+	case '0': k = '\0'; return true;
+	default: return false;
+	}
+}
+
+static bool read_kern_part(const KerningFileContext& context, std::string_view part, size_t column, int& k)
 {
-	if (p[0] == '\\')
+	if (part[0] == '\\')
 	{
-		if (p.size() == 1)
+		if (part.size() == 1)
+		{
+			context.error(column, "Incomplete escape sequence.");
 			return false;
-		if (p[1] == 'x')
-			k = std::stoi(p.substr(2, p.size() - 2), nullptr, 16);
-		else if (p[1] == '\\')
-			k = '\\';
-		else if (p[1] == '\'')
-			k = '\'';
-		else if (p[1] == '"')
-			k = '\"';
-		else if (p[1] == '?')
-			k = '\?';
-		else if (p[1] == 'a')
-			k = '\a';
-		else if (p[1] == 'b')
-			k = '\b';
-		else if (p[1] == 'f')
-			k = '\f';
-		else if (p[1] == 'n')
-			k = '\n';
-		else if (p[1] == 'r')
-			k = '\r';
-		else if (p[1] == 't')
-			k = '\t';
-		else if (p[1] == 'v')
-			k = '\v';
-		else if (p[1] == '0')
-			k = '\0';
-		else
+		}
+		if (part[1] == 'x')
+		{
+			const char* last = part.data() + part.size();
+			auto [ptr, ec] = std::from_chars(part.data() + 2, last, k, 16);
+			if (part.size() == 2 || ec != std::errc() || ptr != last)
+			{
+				context.error(column + 2, "Invalid hexadecimal codepoint.");
+				return false;
+			}
+			return true;
+		}
+		if (part.size() != 2 || !read_kern_escape(part[1], k))
+		{
+			context.error(column, "Unrecognized escape sequence.");
 			return false;
+		}
+		return true;
+	}
+
+	unsigned char first = static_cast<unsigned char>(part[0]);
+	size_t num_bytes = first < 0x80 ? 1 : first < 0xC0 ? 0 : first < 0xE0 ? 2 : first < 0xF0 ? 3 : first < 0xF8 ? 4 : 0;
+	if (num_bytes == 0 || part.size() != num_bytes)
+	{
+		context.error(column, "Expected a single character or escape sequence.");
+		return false;
+	}
+	k = num_bytes == 1 ? first : first & (0xFF >> (num_bytes + 1));
+	for (size_t i = 1; i < num_bytes; ++i)
+	{
+		unsigned char cont = static_cast<unsigned char>(part[i]);
+		if ((cont & 0xC0) != 0x80)
+		{
+			context.error(column + i, "Invalid UTF-8 continuation byte.");
+			return false;
+		}
+		k = (k << 6) | (cont & 0x3F);
 	}
-	else
-		k = p[0];
 	return true;
 }
 
-static bool parse_kerning_line(const std::string& p0, const std::string& p1,
-	const std::string& p2, std::pair<std::pair<Codepoint, Codepoint>, int>& insert)
+static void parse_kerning_line(KerningFileContext& context, std::string_view line)
 {
-	if (!read_kern_part(p0, insert.first.first))
-		return false;
-	if (!read_kern_part(p1, insert.first.second))
-		return false;
-	insert.second = std::stoi(p2);
-	return true;
+	std::string_view parts[3];
+	size_t columns[3]{};
+	size_t i = 0;
+	size_t num_parts = 0;
+	while (true)
+	{
+		while (i < line.size() && is_kern_space(line[i]))
+			++i;
+		if (i == line.size())
+			break;
+		size_t start = i;
+		while (i < line.size() && !is_kern_space(line[i]))
+			++i;
+		if (num_parts == 3)
+		{
+			context.error(start + 1, "Unexpected trailing characters.");
+			return;
+		}
+		columns[num_parts] = start + 1;
+		parts[num_parts++] = line.substr(start, i - start);
+	}
+	if (num_parts == 0)
+		return;
+	if (num_parts < 3)
+	{
+		context.error(line.size() + 1, "Expected two characters followed by a kerning value.");
+		return;
+	}
+
+	int c1, c2, k;
+	if (!read_kern_part(context, parts[0], columns[0], c1) || !read_kern_part(context, parts[1], columns[1], c2))
+		return;
+	const char* first = parts[2].data();
+	const char* last = first + parts[2].size();
+	if (*first == '+')
+		++first;
+	auto [ptr, ec] = std::from_chars(first, last, k);
+	if (ec != std::errc() || ptr != last)
+	{
+		context.error(columns[2] + (ptr - parts[2].data()), "Invalid kerning value.");
+		return;
+	}
+	context.pairs.push_back({ KerningPair::make_key(c1, c2), k });
 }
 
-static void parse_kerning(const FilePath& filepath, Kerning::Map& kerning)
+// Streams the file through a fixed-size chunk and line buffer, so parsing allocates nothing beyond the resulting pairs.
+static void parse_kerning(const FilePath& filepath, std::vector<KerningPair>& kerning)
 {
-	std::string content;
-	if (IO.read_file(filepath, content))
+	FILE* file;
+	if (fopen_s(&file, filepath.c_str(), "rb") != 0 || !file)
+	{
+		LOG << LOG.warning << LOG.start << "Could not open \"" << filepath.c_str() << "\" for reading" << LOG.endl;
+		return;
+	}
+
+	KerningFileContext context{ filepath, kerning };
+	char chunk[KERN_READ_CHUNK];
+	char line[KERN_LINE_CAPACITY];
+	size_t line_length = 0;
+	bool overflow = false;
+	bool prev_r = false;
+	auto end_line = [&]() {
+		++context.line_number;
+		if (overflow)
+			context.error(KERN_LINE_CAPACITY + 1, "Line is too long.");
+		else
+			parse_kerning_line(context, std::string_view(line, line_length));
+		line_length = 0;
+		overflow = false;
+		};
+
+	size_t count;
+	while ((count = fread(chunk, 1, KERN_READ_CHUNK, file)) > 0)
 	{
-		char part = 0;
-		std::string p0, p1, p2;
-		for (auto iter = content.begin(); iter != content.end(); ++iter)
+		for (size_t i = 0; i < count; ++i)
 		{
-			if (carriage_return_1(*iter))
-			{
-				std::pair<std::pair<Codepoint, Codepoint>, int> insert;
-				if (parse_kerning_line(p0, p1, p2, insert))
-					kerning.insert_or_assign(insert.first, insert.second);
-				p0.clear();
-				p1.clear();
-				p2.clear();
-				part = 0;
-			}
-			else if (carriage_return_2(*iter, iter + 1 != content.end() ? *(iter + 1) : 0))
-			{
-				std::pair<std::pair<Codepoint, Codepoint>, int> insert;
-				if (parse_kerning_line(p0, p1, p2, insert))
-					kerning.insert_or_assign(insert.first, insert.second);
-				p0.clear();
-				p1.clear();
-				p2.clear();
-				part = 0;
-				++iter;
-			}
-			else if (part == 0)
-			{
-				if (*iter == ' ' || *iter == '\t')
-				{
-					if (!p0.empty())
-						++part;
-				}
-				else
-					p0.push_back(*iter);
-			}
-			else if (part == 1)
+			char c = chunk[i];
+			if (carriage_return_2(prev_r ? '\r' : 0, c))
 			{
-				if (*iter == ' ' || *iter == '\t')
-				{
-					if (!p1.empty())
-						++part;
-				}
-				else
-					p1.push_back(*iter);
+				prev_r = false;
+				continue;
 			}
-			else if (*iter != ' ' && *iter != '\t')
-			{
-				p2.push_back(*iter);
-			}
-		}
-		if (part == 2)
-		{
-			std::pair<std::pair<Codepoint, Codepoint>, int> insert;
-			if (parse_kerning_line(p0, p1, p2, insert))
-				kerning.insert_or_assign(insert.first, insert.second);
+			prev_r = c == '\r';
+			if (carriage_return_1(c))
+				end_line();
+			else if (line_length < KERN_LINE_CAPACITY)
+				line[line_length++] = c;
+			else
+				overflow = true;
 		}
 	}
+	if (line_length > 0 || overflow)
+		end_line();
+	fclose(file);
+}
+
+static void sort_kerning_pairs(std::vector<KerningPair>& pairs)
+{
+	std::stable_sort(pairs.begin(), pairs.end(), [](const KerningPair& a, const KerningPair& b) { return a.key < b.key; });
+	auto last = pairs.begin();
+	for (auto iter = pairs.begin(); iter != pairs.end(); ++iter)
+	{
+		if (iter + 1 != pairs.end() && (iter + 1)->key == iter->key)
+			continue;
+		*last++ = *iter;
+	}
+	pairs.erase(last, pairs.end());
+}
+
+static bool find_kerning_pair(const std::vector<KerningPair>& pairs, unsigned long long key, int& k)
+{
+	auto iter = std::lower_bound(pairs.begin(), pairs.end(), key, [](const KerningPair& pair, unsigned long long key) { return pair.key < key; });
+	if (iter != pairs.end() && iter->key == key)
+	{
+		k = iter->k;
+		return true;
+	}
+	return false;
 }
 
 Kerning::Kerning(const FilePath& filepath)
 {
 	if (!filepath.empty())
-		parse_kerning(filepath, map);
+	{
+		parse_kerning(filepath, pairs);
+		sort_kerning_pairs(pairs);
+	}
+}
+
+bool Kerning::find(Codepoint c1, Codepoint c2, int& k) const
+{
+	return find_kerning_pair(pairs, KerningPair::make_key(c1, c2), k);
 }
 
 Font::Glyph::Glyph(Font* font, int index, float scale, size_t buffer_pos)
@@ -158,7 +266,75 @@ void Font::Glyph::render_on_bitmap_unique(const Font& font, const Buffer& buffer
 	location = buffer.pixels;
 }
 
-Font::Font(const FilePath& filepath, float font_size, UTF::String common_buffer, TextureParams texture_params, const std::shared_ptr<Kerning>& kerning)
+void Font::KerningTable::build(const Font& font, const std::vector<Codepoint>& codepoints)
+{
+	gpos = font.font_info.gpos != 0;
+	dense_slots.fill(-1);
+	std::vector<Codepoint> dense_codepoints;
+	std::vector<int> dense_glyphs;
+	for (Codepoint codepoint : codepoints)
+	{
+		if (codepoint < 0 || codepoint >= DENSE_RANGE || dense_slots[codepoint] >= 0)
+			continue;
+		auto glyph = font.glyphs.find(codepoint);
+		if (glyph == font.glyphs.end())
+			continue;
+		dense_slots[codepoint] = static_cast<short>(dense_codepoints.size());
+		dense_codepoints.push_back(codepoint);
+		dense_glyphs.push_back(glyph->second.index);
+	}
+
+	// stbtt_GetGlyphKernAdvance already resolves GPOS before the legacy kern table.
+	dense_count = dense_codepoints.size();
+	dense.resize(dense_count * dense_count);
+	for (size_t i = 0; i < dense_count; ++i)
+	{
+		for (size_t j = 0; j < dense_count; ++j)
+		{
+			int k;
+			if (!font.kerning || !font.kerning->find(dense_codepoints[i], dense_codepoints[j], k))
+				k = stbtt_GetGlyphKernAdvance(&font.font_info, dense_glyphs[i], dense_glyphs[j]);
+			dense[i * dense_count + j] = k;
+		}
+	}
+
+	glyph_pairs.clear();
+	if (!gpos)
+	{
+		int length = stbtt_GetKerningTableLength(&font.font_info);
+		if (length > 0)
+		{
+			std::vector<stbtt_kerningentry> entries(length);
+			length = stbtt_GetKerningTable(&font.font_info, entries.data(), length);
+			glyph_pairs.reserve(length);
+			for (int i = 0; i < length; ++i)
+				glyph_pairs.push_back({ KerningPair::make_key(entries[i].glyph1, entries[i].glyph2), entries[i].advance });
+			sort_kerning_pairs(glyph_pairs);
+		}
+	}
+}
+
+int Font::KerningTable::lookup(const Font& font, Codepoint c1, Codepoint c2, int g1, int g2) const
+{
+	if (dense_count && c1 >= 0 && c1 < DENSE_RANGE && c2 >= 0 && c2 < DENSE_RANGE)
+	{
+		short s1 = dense_slots[c1];
+		short s2 = dense_slots[c2];
+		if (s1 >= 0 && s2 >= 0)
+			return dense[s1 * dense_count + s2];
+	}
+	int k = 0;
+	if (font.kerning && font.kerning->find(c1, c2, k))
+		return k;
+	// LATER GPOS pair adjustments outside the common buffer are still resolved by stb, since they are not enumerable as a flat table.
+	if (gpos)
+		return stbtt_GetGlyphKernAdvance(&font.font_info, g1, g2);
+	if (find_kerning_pair(glyph_pairs, KerningPair::make_key(g1, g2), k))
+		return k;
+	return 0;
+}
+
+Font::Font(const FilePath& filepath, float font_size, UTF::StringView common_buffer, TextureParams texture_params, const std::shared_ptr<Kerning>& kerning)
 	: font_size(font_size), font_info{}, texture_params(texture_params), kerning(kerning), common_texture(std::make_shared<Image>())
 {
 	common_texture->buf.chpp = 1;
@@ -211,8 +387,8 @@ Font::Font(const FilePath& filepath, float font_size, UTF::String common_buffer,
 			offset.pixels = common_texture->buf.pixels + glyph.buffer_pos;
 			glyph.render_on_bitmap_shared(*this, offset, 1, 1, 1, 1);
 		}
-		common_texture->gen_texture(texture_params);
 	}
+	kerning_table.build(*this, codepoints);
 	int space_advance_width, space_left_bearing;
 	stbtt_GetCodepointHMetrics(&font_info, ' ', &space_advance_width, &space_left_bearing);
 	space_width = static_cast<int>(roundf(space_advance_width * scale));
@@ -235,7 +411,6 @@ bool Font::cache(Codepoint codepoint)
 
 	std::shared_ptr<Image> img = std::make_shared<Image>();
 	img->buf = bmp;
-	img->gen_texture();
 	glyph.texture = img;
 	cached_textures.push_back(std::move(img));
 	glyphs.emplace(codepoint, std::move(glyph));
@@ -248,6 +423,14 @@ void Font::cache_all(const Font& other)
 		cache(codepoint);
 }
 
+void Font::upload_textures()
+{
+	if (common_texture->buf.pixels)
+		common_texture->gen_texture(texture_params);
+	for (; num_uploaded_textures < cached_textures.size(); ++num_uploaded_textures)
+		cached_textures[num_uploaded_textures]->gen_texture(texture_params);
+}
+
 bool Font::supports(Codepoint codepoint) const
 {
 	if (glyphs.find(codepoint) != glyphs.end())
@@ -259,11 +442,7 @@ int Font::kerning_of(Codepoint c1, Codepoint c2, int g1, int g2, float sc) const
 {
 	if (g1 == 0)
 		return 0;
-	auto k = kerning->map.find({ c1, c2 });
-	if (k != kerning->map.end())
-		return static_cast<int>(roundf(k->second * scale * sc));
-	else
-		return static_cast<int>(roundf(stbtt_GetGlyphKernAdvance(&font_info, g1, g2) * scale * sc));
+	return static_cast<int>(roundf(kerning_table.lookup(*this, c1, c2, g1, g2) * scale * sc));
 }
 
 void Font::set_texture_params(TextureParams params)
@@ -299,7 +478,7 @@ Bounds Font::uvs(const Glyph& glyph) const
 	return b;
 }
 
-bool FontRange::construct_fontsize(float font_size, UTF::String common_buffer, TextureParams texture_params)
+bool FontRange::construct_fontsize(float font_size, UTF::StringView common_buffer, TextureParams texture_params)
 {
 	if (font_size <= 0.0f)
 		return false;
@@ -2,6 +2,7 @@
 
 #include <unordered_map>
 #include <map>
+#include <array>
 
 #include <stb/stb_truetype.h>
 
@@ -11,12 +12,6 @@
 
 typedef int Codepoint;
 
-template<>
-struct std::hash<std::pair<Codepoint, Codepoint>>
-{
-	size_t operator()(std::pair<Codepoint, Codepoint> p) const { return hash<Codepoint>{}(p.first) ^ (hash<Codepoint>{}(p.second) << 1); }
-};
-
 namespace Fonts
 {
 
@@ -28,12 +23,22 @@ namespace Fonts
 	static constexpr const char8_t* ALPHA_UPPERCASE = u8"ABCDEFGHIJKLMNOPQRSTUVWXYZ";
 }
 
+struct KerningPair
+{
+	unsigned long long key = 0;
+	int k = 0;
+
+	static constexpr unsigned long long make_key(int first, int second) { return (static_cast<unsigned long long>(static_cast<unsigned int>(first)) << 32) | static_cast<unsigned int>(second); }
+};
+
 struct Kerning
 {
-	typedef std::unordered_map<std::pair<Codepoint, Codepoint>, int> Map;
-	Map map;
+	// sorted by key, with later entries in the .kern file overriding earlier ones
+	std::vector<KerningPair> pairs;
 
 	Kerning(const FilePath& filepath);
+
+	bool find(Codepoint c1, Codepoint c2, int& k) const;
 };
 
 struct Font
@@ -58,6 +63,21 @@ struct Font
 		void render_on_bitmap_unique(const Font& font, const Buffer& buffer);
 	};
 
+	// Kerning in unscaled font units, precomputed at load time. Pairs within the common buffer are stored in a dense matrix,
+	// and the remaining pairs are resolved through the sorted .kern overrides and the font's own kern table.
+	struct KerningTable
+	{
+		static constexpr Codepoint DENSE_RANGE = 256;
+		std::array<short, DENSE_RANGE> dense_slots = {};
+		size_t dense_count = 0;
+		std::vector<int> dense;
+		std::vector<KerningPair> glyph_pairs;
+		bool gpos = false;
+
+		void build(const Font& font, const std::vector<Codepoint>& codepoints);
+		int lookup(const Font& font, Codepoint c1, Codepoint c2, int g1, int g2) const;
+	};
+
 	std::unordered_map<Codepoint, Glyph> glyphs;
 	stbtt_fontinfo font_info = {};
 	float font_size = 0.0f;
@@ -67,16 +87,21 @@ struct Font
 	TextureParams texture_params = TextureParams::linear;
 	std::shared_ptr<Image> common_texture = {};
 	std::vector<std::shared_ptr<Image>> cached_textures;
+	size_t num_uploaded_textures = 0;
 	std::shared_ptr<Kerning> kerning = nullptr;
+	KerningTable kerning_table;
 
 	Font() = default;
-	Font(const FilePath& filepath, float font_size, UTF::String common_buffer = Fonts::COMMON, TextureParams texture_params = TextureParams::linear, const std::shared_ptr<Kerning>& kerning = nullptr);
+	Font(const FilePath& filepath, float font_size, UTF::StringView common_buffer = Fonts::COMMON, TextureParams texture_params = TextureParams::linear, const std::shared_ptr<Kerning>& kerning = nullptr);
 	Font(const Font&) = delete;
 	Font(Font&&) noexcept = default;
 	Font& operator=(Font&&) noexcept = default;
 
+	// Glyphs are only rasterized on the CPU when cached. Their textures are generated by upload_textures().
 	bool cache(Codepoint codepoint);
 	void cache_all(const Font& other);
+	// Generates the textures of the common buffer and of every glyph cached since the last call.
+	void upload_textures();
 	bool supports(Codepoint codepoint) const;
 	int kerning_of(Codepoint c1, Codepoint c2, int g1, int g2, float sc = 1.0f) const;
 	void set_texture_params(TextureParams params);
@@ -105,6 +130,6 @@ public:
 	FontRange(const FontRange&) = delete;
 	FontRange(FontRange&&) noexcept = delete;
 
-	bool construct_fontsize(float font_size, UTF::String common_buffer = Fonts::COMMON, TextureParams texture_params = TextureParams::linear);
+	bool construct_fontsize(float font_size, UTF::StringView common_buffer = Fonts::COMMON, TextureParams texture_params = TextureParams::linear);
 	float get_font_and_multiplier(float font_size, Font*& font);
 };
@@ -0,0 +1,271 @@
+#include "TextLayout.h"
+
+void TextLayout::build_layout(UTF::StringView text)
+{
+	num_glyphs = 0;
+	bounds = {};
+	bounds_formatting.setup(*this);
+	auto iter = text.begin();
+	while (iter)
+	{
+		Codepoint codepoint = iter.advance();
+
+		if (codepoint == ' ')
+		{
+			bounds_formatting.advance_x(font->space_width, 0);
+			++bounds_formatting.line_info.num_spaces;
+		}
+		else if (codepoint == '\t')
+		{
+			bounds_formatting.advance_x(font->space_width * format.num_spaces_in_tab, 0);
+			++bounds_formatting.line_info.num_tabs;
+		}
+		else if (carriage_return_2(codepoint, iter ? iter.codepoint() : 0))
+		{
+			bounds_formatting.next_line(*this);
+			++iter;
+		}
+		else if (carriage_return_1(codepoint))
+		{
+			bounds_formatting.next_line(*this);
+		}
+		else if (font->cache(codepoint))
+		{
+			const Font::Glyph& glyph = font->glyphs[codepoint];
+			bounds_formatting.kerning_advance_x(*this, glyph, codepoint);
+			bounds_formatting.advance_x(glyph.advance_width * font->scale, codepoint);
+			bounds_formatting.update_min_ch_y0(glyph);
+			bounds_formatting.update_max_ch_y1(glyph);
+			++num_glyphs;
+		}
+	}
+	bounds_formatting.last_line(*this);
+}
+
+void TextLayout::generate_vertices(UTF::StringView text, glm::vec2 pivot_, size_t max_texture_slots_, std::vector<GLfloat>& varr)
+{
+	pivot = pivot_;
+	max_texture_slots = max_texture_slots_;
+	batches.clear();
+	current_batch = {};
+	varr.assign(num_glyphs * 4 * STRIDE, 0.0f);
+	size_t quad_index = 0;
+	formatting.setup(*this);
+	auto iter = text.begin();
+	while (iter)
+	{
+		Codepoint codepoint = iter.advance();
+
+		if (codepoint == ' ')
+			formatting.advance_x(font->space_width * formatting.line.space_mul_x, 0);
+		else if (codepoint == '\t')
+			formatting.advance_x(font->space_width * format.num_spaces_in_tab * formatting.line.space_mul_x, 0);
+		else if (carriage_return_2(codepoint, iter ? iter.codepoint() : 0))
+		{
+			formatting.next_line(*this);
+			++iter;
+		}
+		else if (carriage_return_1(codepoint))
+			formatting.next_line(*this);
+		else if (font->cache(codepoint))
+		{
+			const Font::Glyph& glyph = font->glyphs.find(codepoint)->second;
+			formatting.kerning_advance_x(*this, glyph, codepoint);
+			add_glyph(varr, glyph, formatting.x, formatting.y, quad_index++);
+			formatting.advance_x(glyph.advance_width * font->scale * formatting.line.mul_x, codepoint);
+		}
+	}
+	if (current_batch.index_count != 0)
+		batches.push_back(current_batch);
+}
+
+float TextLayout::compute_batch(const Font::Glyph& glyph)
+{
+	for (GLuint i = 0; i < current_batch.textures.size(); ++i)
+	{
+		if (current_batch.textures[i] == glyph.texture.get())
+			return float(i);
+	}
+	if (current_batch.textures.size() == max_texture_slots)
+	{
+		batches.push_back(current_batch);
+		current_batch.index_offset += current_batch.index_count;
+		current_batch.index_count = 0;
+		current_batch.textures.clear();
+	}
+	current_batch.textures.push_back(glyph.texture.get());
+	return float(current_batch.textures.size() - 1);
+}
+
+static void set_quad_attribute(GLfloat* quad, size_t offset, float x1, float x2, float y1, float y2)
+{
+	quad[offset] = x1;
+	quad[offset + 1] = y1;
+	quad += TextLayout::STRIDE;
+	quad[offset] = x2;
+	quad[offset + 1] = y1;
+	quad += TextLayout::STRIDE;
+	quad[offset] = x2;
+	quad[offset + 1] = y2;
+	quad += TextLayout::STRIDE;
+	quad[offset] = x1;
+	quad[offset + 1] = y2;
+}
+
+void TextLayout::add_glyph(std::vector<GLfloat>& varr, const Font::Glyph& glyph, int x, int y, size_t quad_index)
+{
+	// LATER baseline offset + to y. In file similar to .kern. Makes certain characters align to baseline better.
+	// This would have to be dependent on font scaling somehow though. Since offsets are only relevant for small font scales.
+	// Even do horizontal offset that doesn't require an adjacent character. Some special unicode characters are weirdly aligned.
+	GLfloat* quad = varr.data() + quad_index * 4 * STRIDE;
+	float left = float(x);
+	float bottom = float(y - glyph.ch_y0);
+	set_quad_attribute(quad, POSITION_OFFSET, left, left + glyph.width, bottom, bottom - glyph.height);
+	float slot = compute_batch(glyph);
+	for (size_t v = 0; v < 4; ++v)
+		quad[v * STRIDE + TEX_SLOT_OFFSET] = slot;
+	::Bounds uvs = font->uvs(glyph);
+	set_quad_attribute(quad, UV_OFFSET, uvs.x1, uvs.x2, uvs.y1, uvs.y2);
+	current_batch.index_count += 6;
+}
+
+void TextLayout::format_line(size_t line, LineFormattingInfo& line_formatting) const
+{
+	line_formatting = {};
+
+	if (format.horizontal_align == HorizontalAlign::RIGHT)
+		line_formatting.add_x = outer_width() - bounds.lines[line].width;
+	else if (format.horizontal_align == HorizontalAlign::CENTER)
+		line_formatting.add_x = static_cast<int>(0.5f * (outer_width() - bounds.lines[line].width));
+	else if (format.horizontal_align == HorizontalAlign::JUSTIFY_GLYPHS)
+	{
+		if (bounds.lines[line].width)
+			line_formatting.mul_x = static_cast<float>(outer_width()) / bounds.lines[line].width;
+		line_formatting.space_mul_x = line_formatting.mul_x;
+	}
+	else if (format.horizontal_align == HorizontalAlign::JUSTIFY)
+	{
+		float num_spaces = bounds.lines[line].num_spaces + format.num_spaces_in_tab * bounds.lines[line].num_tabs;
+		if (num_spaces > 0.0f)
+			line_formatting.space_mul_x += static_cast<float>(outer_width() - bounds.lines[line].width) / (num_spaces * font->space_width);
+	}
+}
+
+TextLayout::PageFormattingInfo TextLayout::format_page() const
+{
+	PageFormattingInfo page_formatting;
+
+	if (format.vertical_align == VerticalAlign::BOTTOM)
+		page_formatting.add_y = outer_height() - bounds.inner_height;
+	else if (format.vertical_align == VerticalAlign::MIDDLE)
+		page_formatting.add_y = static_cast<int>(0.5f * (outer_height() - bounds.inner_height));
+	else if (format.vertical_align == VerticalAlign::JUSTIFY)
+	{
+		int line_height = font->line_height(format.line_spacing_mult);
+		if (bounds.inner_height != line_height)
+			page_formatting.mul_y = static_cast<float>(outer_height() - line_height) / (bounds.inner_height - line_height);
+		page_formatting.linebreak_mul_y = page_formatting.mul_y;
+	}
+	else if (format.vertical_align == VerticalAlign::JUSTIFY_LINEBREAKS)
+	{
+		int line_height = font->line_height(format.line_spacing_mult);
+		if (bounds.num_linebreaks * line_height != 0)
+			page_formatting.linebreak_mul_y += static_cast<float>(outer_height() - bounds.inner_height) / (bounds.num_linebreaks * line_height);
+	}
+
+	return page_formatting;
+}
+
+void TextLayout::FormattingData::setup(const TextLayout& layout)
+{
+	line_height = layout.font->line_height(layout.format.line_spacing_mult);
+	startX = static_cast<int>(-layout.pivot.x * layout.outer_width());
+	row = 0;
+	prev_codepoint = 0;
+	layout.format_line(row++, line);
+	x = startX + line.add_x;
+	page = layout.format_page();
+	y = static_cast<int>(roundf(-layout.font->baseline + (1.0f - layout.pivot.y) * layout.outer_height())) + layout.bounds.top_ribbon - page.add_y;
+}
+
+void TextLayout::FormattingData::next_line(const TextLayout& layout)
+{
+	layout.format_line(row++, line);
+	if (x == startX + line.add_x)
+		y -= static_cast<int>(roundf(line_height * page.linebreak_mul_y));
+	else
+		y -= static_cast<int>(roundf(line_height * page.mul_y));
+	x = startX + line.add_x;
+	prev_codepoint = 0;
+}
+
+void TextLayout::FormattingData::kerning_advance_x(const TextLayout& layout, const Font::Glyph& glyph, Codepoint codepoint)
+{
+	x += layout.font->kerning_of(prev_codepoint, codepoint, layout.font->glyphs[prev_codepoint].index, glyph.index, line.mul_x);
+}
+
+void TextLayout::BoundsFormattingData::setup(const TextLayout& layout)
+{
+	line_height = layout.font->line_height(layout.format.line_spacing_mult);
+	x = 0;
+	y = -layout.font->baseline;
+	min_ch_y0 = 0;
+	max_ch_y1 = INT_MIN;
+	line_info = {};
+	line_formatting = {};
+	first_line = true;
+	prev_codepoint = 0;
+}
+
+void TextLayout::BoundsFormattingData::next_line(TextLayout& layout)
+{
+	Bounds& bounds = layout.bounds;
+	if (x > bounds.inner_width)
+		bounds.inner_width = x;
+	line_info.width = x;
+	bounds.lines.push_back(line_info);
+	line_info = {};
+	if (x == 0)
+		++bounds.num_linebreaks;
+	x = 0;
+	y -= line_height;
+	first_line = false;
+	max_ch_y1 = INT_MIN;
+	prev_codepoint = 0;
+}
+
+void TextLayout::BoundsFormattingData::last_line(TextLayout& layout)
+{
+	Bounds& bounds = layout.bounds;
+	Font* font = layout.font;
+	if (x > bounds.inner_width)
+		bounds.inner_width = x;
+	line_info.width = x;
+	bounds.lines.push_back(line_info);
+	line_info = {};
+	if (x == 0)
+		++bounds.num_linebreaks;
+	bounds.lowest_baseline = -y;
+	bounds.top_ribbon = static_cast<int>(font->ascent * font->scale + min_ch_y0);
+	if (max_ch_y1 == INT_MAX)
+		max_ch_y1 = 0;
+	bounds.bottom_ribbon = static_cast<int>(max_ch_y1 - font->descent * font->scale);
+	bounds.inner_height = static_cast<int>(bounds.lowest_baseline - font->descent * font->scale - bounds.top_ribbon);
+}
+
+void TextLayout::BoundsFormattingData::kerning_advance_x(const TextLayout& layout, const Font::Glyph& glyph, Codepoint codepoint)
+{
+	x += layout.font->kerning_of(prev_codepoint, codepoint, layout.font->glyphs[prev_codepoint].index, glyph.index);
+}
+
+void TextLayout::BoundsFormattingData::update_min_ch_y0(const Font::Glyph& glyph)
+{
+	if (first_line && glyph.ch_y0 < min_ch_y0)
+		min_ch_y0 = glyph.ch_y0;
+}
+
+void TextLayout::BoundsFormattingData::update_max_ch_y1(const Font::Glyph& glyph)
+{
+	if (glyph.ch_y0 + glyph.height > max_ch_y1)
+		max_ch_y1 = glyph.ch_y0 + glyph.height;
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "Font.h"
+
+// CPU-side text layout and vertex generation. No GL calls are made here: glyphs that aren't cached yet are only rasterized, and
+// TextRender generates their textures through Font::upload_textures() before uploading the vertices and issuing the draw calls.
+struct TextLayout
+{
+	enum class HorizontalAlign : char
+	{
+		LEFT,
+		RIGHT,
+		CENTER,
+		JUSTIFY,
+		JUSTIFY_GLYPHS
+	};
+
+	enum class VerticalAlign : char
+	{
+		TOP,
+		MIDDLE,
+		BOTTOM,
+		JUSTIFY,
+		JUSTIFY_LINEBREAKS
+	};
+
+	struct Format
+	{
+		float line_spacing_mult = 1.0f;
+		float num_spaces_in_tab = 4;
+		HorizontalAlign horizontal_align = HorizontalAlign::LEFT;
+		VerticalAlign vertical_align = VerticalAlign::TOP;
+		// LATER underline/strikethrough/etc.
+		// background color/drop-shadow/reflection/etc.
+		int min_width = 0, min_height = 0;
+	};
+
+	struct LineInfo
+	{
+		int width = 0;
+		int num_spaces = 0;
+		int num_tabs = 0;
+	};
+
+	struct LineFormattingInfo
+	{
+		int add_x = 0;
+		float mul_x = 1.0f;
+		float space_mul_x = 1.0f;
+	};
+
+	struct PageFormattingInfo
+	{
+		int add_y = 0;
+		float mul_y = 1.0f;
+		float linebreak_mul_y = 1.0f;
+	};
+
+	struct Bounds
+	{
+		int inner_width = 0;
+		int inner_height = 0;
+		int lowest_baseline = 0;
+		int top_ribbon = 0;
+		int bottom_ribbon = 0;
+		int num_linebreaks = 0;
+		std::vector<LineInfo> lines;
+	};
+
+	struct Batch
+	{
+		size_t index_count = 0;
+		size_t index_offset = 0;
+		std::vector<const Image*> textures; // tids aren't known until the font uploads its textures
+	};
+
+	// Matches the attributes of text.vert: vertex position, texture slot, UVs.
+	static constexpr size_t POSITION_OFFSET = 0;
+	static constexpr size_t TEX_SLOT_OFFSET = 2;
+	static constexpr size_t UV_OFFSET = 3;
+	static constexpr size_t STRIDE = 5;
+
+	Font* font = nullptr;
+	Format format = {};
+
+	TextLayout(Font* font = nullptr) : font(font) {}
+
+	void build_layout(UTF::StringView text);
+	void generate_vertices(UTF::StringView text, glm::vec2 pivot, size_t max_texture_slots, std::vector<GLfloat>& varr);
+
+	const Bounds& get_bounds() const { return bounds; }
+	size_t num_printable_glyphs() const { return num_glyphs; }
+	const std::vector<Batch>& get_batches() const { return batches; }
+	int outer_width() const { return std::max(bounds.inner_width, format.min_width); }
+	int outer_height() const { return std::max(bounds.inner_height, format.min_height); }
+
+private:
+	Bounds bounds;
+	size_t num_glyphs = 0;
+	std::vector<Batch> batches;
+	Batch current_batch;
+	size_t max_texture_slots = 1;
+	glm::vec2 pivot = {};
+
+	float compute_batch(const Font::Glyph& glyph);
+	void add_glyph(std::vector<GLfloat>& varr, const Font::Glyph& glyph, int x, int y, size_t quad_index);
+	void format_line(size_t line, LineFormattingInfo& line_formatting) const;
+	PageFormattingInfo format_page() const;
+
+	struct FormattingData
+	{
+		int row = 0;
+		int x = 0, y = 0;
+		Codepoint prev_codepoint = 0;
+		int startX = 0, line_height = 0;
+		LineFormattingInfo line = {};
+		PageFormattingInfo page = {};
+
+		void setup(const TextLayout& layout);
+		void next_line(const TextLayout& layout);
+		void advance_x(int amount) { x += amount; }
+		void advance_x(int amount, Codepoint codepoint) { x += amount; prev_codepoint = codepoint; }
+		void advance_x(float amount) { x += static_cast<int>(roundf(amount)); }
+		void advance_x(float amount, Codepoint codepoint) { x += static_cast<int>(roundf(amount)); prev_codepoint = codepoint; }
+		void kerning_advance_x(const TextLayout& layout, const Font::Glyph& glyph, Codepoint codepoint);
+	} formatting;
+
+	struct BoundsFormattingData
+	{
+		int x = 0, y = 0;
+		Codepoint prev_codepoint = 0;
+		int line_height = 0;
+		int min_ch_y0 = 0, max_ch_y1 = 0;
+		bool first_line = true;
+		LineInfo line_info = {};
+		LineFormattingInfo line_formatting = {};
+
+		void setup(const TextLayout& layout);
+		void next_line(TextLayout& layout);
+		void last_line(TextLayout& layout);
+		void advance_x(int amount) { x += amount; }
+		void advance_x(int amount, Codepoint codepoint) { x += amount; prev_codepoint = codepoint; }
+		void advance_x(float amount) { x += static_cast<int>(roundf(amount)); }
+		void advance_x(float amount, Codepoint codepoint) { x += static_cast<int>(roundf(amount)); prev_codepoint = codepoint; }
+		void kerning_advance_x(const TextLayout& layout, const Font::Glyph& glyph, Codepoint codepoint);
+		void update_min_ch_y0(const Font::Glyph& glyph);
+		void update_max_ch_y1(const Font::Glyph& glyph);
+	} bounds_formatting;
+};
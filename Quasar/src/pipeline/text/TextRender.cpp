@@ -2,9 +2,7 @@
 
 #include <glm/gtc/type_ptr.inl>
 
-#include "ImplUtility.h"
 #include "variety/GLutility.h"
-#include "../render/Uniforms.h"
 
 static Shader text_shader_instance()
 {
@@ -14,12 +12,14 @@ static Shader text_shader_instance()
 void TextRender::init(glm::vec2 pivot)
 {
 	ir->set_shader(&shader);
+	uniforms.mvp = UniformHandle<glm::mat3>(shader, "u_MVP");
+	uniforms.fore_color = UniformHandle<glm::vec4>(shader, "u_ForeColor");
 	self.pivot = pivot;
 	send_fore_color();
 }
 
 TextRender::TextRender(Font* font, const UTF::String& text, glm::vec2 pivot)
-	: W_IndexedRenderable(nullptr), shader(text_shader_instance()), font(font)
+	: W_IndexedRenderable(nullptr), shader(text_shader_instance()), layout(font)
 {
 	init(pivot);
 	if (!text.empty())
@@ -27,7 +27,7 @@ TextRender::TextRender(Font* font, const UTF::String& text, glm::vec2 pivot)
 }
 
 TextRender::TextRender(Font* font, UTF::String&& text, glm::vec2 pivot)
-	: W_IndexedRenderable(nullptr), shader(text_shader_instance()), font(font)
+	: W_IndexedRenderable(nullptr), shader(text_shader_instance()), layout(font)
 {
 	init(pivot);
 	if (!text.empty())
@@ -37,7 +37,7 @@ TextRender::TextRender(Font* font, UTF::String&& text, glm::vec2 pivot)
 TextRender::TextRender(FontRange& frange, float font_size, const UTF::String& text, glm::vec2 pivot)
 	: W_IndexedRenderable(nullptr), shader(text_shader_instance())
 {
-	float fmult = frange.get_font_and_multiplier(font_size, font);
+	float fmult = frange.get_font_and_multiplier(font_size, layout.font);
 	self.transform.scale = { fmult, fmult };
 	init(pivot);
 	if (!text.empty())
@@ -47,7 +47,7 @@ TextRender::TextRender(FontRange& frange, float font_size, const UTF::String& te
 TextRender::TextRender(FontRange& frange, float font_size, UTF::String&& text, glm::vec2 pivot)
 	: W_IndexedRenderable(nullptr), shader(text_shader_instance())
 {
-	float fmult = frange.get_font_and_multiplier(font_size, font);
+	float fmult = frange.get_font_and_multiplier(font_size, layout.font);
 	self.transform.scale = { fmult, fmult };
 	init(pivot);
 	if (!text.empty())
@@ -56,282 +56,34 @@ TextRender::TextRender(FontRange& frange, float font_size, UTF::String&& text, g
 
 void TextRender::draw()
 {
-	for (const auto& batch : batches)
+	for (const auto& batch : layout.get_batches())
 	{
-		for (GLuint i = 0; i < batch.tids.size(); ++i)
-			bind_texture(batch.tids[i], i);
+		for (GLuint i = 0; i < batch.textures.size(); ++i)
+			bind_texture(batch.textures[i]->tid, i);
 		ir->draw(batch.index_count, batch.index_offset);
 	}
 }
 
 void TextRender::send_vp(const glm::mat3 vp) const
 {
-	bind_shader(shader);
-	Uniforms::send_matrix3(shader, "u_MVP", vp * global_matrix());
-	unbind_shader();
+	uniforms.mvp.send(vp * global_matrix());
 }
 
 void TextRender::send_fore_color() const
 {
-	bind_shader(shader);
-	Uniforms::send_4(shader, "u_ForeColor", fore_color.as_vec());
+	uniforms.fore_color.send(fore_color.as_vec());
 }
 
 void TextRender::update_text()
 {
-	ir->varr.clear();
-	ir->iarr.clear();
-	build_layout();
+	layout.build_layout(text);
 	setup_renderable();
 }
 
-void TextRender::build_layout()
-{
-	num_printable_glyphs = 0;
-	bounds = {};
-	bounds_formatting.setup(*this);
-	auto iter = text.begin();
-	while (iter)
-	{
-		Codepoint codepoint = iter.advance();
-
-		if (codepoint == ' ')
-		{
-			bounds_formatting.advance_x(font->space_width, 0);
-			++bounds_formatting.line_info.num_spaces;
-		}
-		else if (codepoint == '\t')
-		{
-			bounds_formatting.advance_x(font->space_width * format.num_spaces_in_tab, 0);
-			++bounds_formatting.line_info.num_tabs;
-		}
-		else if (carriage_return_2(codepoint, iter ? iter.codepoint() : 0))
-		{
-			bounds_formatting.next_line(*this);
-			++iter;
-		}
-		else if (carriage_return_1(codepoint))
-		{
-			bounds_formatting.next_line(*this);
-		}
-		else if (font->cache(codepoint))
-		{
-			const Font::Glyph& glyph = font->glyphs[codepoint];
-			bounds_formatting.kerning_advance_x(*this, glyph, codepoint);
-			bounds_formatting.advance_x(glyph.advance_width * font->scale, codepoint);
-			bounds_formatting.update_min_ch_y0(glyph);
-			bounds_formatting.update_max_ch_y1(glyph);
-			++num_printable_glyphs;
-		}
-	}
-	bounds_formatting.last_line(*this);
-}
-
 void TextRender::setup_renderable()
 {
-	batches.clear();
-	current_batch = {};
-	ir->fill_iarr_with_quads(num_printable_glyphs);
-	ir->push_back_vertices(num_printable_glyphs * 4);
-	size_t quad_index = 0;
-	formatting.setup(*this);
-	auto iter = text.begin();
-	while (iter)
-	{
-		Codepoint codepoint = iter.advance();
-
-		if (codepoint == ' ')
-			formatting.advance_x(font->space_width * formatting.line.space_mul_x, 0);
-		else if (codepoint == '\t')
-			formatting.advance_x(font->space_width * format.num_spaces_in_tab * formatting.line.space_mul_x, 0);
-		else if (carriage_return_2(codepoint, iter ? iter.codepoint() : 0))
-		{
-			formatting.next_line(*this);
-			++iter;
-		}
-		else if (carriage_return_1(codepoint))
-			formatting.next_line(*this);
-		else if (font->cache(codepoint))
-		{
-			const Font::Glyph& glyph = font->glyphs.find(codepoint)->second;
-			formatting.kerning_advance_x(*this, glyph, codepoint);
-			add_glyph_to_ir(glyph, formatting.x, formatting.y, quad_index++);
-			formatting.advance_x(glyph.advance_width * font->scale * formatting.line.mul_x, codepoint);
-		}
-	}
-	if (current_batch.index_count != 0)
-		batches.push_back(current_batch);
+	layout.generate_vertices(text, self.pivot, GLC.max_texture_image_units, ir->varr);
+	layout.font->upload_textures();
+	ir->fill_iarr_with_quads(layout.num_printable_glyphs());
 	ir->send_both_buffers_resized();
 }
-
-float TextRender::compute_batch(const Font::Glyph& glyph)
-{
-	for (GLuint i = 0; i < current_batch.tids.size(); ++i)
-	{
-		if (current_batch.tids[i] == glyph.texture->tid)
-			return float(i);
-	}
-	if (current_batch.tids.size() == GLC.max_texture_image_units)
-	{
-		batches.push_back(current_batch);
-		current_batch.index_offset += current_batch.index_count;
-		current_batch.index_count = 0;
-		current_batch.tids.clear();
-	}
-	current_batch.tids.push_back(glyph.texture->tid);
-	return float(current_batch.tids.size() - 1);
-}
-
-void TextRender::add_glyph_to_ir(const Font::Glyph& glyph, int x, int y, size_t quad_index)
-{
-	// LATER baseline offset + to y. In file similar to .kern. Makes certain characters align to baseline better.
-	// This would have to be dependent on font scaling somehow though. Since offsets are only relevant for small font scales.
-	// Even do horizontal offset that doesn't require an adjacent character. Some special unicode characters are weirdly aligned.
-	FlatTransform local{ { float(x), float(y - glyph.ch_y0) }, { float(glyph.width), -float(glyph.height) } };
-	unsigned short vertex_offset = (unsigned short)quad_index * 4;
-	Utils::set_vertex_pos_attributes(*ir, WidgetPlacement{ local, {} }, vertex_offset, 0, false);
-	Utils::set_four_attributes(*ir, compute_batch(glyph), vertex_offset, 1, false);
-	Utils::set_uv_attributes(*ir, font->uvs(glyph), vertex_offset, 2, false);
-	current_batch.index_count += 6;
-}
-
-void TextRender::format_line(size_t line, LineFormattingInfo& line_formatting) const
-{
-	line_formatting = {};
-
-	if (format.horizontal_align == HorizontalAlign::RIGHT)
-		line_formatting.add_x = outer_width() - bounds.lines[line].width;
-	else if (format.horizontal_align == HorizontalAlign::CENTER)
-		line_formatting.add_x = static_cast<int>(0.5f * (outer_width() - bounds.lines[line].width));
-	else if (format.horizontal_align == HorizontalAlign::JUSTIFY_GLYPHS)
-	{
-		if (bounds.lines[line].width)
-			line_formatting.mul_x = static_cast<float>(outer_width()) / bounds.lines[line].width;
-		line_formatting.space_mul_x = line_formatting.mul_x;
-	}
-	else if (format.horizontal_align == HorizontalAlign::JUSTIFY)
-	{
-		float num_spaces = bounds.lines[line].num_spaces + format.num_spaces_in_tab * bounds.lines[line].num_tabs;
-		if (num_spaces > 0.0f)
-			line_formatting.space_mul_x += static_cast<float>(outer_width() - bounds.lines[line].width) / (num_spaces * font->space_width);
-	}
-}
-
-TextRender::PageFormattingInfo TextRender::format_page() const
-{
-	PageFormattingInfo page_formatting;
-
-	if (format.vertical_align == VerticalAlign::BOTTOM)
-		page_formatting.add_y = outer_height() - bounds.inner_height;
-	else if (format.vertical_align == VerticalAlign::MIDDLE)
-		page_formatting.add_y = static_cast<int>(0.5f * (outer_height() - bounds.inner_height));
-	else if (format.vertical_align == VerticalAlign::JUSTIFY)
-	{
-		int line_height = font->line_height(format.line_spacing_mult);
-		if (bounds.inner_height != line_height)
-			page_formatting.mul_y = static_cast<float>(outer_height() - line_height) / (bounds.inner_height - line_height);
-		page_formatting.linebreak_mul_y = page_formatting.mul_y;
-	}
-	else if (format.vertical_align == VerticalAlign::JUSTIFY_LINEBREAKS)
-	{
-		int line_height = font->line_height(format.line_spacing_mult);
-		if (bounds.num_linebreaks * line_height != 0)
-			page_formatting.linebreak_mul_y += static_cast<float>(outer_height() - bounds.inner_height) / (bounds.num_linebreaks * line_height);
-	}
-
-	return page_formatting;
-}
-
-void TextRender::FormattingData::setup(const TextRender& text_render)
-{
-	line_height = text_render.font->line_height(text_render.format.line_spacing_mult);
-	startX = static_cast<int>(-text_render.self.pivot.x * text_render.outer_width());
-	row = 0;
-	prev_codepoint = 0;
-	text_render.format_line(row++, line);
-	x = startX + line.add_x;
-	page = text_render.format_page();
-	y = static_cast<int>(roundf(-text_render.font->baseline + (1.0f - text_render.self.pivot.y) * text_render.outer_height())) + text_render.bounds.top_ribbon - page.add_y;
-}
-
-void TextRender::FormattingData::next_line(const TextRender& text_render)
-{
-	text_render.format_line(row++, line);
-	if (x == startX + line.add_x)
-		y -= static_cast<int>(roundf(line_height * page.linebreak_mul_y));
-	else
-		y -= static_cast<int>(roundf(line_height * page.mul_y));
-	x = startX + line.add_x;
-	prev_codepoint = 0;
-}
-
-void TextRender::FormattingData::kerning_advance_x(const TextRender& text_render, const Font::Glyph& glyph, Codepoint codepoint)
-{
-	x += text_render.font->kerning_of(prev_codepoint, codepoint, text_render.font->glyphs[prev_codepoint].index, glyph.index, line.mul_x);
-}
-
-void TextRender::BoundsFormattingData::setup(const TextRender& text_render)
-{
-	line_height = text_render.font->line_height(text_render.format.line_spacing_mult);
-	x = 0;
-	y = -text_render.font->baseline;
-	min_ch_y0 = 0;
-	max_ch_y1 = INT_MIN;
-	line_info = {};
-	line_formatting = {};
-	first_line = true;
-	prev_codepoint = 0;
-}
-
-void TextRender::BoundsFormattingData::next_line(TextRender& text_render)
-{
-	Bounds& bounds = text_render.bounds;
-	if (x > bounds.inner_width)
-		bounds.inner_width = x;
-	line_info.width = x;
-	bounds.lines.push_back(line_info);
-	line_info = {};
-	if (x == 0)
-		++bounds.num_linebreaks;
-	x = 0;
-	y -= line_height;
-	first_line = false;
-	max_ch_y1 = INT_MIN;
-	prev_codepoint = 0;
-}
-
-void TextRender::BoundsFormattingData::last_line(TextRender& text_render)
-{
-	Bounds& bounds = text_render.bounds;
-	Font* font = text_render.font;
-	if (x > bounds.inner_width)
-		bounds.inner_width = x;
-	line_info.width = x;
-	bounds.lines.push_back(line_info);
-	line_info = {};
-	if (x == 0)
-		++bounds.num_linebreaks;
-	bounds.lowest_baseline = -y;
-	bounds.top_ribbon = static_cast<int>(font->ascent * font->scale + min_ch_y0);
-	if (max_ch_y1 == INT_MAX)
-		max_ch_y1 = 0;
-	bounds.bottom_ribbon = static_cast<int>(max_ch_y1 - font->descent * font->scale);
-	bounds.inner_height = static_cast<int>(bounds.lowest_baseline - font->descent * font->scale - bounds.top_ribbon);
-}
-
-void TextRender::BoundsFormattingData::kerning_advance_x(const TextRender& text_render, const Font::Glyph& glyph, Codepoint codepoint)
-{
-	x += text_render.font->kerning_of(prev_codepoint, codepoint, text_render.font->glyphs[prev_codepoint].index, glyph.index);
-}
-
-void TextRender::BoundsFormattingData::update_min_ch_y0(const Font::Glyph& glyph)
-{
-	if (first_line && glyph.ch_y0 < min_ch_y0)
-		min_ch_y0 = glyph.ch_y0;
-}
-
-void TextRender::BoundsFormattingData::update_max_ch_y1(const Font::Glyph& glyph)
-{
-	if (glyph.ch_y0 + glyph.height > max_ch_y1)
-		max_ch_y1 = glyph.ch_y0 + glyph.height;
-}
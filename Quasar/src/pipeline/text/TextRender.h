@@ -1,17 +1,23 @@
 #pragma once
 
-#include "Font.h"
+#include "TextLayout.h"
 #include "../render/Renderable.h"
+#include "../render/Uniforms.h"
 #include "edit/color/Color.h"
 #include "../widgets/Widget.h"
 
 struct TextRender : public W_IndexedRenderable
 {
 	Shader shader;
-	Font* font = nullptr;
+	TextLayout layout;
 
 private:
 	UTF::String text;
+	struct
+	{
+		UniformHandle<glm::mat3> mvp;
+		UniformHandle<glm::vec4> fore_color;
+	} uniforms;
 	
 	void init(glm::vec2 pivot);
 
@@ -23,68 +29,11 @@ public:
 	TextRender(const TextRender&) = delete;
 	TextRender(TextRender&&) noexcept = delete;
 
-	enum class HorizontalAlign : char
-	{
-		LEFT,
-		RIGHT,
-		CENTER,
-		JUSTIFY,
-		JUSTIFY_GLYPHS
-	};
-
-	enum class VerticalAlign : char
-	{
-		TOP,
-		MIDDLE,
-		BOTTOM,
-		JUSTIFY,
-		JUSTIFY_LINEBREAKS
-	};
+	typedef TextLayout::HorizontalAlign HorizontalAlign;
+	typedef TextLayout::VerticalAlign VerticalAlign;
+	typedef TextLayout::Format Format;
+	typedef TextLayout::Bounds Bounds;
 
-	struct Format
-	{
-		float line_spacing_mult = 1.0f;
-		float num_spaces_in_tab = 4;
-		HorizontalAlign horizontal_align = HorizontalAlign::LEFT;
-		VerticalAlign vertical_align = VerticalAlign::TOP;
-		// LATER underline/strikethrough/etc.
-		// background color/drop-shadow/reflection/etc.
-		int min_width = 0, min_height = 0;
-	};
-
-	struct LineInfo
-	{
-		int width = 0;
-		int num_spaces = 0;
-		int num_tabs = 0;
-	};
-
-	struct LineFormattingInfo
-	{
-		int add_x = 0;
-		float mul_x = 1.0f;
-		float space_mul_x = 1.0f;
-	};
-
-	struct PageFormattingInfo
-	{
-		int add_y = 0;
-		float mul_y = 1.0f;
-		float linebreak_mul_y = 1.0f;
-	};
-
-	struct Bounds
-	{
-		int inner_width = 0;
-		int inner_height = 0;
-		int lowest_baseline = 0;
-		int top_ribbon = 0;
-		int bottom_ribbon = 0;
-		int num_linebreaks = 0;
-		std::vector<LineInfo> lines;
-	};
-
-	Format format = {};
 	RGBA fore_color = RGBA(1.0f, 1.0f, 1.0f, 1.0f);
 
 	virtual void draw() override;
@@ -96,74 +45,17 @@ public:
 	void send_vp(const glm::mat3 vp) const;
 	void send_fore_color() const;
 
-	Bounds get_bounds() const { return bounds; }
-	int outer_width() const { return std::max(bounds.inner_width, format.min_width); }
-	int outer_height() const { return std::max(bounds.inner_height, format.min_height); }
+	Format& format() { return layout.format; }
+	const Format& format() const { return layout.format; }
+	Bounds get_bounds() const { return layout.get_bounds(); }
+	int outer_width() const { return layout.outer_width(); }
+	int outer_height() const { return layout.outer_height(); }
 
 private:
-	struct Batch
-	{
-		size_t index_count = 0;
-		size_t index_offset = 0;
-		std::vector<GLuint> tids;
-	};
-	std::vector<Batch> batches;
-	Batch current_batch;
-
 	void update_text();
-	size_t num_printable_glyphs = 0;
-	void build_layout();
 
 public:
 	void setup_renderable();
-
-private:
-	float compute_batch(const Font::Glyph& glyph);
-	void add_glyph_to_ir(const Font::Glyph& glyph, int x, int y, size_t quad_index);
-	void format_line(size_t line, LineFormattingInfo& line_formatting) const;
-	PageFormattingInfo format_page() const;
-
-	Bounds bounds;
-
-	struct FormattingData
-	{
-		int row = 0;
-		int x = 0, y = 0;
-		Codepoint prev_codepoint = 0;
-		int startX = 0, line_height = 0;
-		LineFormattingInfo line = {};
-		PageFormattingInfo page = {};
-
-		void setup(const TextRender& text_render);
-		void next_line(const TextRender& text_render);
-		void advance_x(int amount) { x += amount; }
-		void advance_x(int amount, Codepoint codepoint) { x += amount; prev_codepoint = codepoint; }
-		void advance_x(float amount) { x += static_cast<int>(roundf(amount)); }
-		void advance_x(float amount, Codepoint codepoint) { x += static_cast<int>(roundf(amount)); prev_codepoint = codepoint; }
-		void kerning_advance_x(const TextRender& text_render, const Font::Glyph& glyph, Codepoint codepoint);
-	} formatting;
-
-	struct BoundsFormattingData
-	{
-		int x = 0, y = 0;
-		Codepoint prev_codepoint = 0;
-		int line_height = 0;
-		int min_ch_y0 = 0, max_ch_y1 = 0;
-		bool first_line = true;
-		LineInfo line_info = {};
-		LineFormattingInfo line_formatting = {};
-
-		void setup(const TextRender& text_render);
-		void next_line(TextRender& text_render);
-		void last_line(TextRender& text_render);
-		void advance_x(int amount) { x += amount; }
-		void advance_x(int amount, Codepoint codepoint) { x += amount; prev_codepoint = codepoint; }
-		void advance_x(float amount) { x += static_cast<int>(roundf(amount)); }
-		void advance_x(float amount, Codepoint codepoint) { x += static_cast<int>(roundf(amount)); prev_codepoint = codepoint; }
-		void kerning_advance_x(const TextRender& text_render, const Font::Glyph& glyph, Codepoint codepoint);
-		void update_min_ch_y0(const Font::Glyph& glyph);
-		void update_max_ch_y1(const Font::Glyph& glyph);
-	} bounds_formatting;
 };
 
 inline TextRender& tr_wget(Widget& w, size_t i)
@@ -47,8 +47,8 @@ void TButton::init(const WidgetPlacement& wp, std::shared_ptr<TextRender>&& txt)
 		}
 		};
 	self = wp;
-	text().format.horizontal_align = TextRender::HorizontalAlign::CENTER;
-	text().format.vertical_align = TextRender::VerticalAlign::MIDDLE;
+	text().format().horizontal_align = TextRender::HorizontalAlign::CENTER;
+	text().format().vertical_align = TextRender::VerticalAlign::MIDDLE;
 	text().self.transform.scale = text().self.transform.scale / self.transform.scale;
 }
 
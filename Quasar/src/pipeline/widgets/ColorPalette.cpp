@@ -4,11 +4,11 @@
 #include <imgui/imgui_internal.h>
 
 #include "ImplUtility.h"
-#include "../render/Uniforms.h"
 #include "RoundRect.h"
 #include "user/Machine.h"
 #include "Button.h"
 #include "ColorPicker.h"
+#include "edit/color/ColorHistogram.h"
 
 struct ColorOverwriteAction : public ActionBase
 {
@@ -897,6 +897,9 @@ ColorPalette::ColorPalette(glm::mat3* vp, MouseButtonHandler& parent_mb_handler,
 	outline_rect_shader(FileSystem::shader_path("palette/outline_rect.vert"), FileSystem::shader_path("palette/outline_rect.frag")),
 	round_rect_shader(FileSystem::shader_path("round_rect.vert"), FileSystem::shader_path("round_rect.frag")), reflection(reflection), scheme(std::make_shared<ColorScheme>())
 {
+	grid_uniforms.vp = UniformHandle<glm::mat3>(grid_shader, "u_VP");
+	grid_uniforms.col_proportion = UniformHandle<float>(grid_shader, "u_ColProportion");
+	grid_uniforms.row_proportion = UniformHandle<float>(grid_shader, "u_RowProportion");
 	initialize_widget();
 	connect_input_handlers();
 	new_subpalette(false); // always have at least one subpalette
@@ -934,10 +937,7 @@ void ColorPalette::process()
 
 void ColorPalette::send_vp()
 {
-	Uniforms::send_matrix3(color_square_shader, "u_VP", *vp);
-	Uniforms::send_matrix3(grid_shader, "u_VP", grid_vp());
-	Uniforms::send_matrix3(outline_rect_shader, "u_VP", *vp);
-	Uniforms::send_matrix3(round_rect_shader, "u_VP", *vp);
+	grid_uniforms.vp.send(grid_vp());
 	sync_widget_with_vp();
 }
 
@@ -1064,6 +1064,34 @@ void ColorPalette::delete_current_subpalette(bool create_action)
 		
 }
 
+void ColorPalette::append_subpalette(const std::string& name_prefix, const std::vector<PixelRGBA>& colors, bool create_action)
+{
+	std::vector<RGBA> rgba_colors;
+	rgba_colors.reserve(colors.size());
+	for (PixelRGBA color : colors)
+		rgba_colors.push_back(color.to_rgba());
+
+	// The new scheme shares the existing subschemes, so undoing the import restores them as they were.
+	std::vector<std::shared_ptr<ColorSubscheme>> subschemes = scheme->subschemes;
+	subschemes.push_back(std::make_shared<ColorSubscheme>(name_prefix + "#" + std::to_string(subschemes.size()), std::move(rgba_colors)));
+	import_color_scheme(std::make_shared<ColorScheme>(std::move(subschemes)), create_action);
+	switch_to_subpalette(num_subpalettes() - 1, true);
+}
+
+void ColorPalette::extract_subpalette(const Buffer& buf, size_t max_colors, bool create_action)
+{
+	std::vector<ColorCount> histogram = color_histogram(buf);
+	std::erase_if(histogram, [](const ColorCount& cc) { return cc.color.a == 0; });
+	if (histogram.empty())
+		return;
+	keep_most_frequent_colors(histogram, max_colors);
+	std::vector<PixelRGBA> colors;
+	colors.reserve(histogram.size());
+	for (const ColorCount& cc : histogram)
+		colors.push_back(cc.color);
+	append_subpalette("extracted", colors, create_action);
+}
+
 void ColorPalette::switch_to_subpalette(size_t pos, bool update_gfx)
 {
 	if (current_subscheme != pos && pos < num_subpalettes())
@@ -1432,8 +1460,8 @@ void ColorPalette::set_grid_metrics(int col, int row, bool sync)
 	_row_count = row;
 	grid_offset_y = -wp_at(BACKGROUND).transform.scale.y + grid_padding_y1 + grid_padding_y2 + (row - 1) * SQUARE_SEP + SQUARE_SIZE;
 
-	Uniforms::send_1(grid_shader, "u_ColProportion", 1.0f / col_count());
-	Uniforms::send_1(grid_shader, "u_RowProportion", 1.0f / row_count());
+	grid_uniforms.col_proportion.send(1.0f / col_count());
+	grid_uniforms.row_proportion.send(1.0f / row_count());
 	for (int i = 0; i < num_subpalettes(); ++i)
 	{
 		get_subpalette(i).self.transform.position.y = subpalette_pos_y();
@@ -1442,7 +1470,7 @@ void ColorPalette::set_grid_metrics(int col, int row, bool sync)
 	if (sync)
 	{
 		sync_widget_with_vp();
-		Uniforms::send_matrix3(grid_shader, "u_VP", grid_vp());
+		grid_uniforms.vp.send(grid_vp());
 	}
 }
 
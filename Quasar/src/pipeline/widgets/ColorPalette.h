@@ -3,6 +3,7 @@
 #include "edit/color/ColorScheme.h"
 #include "Widget.h"
 #include "user/Platform.h"
+#include "../render/Uniforms.h"
 
 struct ColorSubpalette : public Widget
 {
@@ -113,6 +114,12 @@ class ColorPalette : public Widget
 
 	Shader color_square_shader, grid_shader, outline_rect_shader, round_rect_shader;
 	glm::mat3* vp;
+	// grid_shader has its own view, so it doesn't read the panel's ViewBlock.
+	struct
+	{
+		UniformHandle<glm::mat3> vp;
+		UniformHandle<float> col_proportion, row_proportion;
+	} grid_uniforms;
 
 	MouseButtonHandler& parent_mb_handler;
 	MouseButtonHandler mb_handler;
@@ -192,6 +199,8 @@ public:
 	void rename_subpalette();
 	void delete_subpalette(size_t pos);
 	void delete_current_subpalette(bool create_action);
+	void append_subpalette(const std::string& name_prefix, const std::vector<PixelRGBA>& colors, bool create_action);
+	void extract_subpalette(const struct Buffer& buf, size_t max_colors, bool create_action);
 	void switch_to_subpalette(size_t pos, bool update_gfx);
 	void switch_to_subpalette(ColorSubpalette* subpalette, bool update_gfx);
 	size_t num_subpalettes() const;
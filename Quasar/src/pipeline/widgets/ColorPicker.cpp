@@ -74,15 +74,34 @@ const float button_wheel_w = 70;
 const float button_graphic_w = 80;
 const float button_rgb_w = 45;
 
-void ColorPicker::send_gradient_color_uniform(const Shader& shader, GradientIndex index, ColorFrame color)
+void ColorPicker::send_gradient_color_uniform(GradientIndex index, ColorFrame color) const
 {
-	Uniforms::send_4(shader, "u_GradientColors[0]", color.rgba().as_vec(), (GLint)index);
+	glm::vec4 value = color.rgba().as_vec();
+	GLint i = (GLint)index;
+	if (gradient_colors.values[i] != value)
+	{
+		gradient_colors.values[i] = value;
+		gradient_colors.dirty_begin = std::min(gradient_colors.dirty_begin, i);
+		gradient_colors.dirty_end = std::max(gradient_colors.dirty_end, i + 1);
+	}
+}
+
+void ColorPicker::flush_gradient_colors() const
+{
+	gradient_colors.ubo.bind_base(UniformBlockBinding::GRADIENT_COLORS);
+	if (gradient_colors.dirty_begin < gradient_colors.dirty_end)
+	{
+		gradient_colors.ubo.send(gradient_colors.dirty_begin * sizeof(glm::vec4), (gradient_colors.dirty_end - gradient_colors.dirty_begin) * sizeof(glm::vec4),
+			gradient_colors.values.data() + gradient_colors.dirty_begin);
+		gradient_colors.dirty_begin = (GLint)GradientIndex::_MAX_GRADIENT_COLORS;
+		gradient_colors.dirty_end = 0;
+	}
 }
 
 // LATER maybe input handler connections should be made by parent, not child, so that there's no need to pass them in constructor.
 ColorPicker::ColorPicker(glm::mat3* vp, MouseButtonHandler& parent_mb_handler, KeyHandler& parent_key_handler, const Reflection& reflection)
 	: quad_shader(FileSystem::shader_path("gradients/quad.vert"), FileSystem::shader_path("gradients/quad.frag.tmpl"),
-		{ {"$MAX_GRADIENT_COLORS", std::to_string((int)GradientIndex::_MAX_GRADIENT_COLORS) } }),
+		{ {"$MAX_GRADIENT_COLORS", std::to_string((int)GradientIndex::_MAX_GRADIENT_COLORS) }, { "$GRADIENT_COLORS_BINDING", std::to_string(UniformBlockBinding::GRADIENT_COLORS) } }),
 	linear_hue_shader(FileSystem::shader_path("gradients/linear_hue.vert"), FileSystem::shader_path("gradients/linear_hue.frag")),
 	hue_wheel_w_shader(FileSystem::shader_path("gradients/hue_wheel_w.vert"), FileSystem::shader_path("gradients/hue_wheel_w.frag")),
 	linear_lightness_shader(FileSystem::shader_path("gradients/linear_lightness.vert"), FileSystem::shader_path("gradients/linear_lightness.frag")),
@@ -90,9 +109,11 @@ ColorPicker::ColorPicker(glm::mat3* vp, MouseButtonHandler& parent_mb_handler, K
 	round_rect_shader(FileSystem::shader_path("round_rect.vert"), FileSystem::shader_path("round_rect.frag")),
 	Widget(_W_COUNT), parent_mb_handler(parent_mb_handler), parent_key_handler(parent_key_handler), vp(vp), reflection(reflection)
 {
-	send_gradient_color_uniform(quad_shader, GradientIndex::BLACK, ColorFrame(HSV(0.0f, 0.0f, 0.0f)));
-	send_gradient_color_uniform(quad_shader, GradientIndex::WHITE, ColorFrame(HSV(0.0f, 0.0f, 1.0f)));
-	send_gradient_color_uniform(quad_shader, GradientIndex::TRANSPARENT, ColorFrame(0));
+	uniforms.wheel_value = UniformHandle<float>(hue_wheel_w_shader, "u_Value");
+	uniforms.lightness_hue = UniformHandle<float>(linear_lightness_shader, "u_Hue");
+	send_gradient_color_uniform(GradientIndex::BLACK, ColorFrame(HSV(0.0f, 0.0f, 0.0f)));
+	send_gradient_color_uniform(GradientIndex::WHITE, ColorFrame(HSV(0.0f, 0.0f, 1.0f)));
+	send_gradient_color_uniform(GradientIndex::TRANSPARENT, ColorFrame(0));
 	initialize_widget();
 	connect_input_handlers();
 	//set_pri_color(ColorFrame(), false);
@@ -101,6 +122,7 @@ ColorPicker::ColorPicker(glm::mat3* vp, MouseButtonHandler& parent_mb_handler, K
 
 void ColorPicker::draw()
 {
+	flush_gradient_colors();
 	rr_wget(*this, BACKGROUND).draw();
 	cp_render_gui_back();
 	ur_wget(*this, ALPHA_SLIDER).draw(); // LATER bool member on ColorPicker to enable/disable alpha support
@@ -515,12 +537,6 @@ void ColorPicker::set_state(State _state)
 
 void ColorPicker::send_vp()
 {
-	Uniforms::send_matrix3(quad_shader, "u_VP", *vp);
-	Uniforms::send_matrix3(linear_hue_shader, "u_VP", *vp);
-	Uniforms::send_matrix3(hue_wheel_w_shader, "u_VP", *vp);
-	Uniforms::send_matrix3(linear_lightness_shader, "u_VP", *vp);
-	Uniforms::send_matrix3(circle_cursor_shader, "u_VP", *vp);
-	Uniforms::send_matrix3(round_rect_shader, "u_VP", *vp);
 	sync_widget_with_vp();
 }
 
@@ -588,17 +604,17 @@ void ColorPicker::initialize_widget()
 	setup_circle_cursor(RGB_R_SLIDER_CURSOR);
 	setup_gradient(RGB_R_SLIDER, (GLint)GradientIndex::BLACK, (GLint)GradientIndex::RGB_R_SLIDER,
 		(GLint)GradientIndex::BLACK, (GLint)GradientIndex::RGB_R_SLIDER);
-	send_gradient_color_uniform(quad_shader, GradientIndex::RGB_R_SLIDER, RGB(0xFF0000));
+	send_gradient_color_uniform(GradientIndex::RGB_R_SLIDER, RGB(0xFF0000));
 	setup_rect_uvs(RGB_G_SLIDER);
 	setup_circle_cursor(RGB_G_SLIDER_CURSOR);
 	setup_gradient(RGB_G_SLIDER, (GLint)GradientIndex::BLACK, (GLint)GradientIndex::RGB_G_SLIDER,
 		(GLint)GradientIndex::BLACK, (GLint)GradientIndex::RGB_G_SLIDER);
-	send_gradient_color_uniform(quad_shader, GradientIndex::RGB_G_SLIDER, RGB(0x00FF00));
+	send_gradient_color_uniform(GradientIndex::RGB_G_SLIDER, RGB(0x00FF00));
 	setup_rect_uvs(RGB_B_SLIDER);
 	setup_circle_cursor(RGB_B_SLIDER_CURSOR);
 	setup_gradient(RGB_B_SLIDER, (GLint)GradientIndex::BLACK, (GLint)GradientIndex::RGB_B_SLIDER,
 		(GLint)GradientIndex::BLACK, (GLint)GradientIndex::RGB_B_SLIDER);
-	send_gradient_color_uniform(quad_shader, GradientIndex::RGB_B_SLIDER, RGB(0x0000FF));
+	send_gradient_color_uniform(GradientIndex::RGB_B_SLIDER, RGB(0x0000FF));
 
 	wp_at(RGB_R_SLIDER).transform.position.x = slider_x;
 	wp_at(RGB_R_SLIDER).transform.position.y = slider1_y;
@@ -628,13 +644,13 @@ void ColorPicker::initialize_widget()
 	setup_circle_cursor(HSV_S_SLIDER_CURSOR);
 	setup_gradient(HSV_S_SLIDER, (GLint)GradientIndex::HSV_S_SLIDER_ZERO, (GLint)GradientIndex::HSV_S_SLIDER_ONE,
 		(GLint)GradientIndex::HSV_S_SLIDER_ZERO, (GLint)GradientIndex::HSV_S_SLIDER_ONE);
-	send_gradient_color_uniform(quad_shader, GradientIndex::HSV_S_SLIDER_ZERO, HSV(0.0f, 0.0f, 1.0f));
-	send_gradient_color_uniform(quad_shader, GradientIndex::HSV_S_SLIDER_ONE, HSV(0.0f, 1.0f, 1.0f));
+	send_gradient_color_uniform(GradientIndex::HSV_S_SLIDER_ZERO, HSV(0.0f, 0.0f, 1.0f));
+	send_gradient_color_uniform(GradientIndex::HSV_S_SLIDER_ONE, HSV(0.0f, 1.0f, 1.0f));
 	setup_rect_uvs(HSV_V_SLIDER);
 	setup_circle_cursor(HSV_V_SLIDER_CURSOR);
 	setup_gradient(HSV_V_SLIDER, (GLint)GradientIndex::BLACK, (GLint)GradientIndex::HSV_V_SLIDER,
 		(GLint)GradientIndex::BLACK, (GLint)GradientIndex::HSV_V_SLIDER);
-	send_gradient_color_uniform(quad_shader, GradientIndex::HSV_V_SLIDER, HSV(0.0f, 1.0f, 1.0f));
+	send_gradient_color_uniform(GradientIndex::HSV_V_SLIDER, HSV(0.0f, 1.0f, 1.0f));
 
 	wp_at(HSV_H_SLIDER).transform.position.x = slider_x;
 	wp_at(HSV_H_SLIDER).transform.position.y = slider1_y;
@@ -664,8 +680,8 @@ void ColorPicker::initialize_widget()
 	setup_circle_cursor(HSL_S_SLIDER_CURSOR);
 	setup_gradient(HSL_S_SLIDER, (GLint)GradientIndex::HSL_S_SLIDER_ZERO, (GLint)GradientIndex::HSL_S_SLIDER_ONE,
 		(GLint)GradientIndex::HSL_S_SLIDER_ZERO, (GLint)GradientIndex::HSL_S_SLIDER_ONE);
-	send_gradient_color_uniform(quad_shader, GradientIndex::HSL_S_SLIDER_ZERO, HSL(0.0f, 0.0f, 0.5f));
-	send_gradient_color_uniform(quad_shader, GradientIndex::HSL_S_SLIDER_ONE, HSL(0.0f, 1.0f, 0.5f));
+	send_gradient_color_uniform(GradientIndex::HSL_S_SLIDER_ZERO, HSL(0.0f, 0.0f, 0.5f));
+	send_gradient_color_uniform(GradientIndex::HSL_S_SLIDER_ONE, HSL(0.0f, 1.0f, 0.5f));
 	orient_progress_slider(HSL_L_SLIDER, Cardinal::RIGHT);
 	setup_circle_cursor(HSL_L_SLIDER_CURSOR);
 	
@@ -691,7 +707,7 @@ void ColorPicker::initialize_widget()
 	setup_circle_cursor(ALPHA_SLIDER_CURSOR);
 	setup_gradient(ALPHA_SLIDER, (GLint)GradientIndex::TRANSPARENT, (GLint)GradientIndex::ALPHA_SLIDER,
 		(GLint)GradientIndex::TRANSPARENT, (GLint)GradientIndex::ALPHA_SLIDER);
-	send_gradient_color_uniform(quad_shader, GradientIndex::ALPHA_SLIDER, ColorFrame());
+	send_gradient_color_uniform(GradientIndex::ALPHA_SLIDER, ColorFrame());
 
 	wp_at(ALPHA_SLIDER).transform.position.x = slider_x;
 	wp_at(ALPHA_SLIDER).transform.position.y = slider4_y;
@@ -714,7 +730,7 @@ void ColorPicker::initialize_widget()
 	setup_rect_uvs(PREVIEW_PRI);
 	setup_gradient(PREVIEW_PRI, (GLint)GradientIndex::PREVIEW_PRI, (GLint)GradientIndex::PREVIEW_PRI,
 		(GLint)GradientIndex::PREVIEW_PRI, (GLint)GradientIndex::PREVIEW_PRI);
-	send_gradient_color_uniform(quad_shader, GradientIndex::PREVIEW_PRI, ColorFrame());
+	send_gradient_color_uniform(GradientIndex::PREVIEW_PRI, ColorFrame());
 	wp_at(PREVIEW_PRI).transform.position.x = preview_x + preview_overlap_offset;
 	wp_at(PREVIEW_PRI).transform.position.y = preview_y;
 	wp_at(PREVIEW_PRI).transform.scale = { preview_w, preview_h };
@@ -725,7 +741,7 @@ void ColorPicker::initialize_widget()
 	setup_rect_uvs(PREVIEW_ALT);
 	setup_gradient(PREVIEW_ALT, (GLint)GradientIndex::PREVIEW_ALT, (GLint)GradientIndex::PREVIEW_ALT,
 		(GLint)GradientIndex::PREVIEW_ALT, (GLint)GradientIndex::PREVIEW_ALT);
-	send_gradient_color_uniform(quad_shader, GradientIndex::PREVIEW_ALT, ColorFrame());
+	send_gradient_color_uniform(GradientIndex::PREVIEW_ALT, ColorFrame());
 	wp_at(PREVIEW_ALT).transform.position.x = preview_x - preview_overlap_offset;
 	wp_at(PREVIEW_ALT).transform.position.y = preview_y;
 	wp_at(PREVIEW_ALT).transform.scale = { preview_w, preview_h };
@@ -963,6 +979,7 @@ void ColorPicker::connect_input_handlers()
 				if (current_widget_control >= 0)
 				{
 					take_over_cursor();
+					drag_cursor_pos = { FLT_MAX, FLT_MAX };
 					mb.consumed = true;
 					set_picker_color_from_gfx();
 					update_display_colors();
@@ -1001,7 +1018,11 @@ void ColorPicker::process_mb_down_events()
 	if (!MainWindow->is_mouse_button_pressed(MouseButton::LEFT))
 		return;
 
+	// Holding the cursor still changes nothing, so skip until it moves.
 	Position local_cursor_pos = self.transform.get_relative_pos(Machine.palette_cursor_world_pos());
+	if (local_cursor_pos == drag_cursor_pos)
+		return;
+	drag_cursor_pos = local_cursor_pos;
 	if (current_widget_control == ALPHA_SLIDER_CURSOR)
 		mouse_handler_horizontal_slider(ALPHA_SLIDER, ALPHA_SLIDER_CURSOR, local_cursor_pos);
 	else if (current_widget_control == GRAPHIC_QUAD_CURSOR)
@@ -1051,9 +1072,9 @@ void ColorPicker::release_cursor()
 		current_widget_control = -1;
 		set_picker_color_from_gfx();
 		if (editing_color == EditingColor::PRIMARY)
-			send_gradient_color_uniform(quad_shader, GradientIndex::PREVIEW_PRI, pri_color);
+			send_gradient_color_uniform(GradientIndex::PREVIEW_PRI, pri_color);
 		else if (editing_color == EditingColor::ALTERNATE)
-			send_gradient_color_uniform(quad_shader, GradientIndex::PREVIEW_ALT, alt_color);
+			send_gradient_color_uniform(GradientIndex::PREVIEW_ALT, alt_color);
 	}
 }
 
@@ -1189,7 +1210,7 @@ void ColorPicker::set_pri_color(ColorFrame color, bool toggle_on)
 		set_gfx_from_picker_color();
 	}
 	else
-		send_gradient_color_uniform(quad_shader, GradientIndex::PREVIEW_PRI, pri_color);
+		send_gradient_color_uniform(GradientIndex::PREVIEW_PRI, pri_color);
 	(*reflection.emit_modified_primary)(pri_color.rgba());
 }
 
@@ -1204,7 +1225,7 @@ void ColorPicker::set_alt_color(ColorFrame color, bool toggle_on)
 		set_gfx_from_picker_color();
 	}
 	else
-		send_gradient_color_uniform(quad_shader, GradientIndex::PREVIEW_ALT, alt_color);
+		send_gradient_color_uniform(GradientIndex::PREVIEW_ALT, alt_color);
 	(*reflection.emit_modified_alternate)(alt_color.rgba());
 }
 
@@ -1214,12 +1235,12 @@ void ColorPicker::swap_picker_colors()
 	if (editing_color == EditingColor::PRIMARY)
 	{
 		picker_color = pri_color;
-		send_gradient_color_uniform(quad_shader, GradientIndex::PREVIEW_ALT, alt_color);
+		send_gradient_color_uniform(GradientIndex::PREVIEW_ALT, alt_color);
 	}
 	else if (editing_color == EditingColor::ALTERNATE)
 	{
 		picker_color = alt_color;
-		send_gradient_color_uniform(quad_shader, GradientIndex::PREVIEW_PRI, pri_color);
+		send_gradient_color_uniform(GradientIndex::PREVIEW_PRI, pri_color);
 	}
 	set_gfx_from_picker_color();
 	(*reflection.emit_modified_primary)(pri_color.rgba());
@@ -1289,13 +1310,17 @@ void ColorPicker::move_slider_cursor_y_relative(size_t control, size_t cursor, f
 
 void ColorPicker::update_display_colors()
 {
+	// Controls of other states are brought up to date by set_state(), so only a change of color or of what is visible matters here.
+	if (displayed.valid && displayed.color == picker_color && displayed.state == state && displayed.editing_color == editing_color)
+		return;
+	displayed = { picker_color, state, editing_color, true };
 	// preview
 	if (editing_color == EditingColor::PRIMARY)
-		send_gradient_color_uniform(quad_shader, GradientIndex::PREVIEW_PRI, pri_color);
+		send_gradient_color_uniform(GradientIndex::PREVIEW_PRI, pri_color);
 	else if (editing_color == EditingColor::ALTERNATE)
-		send_gradient_color_uniform(quad_shader, GradientIndex::PREVIEW_ALT, alt_color);
+		send_gradient_color_uniform(GradientIndex::PREVIEW_ALT, alt_color);
 	// alpha
-	send_gradient_color_uniform(quad_shader, GradientIndex::ALPHA_SLIDER, ColorFrame(picker_color.rgb()));
+	send_gradient_color_uniform(GradientIndex::ALPHA_SLIDER, ColorFrame(picker_color.rgb()));
 	set_circle_cursor_value(ALPHA_SLIDER_CURSOR, contrast_wb_value_complex_hsva(picker_color.hsva()));
 	send_cpwc_buffer(ALPHA_SLIDER_CURSOR);
 	if (state & State::GRAPHIC_QUAD)
@@ -1368,7 +1393,7 @@ void ColorPicker::orient_progress_slider(size_t control, Cardinal i) const
 
 void ColorPicker::send_graphic_quad_hue_to_uniform(float hue) const
 {
-	send_gradient_color_uniform(quad_shader, GradientIndex::GRAPHIC_QUAD, HSV(hue, 1.0f, 1.0f));
+	send_gradient_color_uniform(GradientIndex::GRAPHIC_QUAD, HSV(hue, 1.0f, 1.0f));
 }
 
 glm::vec2 ColorPicker::get_graphic_quad_sat_and_value() const
@@ -1378,12 +1403,12 @@ glm::vec2 ColorPicker::get_graphic_quad_sat_and_value() const
 
 void ColorPicker::send_graphic_wheel_value_to_uniform(float value) const
 {
-	Uniforms::send_1(hue_wheel_w_shader, "u_Value", value);
+	uniforms.wheel_value.send(value);
 }
 
 void ColorPicker::send_graphic_value_slider_hue_and_sat_to_uniform(float hue, float sat) const
 {
-	send_gradient_color_uniform(quad_shader, GradientIndex::GRAPHIC_VALUE_SLIDER, HSV(hue, sat, 1.0f));
+	send_gradient_color_uniform(GradientIndex::GRAPHIC_VALUE_SLIDER, HSV(hue, sat, 1.0f));
 }
 
 glm::vec2 ColorPicker::get_graphic_wheel_hue_and_sat() const
@@ -1397,16 +1422,16 @@ glm::vec2 ColorPicker::get_graphic_wheel_hue_and_sat() const
 
 void ColorPicker::send_slider_hsv_hue_and_value_to_uniform(float hue, float value) const
 {
-	send_gradient_color_uniform(quad_shader, GradientIndex::HSV_S_SLIDER_ZERO, HSV(hue, 0.0f, value));
-	send_gradient_color_uniform(quad_shader, GradientIndex::HSV_S_SLIDER_ONE, HSV(hue, 1.0f, value));
-	send_gradient_color_uniform(quad_shader, GradientIndex::HSV_V_SLIDER, HSV(hue, 1.0f, 1.0f));
+	send_gradient_color_uniform(GradientIndex::HSV_S_SLIDER_ZERO, HSV(hue, 0.0f, value));
+	send_gradient_color_uniform(GradientIndex::HSV_S_SLIDER_ONE, HSV(hue, 1.0f, value));
+	send_gradient_color_uniform(GradientIndex::HSV_V_SLIDER, HSV(hue, 1.0f, 1.0f));
 }
 
 void ColorPicker::send_slider_hsl_hue_and_lightness_to_uniform(float hue, float lightness) const
 {
-	send_gradient_color_uniform(quad_shader, GradientIndex::HSL_S_SLIDER_ZERO, HSL(hue, 0.0f, lightness));
-	send_gradient_color_uniform(quad_shader, GradientIndex::HSL_S_SLIDER_ONE, HSL(hue, 1.0f, lightness));
-	Uniforms::send_1(linear_lightness_shader, "u_Hue", hue);
+	send_gradient_color_uniform(GradientIndex::HSL_S_SLIDER_ZERO, HSL(hue, 0.0f, lightness));
+	send_gradient_color_uniform(GradientIndex::HSL_S_SLIDER_ONE, HSL(hue, 1.0f, lightness));
+	uniforms.lightness_hue.send(hue);
 }
 
 float ColorPicker::slider_normal_x(size_t control, size_t cursor) const
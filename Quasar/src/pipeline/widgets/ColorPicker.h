@@ -9,6 +9,7 @@
 #include "edit/color/Color.h"
 #include "variety/Geometry.h"
 #include "Button.h"
+#include "../render/Uniforms.h"
 
 // LATER implement scroll handler for more precise control in sliders?
 
@@ -71,6 +72,7 @@ private:
 	WindowHandle wh_interactable, wh_preview;
 
 	int current_widget_control = -1;
+	Position drag_cursor_pos = {};
 	
 public:
 	enum class EditingColor
@@ -160,6 +162,11 @@ private:
 	bool cursor_in_bkg() const;
 
 	float cached_scale1d = 0.0f;
+	struct
+	{
+		UniformHandle<float> wheel_value; // hue_wheel_w_shader
+		UniformHandle<float> lightness_hue; // linear_lightness_shader
+	} uniforms;
 
 public:
 	// LATER use UMR when possible
@@ -240,7 +247,27 @@ public:
 	};
 
 private:
-	static void send_gradient_color_uniform(const Shader& shader, GradientIndex index, ColorFrame color);
+	// quad_shader reads its gradient colors from a uniform block. They are mirrored here so that unchanged colors are skipped,
+	// and the range of entries that changed is uploaded in one call when drawing.
+	mutable struct
+	{
+		std::array<glm::vec4, (size_t)GradientIndex::_MAX_GRADIENT_COLORS> values = {};
+		UniformBuffer ubo = UniformBuffer(sizeof(values), values.data());
+		GLint dirty_begin = (GLint)GradientIndex::_MAX_GRADIENT_COLORS;
+		GLint dirty_end = 0;
+	} gradient_colors;
+
+	// What update_display_colors() last brought the visible controls up to date with.
+	struct
+	{
+		ColorFrame color;
+		State state = State::GRAPHIC_QUAD;
+		EditingColor editing_color = EditingColor::PRIMARY;
+		bool valid = false;
+	} displayed;
+
+	void send_gradient_color_uniform(GradientIndex index, ColorFrame color) const;
+	void flush_gradient_colors() const;
 };
 
 inline ColorPicker& cpk_wget(Widget& w, size_t i)
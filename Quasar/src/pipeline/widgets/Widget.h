@@ -3,6 +3,7 @@
 #include "variety/Geometry.h"
 #include "variety/Utils.h"
 #include "../render/Renderable.h"
+#include "../render/SpriteBatch.h"
 
 struct WidgetPlacement
 {
@@ -209,6 +210,7 @@ struct W_UnitRenderable : public Widget
 	W_UnitRenderable(Shader* shader, unsigned char num_vertices = 4) : ur(std::make_unique<UnitRenderable>(shader, num_vertices)) {}
 
 	virtual void draw() override { ur->draw(); }
+	void submit(SpriteBatch& batch, int layer) const { batch.submit(*ur, layer); }
 };
 
 inline UnitRenderable& ur_wget(Widget& w, size_t i)
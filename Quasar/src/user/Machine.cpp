@@ -12,6 +12,7 @@
 #include "pipeline/text/TextRender.h"
 #include "pipeline/text/CommonFonts.h"
 #include "variety/GLutility.h"
+#include "variety/Profiler.h"
 
 #define QUASAR_INVALIDATE_PTR(ptr) delete ptr; ptr = nullptr;
 #define QUASAR_INVALIDATE_ARR(arr) delete[] arr; arr = nullptr;
@@ -39,6 +40,14 @@ namespace Data
 
 	static ControlScheme control_scheme = ControlScheme::FILE;
 
+	namespace Render
+	{
+		static unsigned int pending_frames = 0;
+		static bool full_damage = true; // whether the input that started pending_frames dirties every panel, or only those under the cursor
+		static double last_render_time = 0.0;
+		static Position last_cursor_pos{};
+	}
+
 	namespace Input
 	{
 		static WindowSizeHandler* resize_handler = nullptr;
@@ -279,9 +288,9 @@ void MachineImpl::init_renderer()
 	canvas_reset_camera();
 	
 	easel()->canvas().minor_gridlines.set_color(ColorFrame(RGBA(31, 63, 107, 255))); // SETTINGS
-	easel()->canvas().minor_gridlines.line_width = 1.0f; // cannot be < 1.0 // SETTINGS
+	easel()->canvas().minor_gridlines.set_line_width(1.0f); // cannot be < 1.0 // SETTINGS
 	easel()->canvas().major_gridlines.set_color(ColorFrame(RGBA(31, 72, 127, 255))); // SETTINGS
-	easel()->canvas().major_gridlines.line_width = 4.0f; // cannot be < 1.0 // SETTINGS
+	easel()->canvas().major_gridlines.set_line_width(4.0f); // cannot be < 1.0 // SETTINGS
 
 	set_app_scale(main_window->display_scale());
 
@@ -307,6 +316,7 @@ void MachineImpl::destroy()
 	history.clear_history();
 	invalidate_handlers();
 	free_standard_cursors();
+	Profiler.destroy();
 	QUASAR_INVALIDATE_PTR(main_window); // invalidate window last
 	MainWindow = nullptr;
 	MEasel = nullptr;
@@ -321,14 +331,67 @@ bool MachineImpl::should_exit() const
 	return main_window->should_close();
 }
 
+static bool renders_continuously()
+{
+	return Data::Render::pending_frames > 0 || MainWindow->any_input_held() || panels->any_dirty();
+}
+
+void MachineImpl::wait_events() const
+{
+	if (renders_continuously())
+		glfwPollEvents();
+	else
+	{
+		glfwWaitEventsTimeout(idle_timeout);
+		// Time asleep isn't frame time. Otherwise the first delta after waking covers the whole wait, and a held undo/redo started by the
+		// key that woke the loop would immediately pass held_start_interval and repeat.
+		Data::last_processed_time = glfwGetTime();
+	}
+}
+
+bool MachineImpl::should_render() const
+{
+	return renders_continuously() || main_window->has_input_damage() || glfwGetTime() - Data::Render::last_render_time >= idle_timeout;
+}
+
+static void apply_input_damage()
+{
+	Window::InputDamage damage = MainWindow->consume_input_damage();
+	if (damage.any)
+	{
+		if (Data::Render::pending_frames == 0)
+			Data::Render::full_damage = false;
+		Data::Render::pending_frames = Machine.settle_frames;
+		Data::Render::full_damage |= !damage.hover_only;
+	}
+	Position cursor_pos = Machine.cursor_screen_pos();
+	if (MainWindow->any_input_held() || (Data::Render::pending_frames > 0 && Data::Render::full_damage))
+		panels->mark_all_dirty();
+	else if (Data::Render::pending_frames > 0)
+	{
+		panels->mark_dirty_at(Data::Render::last_cursor_pos);
+		panels->mark_dirty_at(cursor_pos);
+	}
+	Data::Render::last_cursor_pos = cursor_pos;
+}
+
 void MachineImpl::on_render()
 {
+	Profiler.begin_frame();
+	apply_input_damage();
 	process();
 	main_window->new_frame();
 	panels->render();
 	main_window_clip().scissor();
-	update_currently_bound_shader();
-	main_window->end_frame();
+	{
+		QUASAR_PROFILE_GPU("gui and present");
+		main_window->end_frame();
+	}
+	GLS.invalidate(); // ImGui restores the bindings it changes, so this only guards against raw GL calls elsewhere
+	Data::Render::last_render_time = glfwGetTime();
+	if (Data::Render::pending_frames > 0)
+		--Data::Render::pending_frames;
+	Profiler.end_frame();
 }
 
 static void process_undo()
@@ -395,6 +458,7 @@ static void process_redo()
 
 void MachineImpl::process()
 {
+	QUASAR_PROFILE("process");
 	Data::update_time();
 	//LOG << Data::delta_time << LOG.nl;
 	palette()->process();
@@ -410,6 +474,7 @@ void MachineImpl::process()
 void MachineImpl::mark()
 {
 	unsaved = true;
+	easel()->mark_dirty();
 	// LATER edit title to include (*)
 }
 
@@ -424,6 +489,11 @@ bool MachineImpl::canvas_image_ready() const
 	return easel()->canvas_image();
 }
 
+bool MachineImpl::canvas_is_indexed() const
+{
+	return canvas_image_ready() && easel()->canvas_image()->indexed();
+}
+
 bool MachineImpl::canvas_is_panning() const
 {
 	return easel()->panning_info.panning;
@@ -464,6 +534,22 @@ void MachineImpl::palette_delete_subpalette()
 	palette()->delete_subpalette();
 }
 
+void MachineImpl::palette_extract_from_canvas()
+{
+	if (!canvas_image_ready())
+		return;
+	cancel_color_filter(); // the preview isn't part of the image yet
+	const Image* img = easel()->canvas_image();
+	if (img->indexed())
+	{
+		Buffer direct = expand_indexed_buffer(img->buf, *img->palette);
+		palette()->extract_subpalette(direct);
+		delete[] direct.pixels;
+	}
+	else
+		palette()->extract_subpalette(img->buf);
+}
+
 Scale MachineImpl::inv_app_scale() const
 {
 	return Data::app_inverse_scale;
@@ -489,6 +575,8 @@ void MachineImpl::set_clear_color(ColorFrame color)
 {
 	auto vec = color.rgba().as_vec();
 	QUASAR_GL(glClearColor(vec[0], vec[1], vec[2], vec[3]));
+	if (panels)
+		panels->mark_all_dirty();
 }
 
 Position MachineImpl::to_world_coordinates(Position screen_coordinates, const glm::mat3& inverse_vp) const
@@ -714,7 +802,7 @@ void MachineImpl::open_file(const FilePath& filepath)
 
 void MachineImpl::import_file(const FilePath& filepath)
 {	
-	easel()->canvas().set_image(std::make_shared<Image>(filepath));
+	easel()->canvas().set_image(std::make_shared<Image>(filepath, false)); // the canvas generates tiled textures
 	auto title = "Quasar - " + filepath.filename();
 	main_window->set_title(title.c_str()); // LATER don't set title of window. put image filename in bottom status bar
 	canvas_reset_camera();
@@ -766,6 +854,62 @@ void MachineImpl::rotate_270()
 	easel()->rotate_image_270();
 }
 
+void MachineImpl::invert_colors()
+{
+	ColorFilter filter;
+	filter.type = ColorFilter::Type::INVERT;
+	easel()->apply_color_filter(filter);
+	mark();
+}
+
+void MachineImpl::preview_color_filter(const ColorFilter& filter, bool reduced)
+{
+	easel()->preview_color_filter(filter, reduced);
+}
+
+void MachineImpl::commit_color_filter()
+{
+	easel()->commit_color_filter();
+	mark();
+}
+
+void MachineImpl::cancel_color_filter()
+{
+	easel()->cancel_color_filter();
+}
+
+void MachineImpl::quantize_canvas(const QuantizeOptions& options)
+{
+	std::vector<PixelRGBA> colors = easel()->quantize_image(options);
+	if (colors.empty())
+		return;
+	palette()->append_subpalette("quantized", colors);
+	mark();
+}
+
+void MachineImpl::snap_canvas_to_palette(QuantizeOptions::Dither dither)
+{
+	const PaletteLookup& lookup = palette()->current_subscheme().palette_lookup();
+	if (lookup.empty())
+		return;
+	easel()->snap_image_to_palette(lookup, dither);
+	mark();
+}
+
+void MachineImpl::index_canvas(QuantizeOptions::Dither dither)
+{
+	if (palette()->current_subscheme().colors.empty())
+		return;
+	easel()->index_image(palette()->current_subscheme_ref(), dither);
+	mark();
+}
+
+void MachineImpl::unindex_canvas()
+{
+	easel()->unindex_image();
+	mark();
+}
+
 bool MachineImpl::brushes_panel_visible() const
 {
 	return brushes()->visible;
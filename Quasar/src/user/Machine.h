@@ -7,6 +7,7 @@
 #include "variety/Geometry.h"
 #include "variety/History.h"
 #include "variety/FileSystem.h"
+#include "edit/color/Quantize.h"
 
 struct MachineImpl
 {
@@ -64,6 +65,8 @@ struct MachineImpl
 	void destroy();
 	void exit() const { main_window->request_close(); }
 	bool should_exit() const;
+	void wait_events() const;
+	bool should_render() const;
 	void on_render();
 	void process();
 	void mark();
@@ -87,6 +90,10 @@ struct MachineImpl
 
 	int vsync = 0;
 	void update_vsync() const { glfwSwapInterval(vsync); }
+	// While no input arrives and no panel is dirty, the main loop sleeps in glfwWaitEventsTimeout. A frame is still rendered every idle_timeout,
+	// so that ImGui's timed state, like tooltips and the text caret, advances. After input, settle_frames more frames are rendered for ImGui to catch up.
+	double idle_timeout = 0.5; // seconds
+	unsigned int settle_frames = 3; // SETTINGS
 	bool raw_mouse_motion = true;
 	void update_raw_mouse_motion() const { main_window->set_raw_mouse_motion(raw_mouse_motion); }
 
@@ -102,6 +109,7 @@ struct MachineImpl
 
 	// Canvas
 	bool canvas_image_ready() const;
+	bool canvas_is_indexed() const;
 	bool canvas_is_panning() const;
 	void canvas_cancel_panning() const;
 
@@ -112,6 +120,7 @@ struct MachineImpl
 	void palette_new_subpalette();
 	void palette_rename_subpalette();
 	void palette_delete_subpalette();
+	void palette_extract_from_canvas();
 
 	// File menu
 	bool new_file();
@@ -126,9 +135,9 @@ struct MachineImpl
 	void import_file(const FilePath& filepath);
 	void save_file(const FilePath& filepath);
 
-	void undo() { history.undo(); mark(); }
+	void undo() { cancel_color_filter(); history.undo(); mark(); }
 	bool undo_enabled() const { return history.undo_size() != 0; }
-	void redo() { history.redo(); mark(); }
+	void redo() { cancel_color_filter(); history.redo(); mark(); }
 	bool redo_enabled() const { return history.redo_size() != 0; }
 	void start_held_undo();
 	void start_held_redo();
@@ -139,6 +148,14 @@ struct MachineImpl
 	void rotate_90();
 	void rotate_180();
 	void rotate_270();
+	void invert_colors();
+	void preview_color_filter(const struct ColorFilter& filter, bool reduced);
+	void commit_color_filter();
+	void cancel_color_filter();
+	void quantize_canvas(const QuantizeOptions& options);
+	void snap_canvas_to_palette(QuantizeOptions::Dither dither);
+	void index_canvas(QuantizeOptions::Dither dither);
+	void unindex_canvas();
 
 	// View menu
 	bool brushes_panel_visible() const;
@@ -8,6 +8,7 @@
 static void window_size_callback(GLFWwindow* window, int width, int height)
 {
 	auto win = Windows[window];
+	win->damage_input();
 	WindowSizeEvent event(width, height);
 	win->root_window_size.on_callback(event);
 }
@@ -15,6 +16,7 @@ static void window_size_callback(GLFWwindow* window, int width, int height)
 static void path_drop_callback(GLFWwindow* window, int num_paths, const char** paths)
 {
 	auto win = Windows[window];
+	win->damage_input();
 	PathDropEvent event(num_paths, paths);
 	win->root_path_drop.on_callback(event);
 }
@@ -22,6 +24,8 @@ static void path_drop_callback(GLFWwindow* window, int num_paths, const char** p
 static void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
 	auto win = Windows[window];
+	win->damage_input();
+	win->on_key_action(IAction(action));
 	KeyEvent event(key, scancode, action, mods);
 	win->root_key.on_callback(event);
 }
@@ -29,6 +33,7 @@ static void key_callback(GLFWwindow* window, int key, int scancode, int action,
 static void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
 {
 	auto win = Windows[window];
+	win->damage_input();
 	MouseButtonEvent event(button, action, mods);
 	win->root_mouse_button.on_callback(event);
 }
@@ -36,6 +41,7 @@ static void mouse_button_callback(GLFWwindow* window, int button, int action, in
 static void scroll_callback(GLFWwindow* window, double xoff, double yoff)
 {
 	auto win = Windows[window];
+	win->damage_input();
 	ScrollEvent event(xoff, yoff);
 	win->root_scroll.on_callback(event);
 }
@@ -43,6 +49,7 @@ static void scroll_callback(GLFWwindow* window, double xoff, double yoff)
 static void window_maximize_callback(GLFWwindow* window, int maximized)
 {
 	auto win = Windows[window];
+	win->damage_input();
 	WindowMaximizeEvent event(maximized);
 	win->root_window_maximize.on_callback(event);
 }
@@ -50,10 +57,37 @@ static void window_maximize_callback(GLFWwindow* window, int maximized)
 static void display_scale_callback(GLFWwindow* window, float x_scale, float y_scale)
 {
 	auto win = Windows[window];
+	win->damage_input();
 	DisplayScaleEvent event(x_scale, y_scale);
 	win->root_display_scale.on_callback(event);
 }
 
+static void cursor_pos_callback(GLFWwindow* window, double xpos, double ypos)
+{
+	auto win = Windows[window];
+	win->damage_input(!win->any_mouse_button_pressed());
+}
+
+static void cursor_enter_callback(GLFWwindow* window, int entered)
+{
+	Windows[window]->damage_input(true);
+}
+
+static void char_callback(GLFWwindow* window, unsigned int codepoint)
+{
+	Windows[window]->damage_input();
+}
+
+static void window_focus_callback(GLFWwindow* window, int focused)
+{
+	Windows[window]->damage_input();
+}
+
+static void window_refresh_callback(GLFWwindow* window)
+{
+	Windows[window]->damage_input();
+}
+
 Cursor::Cursor(StandardCursor standard_cursor)
 	: cursor(glfwCreateStandardCursor(int(standard_cursor)))
 {
@@ -120,6 +154,12 @@ Window::Window(const char* title, int width, int height, bool enable_gui, ImFont
 	glfwSetScrollCallback(window, scroll_callback);
 	glfwSetWindowMaximizeCallback(window, window_maximize_callback);
 	glfwSetWindowContentScaleCallback(window, display_scale_callback);
+	// The following only mark input damage, so that the main loop wakes up. ImGui chains its own callbacks to these.
+	glfwSetCursorPosCallback(window, cursor_pos_callback);
+	glfwSetCursorEnterCallback(window, cursor_enter_callback);
+	glfwSetCharCallback(window, char_callback);
+	glfwSetWindowFocusCallback(window, window_focus_callback);
+	glfwSetWindowRefreshCallback(window, window_refresh_callback);
 	// LATER use better input system than callback vectors. Instead, use input hierarchy that can consume input events at different nodes.
 
 	if (cursor.cursor)
@@ -396,6 +436,14 @@ bool Window::bind_gui() const
 	return false;
 }
 
+void Window::on_key_action(IAction action)
+{
+	if (action == IAction::PRESS)
+		++num_held_keys;
+	else if (action == IAction::RELEASE && num_held_keys > 0) // GLFW releases held keys when focus is lost, but a key pressed elsewhere may be released here
+		--num_held_keys;
+}
+
 void Window::new_frame() const
 {
 	QUASAR_GL(glClear(GL_COLOR_BUFFER_BIT));
@@ -367,6 +367,19 @@ struct Window
 	void release_cursor(WindowHandle* owner);
 	void eject_cursor();
 
+	// Input damage is collected by the GLFW callbacks, and consumed once per rendered frame.
+	struct InputDamage
+	{
+		bool any = false;
+		// Only cursor motion with no mouse button held, which changes at most the panels under the old and new cursor positions.
+		bool hover_only = true;
+	};
+	void damage_input(bool hover_only = false) { input_damage.any = true; input_damage.hover_only &= hover_only; }
+	bool has_input_damage() const { return input_damage.any; }
+	InputDamage consume_input_damage() { InputDamage damage = input_damage; input_damage = {}; return damage; }
+	void on_key_action(IAction action);
+	bool any_input_held() const { return num_held_keys > 0 || any_mouse_button_pressed(); }
+
 	bool is_mouse_mode_available(const WindowHandle* owner) const;
 	bool owns_mouse_mode(const WindowHandle* owner) const;
 	void request_mouse_mode(WindowHandle* owner, MouseMode mouse_mode);
@@ -381,6 +394,9 @@ private:
 	bool fullscreen = false;
 	bool maximized = false;
 
+	InputDamage input_damage;
+	int num_held_keys = 0;
+
 	KeyHandler window_maximizer;
 	
 	const WindowHandle* cursor_owner = nullptr;
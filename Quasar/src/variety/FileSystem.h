@@ -26,7 +26,7 @@ public:
 		else
 			return path + "/" + relative.path;
 	}
-	FilePath& operator+=(const std::string& addon) { path += addon; }
+	FilePath& operator+=(const std::string& addon) { path += addon; return *this; }
 	FilePath operator+(const std::string& addon) const { FilePath temp = path.c_str(); temp += addon; return temp; }
 
 	bool is_absolute() const { return std::filesystem::path(path).is_absolute(); }
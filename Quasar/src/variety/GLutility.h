@@ -1,18 +1,164 @@
 #pragma once
 
 #include <vector>
+#include <unordered_map>
+#include <algorithm>
 
 #include "Macros.h"
 
+// A shadow of the GL bindings that the helpers below change, so that binding what is already bound is skipped. Unbinding is lazy:
+// every helper binds what it needs before use, so unbind_vao_buffers() and unbind_shader() leave the GL bindings in place.
+// Code that binds through raw GL calls, or hands the context to code that does, should invalidate() afterwards.
+// In headless mode no GL calls are issued at all, so binding logic can run and be counted without a context.
+struct GLStateCache
+{
+	static constexpr GLuint UNKNOWN = GLuint(-1);
+
+	GLuint program = UNKNOWN;
+	GLuint vao = UNKNOWN;
+	GLuint array_buffer = UNKNOWN;
+	GLuint uniform_buffer = UNKNOWN;
+	GLuint active_texture_unit = UNKNOWN;
+	std::vector<GLuint> textures; // GL_TEXTURE_2D binding per texture unit
+	std::unordered_map<GLuint, GLuint> element_buffers; // the element array buffer binding is part of the VAO's state
+	bool headless = false;
+
+	struct
+	{
+		unsigned long long issued = 0;
+		unsigned long long elided = 0;
+	} counters;
+
+	void invalidate()
+	{
+		program = UNKNOWN;
+		vao = UNKNOWN;
+		array_buffer = UNKNOWN;
+		uniform_buffer = UNKNOWN;
+		active_texture_unit = UNKNOWN;
+		std::fill(textures.begin(), textures.end(), UNKNOWN);
+		element_buffers.clear();
+	}
+
+	// Returns whether the binding changed, in which case the caller issues the GL call.
+	bool update(GLuint& binding, GLuint name)
+	{
+		if (binding == name)
+		{
+			++counters.elided;
+			return false;
+		}
+		binding = name;
+		++counters.issued;
+		return !headless;
+	}
+
+	GLuint& texture_binding(GLuint slot)
+	{
+		if (slot >= textures.size())
+			textures.resize(slot + 1, UNKNOWN);
+		return textures[slot];
+	}
+
+	GLuint& element_buffer_binding()
+	{
+		return element_buffers.try_emplace(vao, UNKNOWN).first->second;
+	}
+
+	// Deleting a bound object reverts its bindings to 0, and its name may be reused by the next object generated.
+	void forget_texture(GLuint texture)
+	{
+		for (GLuint& bound : textures)
+		{
+			if (bound == texture)
+				bound = 0;
+		}
+	}
+
+	void forget_buffer(GLuint buffer)
+	{
+		if (array_buffer == buffer)
+			array_buffer = 0;
+		if (uniform_buffer == buffer)
+			uniform_buffer = 0;
+		for (auto& [_, bound] : element_buffers)
+		{
+			if (bound == buffer)
+				bound = 0;
+		}
+	}
+
+	void forget_vao(GLuint vertex_array)
+	{
+		if (vao == vertex_array)
+			vao = 0;
+		element_buffers.erase(vertex_array);
+	}
+};
+
+inline GLStateCache GLS{};
+
 inline void bind_texture(GLuint texture, GLuint slot = 0)
 {
-	QUASAR_GL(glActiveTexture(GL_TEXTURE0 + slot));
-	QUASAR_GL(glBindTexture(GL_TEXTURE_2D, texture));
+	// texture uploads after bind_texture() go to the active unit, so it is switched even if the texture is already bound there
+	if (GLS.update(GLS.active_texture_unit, slot))
+	{
+		QUASAR_GL(glActiveTexture(GL_TEXTURE0 + slot));
+	}
+	if (GLS.update(GLS.texture_binding(slot), texture))
+	{
+		QUASAR_GL(glBindTexture(GL_TEXTURE_2D, texture));
+	}
+}
+
+inline void delete_texture(GLuint texture)
+{
+	GLS.forget_texture(texture);
+	if (!GLS.headless)
+	{
+		QUASAR_GL(glDeleteTextures(1, &texture));
+	}
 }
 
-inline void attrib_pointers(const std::vector<unsigned short> attrib_lengths, unsigned short stride)
+inline void bind_array_buffer(GLuint vb)
 {
-	int offset = 0;
+	if (GLS.update(GLS.array_buffer, vb))
+	{
+		QUASAR_GL(glBindBuffer(GL_ARRAY_BUFFER, vb));
+	}
+}
+
+inline void bind_uniform_buffer(GLuint ubo)
+{
+	if (GLS.update(GLS.uniform_buffer, ubo))
+	{
+		QUASAR_GL(glBindBuffer(GL_UNIFORM_BUFFER, ubo));
+	}
+}
+
+inline void bind_uniform_buffer_base(GLuint binding, GLuint ubo)
+{
+	// also sets the generic binding
+	GLS.uniform_buffer = ubo;
+	++GLS.counters.issued;
+	if (!GLS.headless)
+	{
+		QUASAR_GL(glBindBufferBase(GL_UNIFORM_BUFFER, binding, ubo));
+	}
+}
+
+inline void delete_buffer(GLuint buffer)
+{
+	GLS.forget_buffer(buffer);
+	if (!GLS.headless)
+	{
+		QUASAR_GL(glDeleteBuffers(1, &buffer));
+	}
+}
+
+inline void attrib_pointers(const std::vector<unsigned short> attrib_lengths, unsigned short stride, size_t base_offset = 0)
+{
+	size_t offset = base_offset;
 	int stride_bytes = stride * sizeof(GL_FLOAT);
 	for (GLuint i = 0; i < attrib_lengths.size(); ++i)
 	{
@@ -34,24 +180,33 @@ inline void attrib_new_pointers(const std::vector<unsigned short> old_attrib_len
 	attrib_pointers(new_attrib_lengths, new_stride);
 }
 
+inline void bind_vao(GLuint vao)
+{
+	if (GLS.update(GLS.vao, vao))
+	{
+		QUASAR_GL(glBindVertexArray(vao));
+	}
+}
+
 inline void bind_vao_buffers(GLuint vao, GLuint vb, GLuint ib)
 {
-	QUASAR_GL(glBindVertexArray(vao));
-	QUASAR_GL(glBindBuffer(GL_ARRAY_BUFFER, vb));
-	QUASAR_GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ib));
+	bind_vao(vao);
+	bind_array_buffer(vb);
+	if (GLS.update(GLS.element_buffer_binding(), ib))
+	{
+		QUASAR_GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ib));
+	}
 }
 
 inline void bind_vao_buffers(GLuint vao, GLuint vb)
 {
-	QUASAR_GL(glBindVertexArray(vao));
-	QUASAR_GL(glBindBuffer(GL_ARRAY_BUFFER, vb));
+	bind_vao(vao);
+	bind_array_buffer(vb);
 }
 
+// Lazy, see GLStateCache.
 inline void unbind_vao_buffers()
 {
-	QUASAR_GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
-	QUASAR_GL(glBindBuffer(GL_ARRAY_BUFFER, 0));
-	QUASAR_GL(glBindVertexArray(0));
 }
 
 inline void gen_dynamic_vao(GLuint& vao, GLuint& vb, GLuint& ib, bool bind = false)
@@ -107,42 +262,39 @@ inline void initialize_dynamic_vao(GLuint& vao, GLuint& vb, size_t vertex_count,
 		unbind_vao_buffers();
 }
 
-inline void delete_vao_buffers(GLuint vao, GLuint vb, GLuint ib)
+inline void delete_vao(GLuint vao)
 {
-	QUASAR_GL(glDeleteVertexArrays(1, &vao));
-	QUASAR_GL(glDeleteBuffers(1, &vb));
-	QUASAR_GL(glDeleteBuffers(1, &ib));
+	GLS.forget_vao(vao);
+	if (!GLS.headless)
+	{
+		QUASAR_GL(glDeleteVertexArrays(1, &vao));
+	}
 }
 
-inline void delete_vao_buffers(GLuint vao, GLuint vb)
+inline void delete_vao_buffers(GLuint vao, GLuint vb, GLuint ib)
 {
-	QUASAR_GL(glDeleteVertexArrays(1, &vao));
-	QUASAR_GL(glDeleteBuffers(1, &vb));
+	delete_vao(vao);
+	delete_buffer(vb);
+	delete_buffer(ib);
 }
 
-inline static GLuint _currently_bound_shader = 0;
-
-inline void update_currently_bound_shader()
+inline void delete_vao_buffers(GLuint vao, GLuint vb)
 {
-	QUASAR_GL(glGetIntegerv(GL_CURRENT_PROGRAM, reinterpret_cast<GLint*>(&_currently_bound_shader)));
+	delete_vao(vao);
+	delete_buffer(vb);
 }
 
 inline void bind_shader(GLuint shader)
 {
-	if (shader != _currently_bound_shader)
+	if (GLS.update(GLS.program, shader))
 	{
 		QUASAR_GL(glUseProgram(shader));
-		_currently_bound_shader = shader;
 	}
 }
 
+// Lazy, see GLStateCache. Uniforms are sent with glProgramUniform*(), which doesn't need the program bound.
 inline void unbind_shader()
 {
-	if (_currently_bound_shader)
-	{
-		QUASAR_GL(glUseProgram(0));
-		_currently_bound_shader = 0;
-	}
 }
 
 struct GLConstants
@@ -1,12 +1,12 @@
 #pragma once
 
-#include <gl/glew.h>
 #include <glm/glm.hpp>
 
 #include <functional>
 #include <algorithm>
 
 #include "Macros.h"
+#include "Utils.h"
 
 constexpr bool on_interval(float val, float min_inclusive, float max_inclusive)
 {
@@ -88,7 +88,10 @@ struct IScale : glm::ivec2
 template<>
 struct std::hash<IPosition>
 {
-	size_t operator()(const IPosition& pos) const { return std::hash<int>{}(pos.x) ^ std::hash<int>{}(pos.y); }
+	size_t operator()(const IPosition& pos) const
+	{
+		return mix_hash((static_cast<unsigned long long>(static_cast<unsigned int>(pos.x)) << 32) | static_cast<unsigned int>(pos.y));
+	}
 };
 
 inline bool in_diagonal_rect(IPosition pos, IPosition bl, IPosition tr)
@@ -285,6 +288,7 @@ struct IntRect
 {
 	int x = 0, y = 0, w = 0, h = 0;
 
+	bool operator==(const IntRect&) const = default;
 	bool intersect(IntRect other, IntRect& result) const;
 	IntRect scaled(int sx, int sy) const { return { sx * x, sy * y, sx * w, sy * h }; }
 };
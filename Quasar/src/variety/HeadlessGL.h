@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// What the editing core needs from GL when it is built with QUASAR_HEADLESS: types and enum values, so that it compiles unchanged.
+// There are no functions, since QUASAR_GL() compiles the calls out. Values match the GL headers.
+
+typedef unsigned int GLenum;
+typedef unsigned int GLuint;
+typedef int GLint;
+typedef int GLsizei;
+typedef unsigned char GLboolean;
+typedef unsigned int GLbitfield;
+typedef float GLfloat;
+typedef double GLdouble;
+typedef char GLchar;
+typedef unsigned char GLubyte;
+typedef void GLvoid;
+typedef std::ptrdiff_t GLsizeiptr;
+typedef std::ptrdiff_t GLintptr;
+typedef std::uint64_t GLuint64;
+typedef struct __GLsync* GLsync;
+
+#define GL_FALSE 0
+#define GL_TRUE 1
+
+#define GL_ARRAY_BUFFER 0x8892
+#define GL_CLAMP_TO_BORDER 0x812D
+#define GL_CLAMP_TO_EDGE 0x812F
+#define GL_DYNAMIC_DRAW 0x88E8
+#define GL_ELEMENT_ARRAY_BUFFER 0x8893
+#define GL_FLOAT 0x1406
+#define GL_LINEAR 0x2601
+#define GL_LINEAR_MIPMAP_LINEAR 0x2703
+#define GL_LINEAR_MIPMAP_NEAREST 0x2701
+#define GL_MAX_TEXTURE_IMAGE_UNITS 0x8872
+#define GL_MAX_TEXTURE_SIZE 0x0D33
+#define GL_MIRRORED_REPEAT 0x8370
+#define GL_MIRROR_CLAMP_TO_EDGE 0x8743
+#define GL_NEAREST 0x2600
+#define GL_NEAREST_MIPMAP_LINEAR 0x2702
+#define GL_NEAREST_MIPMAP_NEAREST 0x2700
+#define GL_R8 0x8229
+#define GL_RED 0x1903
+#define GL_REPEAT 0x2901
+#define GL_RG 0x8227
+#define GL_RG8 0x822B
+#define GL_RGB 0x1907
+#define GL_RGB8 0x8051
+#define GL_RGBA 0x1908
+#define GL_RGBA8 0x8058
+#define GL_TEXTURE0 0x84C0
+#define GL_TEXTURE_2D 0x0DE1
+#define GL_TEXTURE_MAG_FILTER 0x2800
+#define GL_TEXTURE_MAX_LEVEL 0x813D
+#define GL_TEXTURE_MIN_FILTER 0x2801
+#define GL_TEXTURE_WRAP_S 0x2802
+#define GL_TEXTURE_WRAP_T 0x2803
+#define GL_UNIFORM_BUFFER 0x8A11
+#define GL_UNPACK_ALIGNMENT 0x0CF5
+#define GL_UNPACK_ROW_LENGTH 0x0CF2
+#define GL_UNSIGNED_BYTE 0x1401
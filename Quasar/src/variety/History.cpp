@@ -1,13 +1,17 @@
 #include "History.h"
 
+#include "Profiler.h"
+
 void ActionHistory::execute(std::shared_ptr<ActionBase>&& action)
 {
+	QUASAR_PROFILE("history execute");
 	action->forward();
 	push(std::move(action));
 }
 
 void ActionHistory::execute(const std::shared_ptr<ActionBase>& action)
 {
+	QUASAR_PROFILE("history execute");
 	action->forward();
 	push(action);
 }
@@ -54,6 +58,7 @@ void ActionHistory::push(std::shared_ptr<ActionBase>&& action)
 
 void ActionHistory::execute_no_undo(const std::shared_ptr<ActionBase>& action)
 {
+	QUASAR_PROFILE("history execute");
 	action->forward();
 	clear_history();
 }
@@ -67,6 +72,7 @@ void ActionHistory::clear_history()
 
 void ActionHistory::undo()
 {
+	QUASAR_PROFILE("history undo");
 	if (!undo_deque.empty())
 	{
 		std::shared_ptr<ActionBase> action = std::move(undo_deque.back());
@@ -84,6 +90,7 @@ size_t ActionHistory::undo_size() const
 
 void ActionHistory::redo()
 {
+	QUASAR_PROFILE("history redo");
 	if (!redo_deque.empty())
 	{
 		std::shared_ptr<ActionBase> action = std::move(redo_deque.back());
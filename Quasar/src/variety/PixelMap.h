@@ -0,0 +1,161 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <type_traits>
+
+#include "Geometry.h"
+
+// Flat open-addressing map keyed by pixel position, used for stroke storage and paint actions.
+// Entries live in one contiguous array with linear probing, so a stroke of n pixels costs a handful of allocations instead of n nodes.
+// There is no erase: strokes only ever insert, then get cleared or moved into a history action wholesale.
+template<typename Value>
+class PixelMap
+{
+public:
+	typedef std::pair<IPosition, Value> value_type;
+
+private:
+	std::vector<value_type> slots;
+	std::vector<bool> occupied;
+	size_t count = 0;
+
+	static constexpr size_t MIN_CAPACITY = 16;
+
+	size_t mask() const { return slots.size() - 1; }
+
+	size_t probe(IPosition pos) const
+	{
+		size_t i = std::hash<IPosition>{}(pos) & mask();
+		while (occupied[i] && slots[i].first != pos)
+			i = (i + 1) & mask();
+		return i;
+	}
+
+	void rehash(size_t capacity)
+	{
+		std::vector<value_type> old_slots(capacity);
+		std::vector<bool> old_occupied(capacity, false);
+		old_slots.swap(slots);
+		old_occupied.swap(occupied);
+		for (size_t i = 0; i < old_slots.size(); ++i)
+		{
+			if (old_occupied[i])
+			{
+				size_t j = probe(old_slots[i].first);
+				slots[j] = std::move(old_slots[i]);
+				occupied[j] = true;
+			}
+		}
+	}
+
+	// Max load factor is 1/2, which keeps linear probe chains short even for dense rectangular fills.
+	static size_t capacity_for(size_t n)
+	{
+		size_t capacity = MIN_CAPACITY;
+		while (capacity < 2 * n)
+			capacity <<= 1;
+		return capacity;
+	}
+
+public:
+	template<bool Const>
+	class Iter
+	{
+		friend class PixelMap;
+		template<bool> friend class Iter;
+		typedef std::conditional_t<Const, const PixelMap, PixelMap> Map;
+		typedef std::conditional_t<Const, const value_type, value_type> Entry;
+		Map* map = nullptr;
+		size_t i = 0;
+
+		Iter(Map* map, size_t i) : map(map), i(i) { skip(); }
+		void skip() { while (i < map->slots.size() && !map->occupied[i]) ++i; }
+
+	public:
+		Iter() = default;
+		operator Iter<true>() const { return Iter<true>(map, i); }
+
+		Entry& operator*() const { return map->slots[i]; }
+		Entry* operator->() const { return &map->slots[i]; }
+		Iter& operator++() { ++i; skip(); return *this; }
+		Iter operator++(int) { Iter it = *this; ++*this; return it; }
+		bool operator==(const Iter& other) const { return map == other.map && i == other.i; }
+	};
+
+	typedef Iter<false> iterator;
+	typedef Iter<true> const_iterator;
+
+	PixelMap() = default;
+	PixelMap(const PixelMap&) = default;
+	PixelMap(PixelMap&& other) noexcept : slots(std::move(other.slots)), occupied(std::move(other.occupied)), count(other.count) { other.clear(); }
+	PixelMap& operator=(const PixelMap&) = default;
+	PixelMap& operator=(PixelMap&& other) noexcept
+	{
+		if (this != &other)
+		{
+			slots = std::move(other.slots);
+			occupied = std::move(other.occupied);
+			count = other.count;
+			other.clear();
+		}
+		return *this;
+	}
+
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+	// Heap footprint of the table, counting empty slots. Used for history weights.
+	size_t allocated_bytes() const { return slots.capacity() * sizeof(value_type) + occupied.capacity() / 8; }
+
+	void clear()
+	{
+		slots.clear();
+		occupied.clear();
+		count = 0;
+	}
+
+	void reserve(size_t n)
+	{
+		size_t capacity = capacity_for(n);
+		if (capacity > slots.size())
+			rehash(capacity);
+	}
+
+	// Reserves for every pixel in the inclusive bbox. Only worth it when most of the bbox will be filled, e.g. rectangle/ellipse fills.
+	void reserve(IntBounds bbox) { reserve(size_t(bbox.width()) * size_t(bbox.height())); }
+
+	Value& operator[](IPosition pos)
+	{
+		if (slots.empty() || 2 * (count + 1) > slots.size())
+			rehash(capacity_for(count + 1));
+		size_t i = probe(pos);
+		if (!occupied[i])
+		{
+			slots[i] = { pos, Value{} };
+			occupied[i] = true;
+			++count;
+		}
+		return slots[i].second;
+	}
+
+	iterator find(IPosition pos)
+	{
+		if (count == 0)
+			return end();
+		size_t i = probe(pos);
+		return occupied[i] ? iterator(this, i) : end();
+	}
+
+	const_iterator find(IPosition pos) const
+	{
+		if (count == 0)
+			return end();
+		size_t i = probe(pos);
+		return occupied[i] ? const_iterator(this, i) : end();
+	}
+
+	iterator begin() { return iterator(this, 0); }
+	iterator end() { return iterator(this, slots.size()); }
+	const_iterator begin() const { return const_iterator(this, 0); }
+	const_iterator end() const { return const_iterator(this, slots.size()); }
+};
@@ -0,0 +1,287 @@
+#include "Profiler.h"
+
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+
+#include <imgui/imgui.h>
+
+#include "GLutility.h"
+
+void ProfilerImpl::begin_frame()
+{
+	resolve_gpu_queries();
+	recording = enabled && !frozen;
+	if (!recording)
+		return;
+	if (frame_index >= FRAME_HISTORY && resolved_index <= frame_index - FRAME_HISTORY)
+	{
+		// the slot is reused before its queries were read back
+		std::vector<GPUQueries>& stale = pending_queries[frame_index % FRAME_HISTORY];
+		for (const GPUQueries& queries : stale)
+		{
+			free_queries.push_back(queries.begin);
+			free_queries.push_back(queries.end);
+		}
+		stale.clear();
+		resolved_index = frame_index - FRAME_HISTORY + 1;
+	}
+	last_issued_queries[frame_index % FRAME_HISTORY] = 0;
+	Frame& frame = current_frame();
+	frame.index = frame_index;
+	frame.zones.clear();
+	frame.start_ns = now_ns();
+	frame.end_ns = frame.start_ns;
+	depth = 0;
+	gl_binds_issued_at_start = GLS.counters.issued;
+	gl_binds_elided_at_start = GLS.counters.elided;
+}
+
+void ProfilerImpl::end_frame()
+{
+	if (!recording)
+		return;
+	Frame& frame = current_frame();
+	frame.end_ns = now_ns();
+	// zones still open, e.g. one around the whole frame, end with it
+	for (GPUQueries& queries : pending_queries[frame_index % FRAME_HISTORY])
+	{
+		if (frame.zones[queries.zone].end_ns < frame.zones[queries.zone].start_ns)
+			issue_end_query(queries);
+	}
+	for (Zone& zone : frame.zones)
+	{
+		if (zone.end_ns < zone.start_ns)
+			zone.end_ns = frame.end_ns;
+	}
+	frame.gl_binds_issued = GLS.counters.issued - gl_binds_issued_at_start;
+	frame.gl_binds_elided = GLS.counters.elided - gl_binds_elided_at_start;
+	++frame_index;
+	recording = false;
+}
+
+void ProfilerImpl::destroy()
+{
+	for (std::vector<GPUQueries>& pending : pending_queries)
+	{
+		for (const GPUQueries& queries : pending)
+		{
+			free_queries.push_back(queries.begin);
+			free_queries.push_back(queries.end);
+		}
+		pending.clear();
+	}
+	if (!free_queries.empty())
+	{
+		QUASAR_GL(glDeleteQueries((GLsizei)free_queries.size(), free_queries.data()));
+		free_queries.clear();
+	}
+}
+
+size_t ProfilerImpl::begin_zone(const char* name, bool gpu)
+{
+	if (!recording)
+		return -1;
+	Frame& frame = current_frame();
+	Zone zone;
+	zone.name = name;
+	zone.depth = depth++;
+	zone.start_ns = now_ns();
+	zone.end_ns = -1;
+	frame.zones.push_back(zone);
+	size_t index = frame.zones.size() - 1;
+	if (gpu && gpu_timing)
+	{
+		GPUQueries queries{ index, acquire_query(), acquire_query() };
+		QUASAR_GL(glQueryCounter(queries.begin, GL_TIMESTAMP));
+		last_issued_queries[frame_index % FRAME_HISTORY] = queries.begin;
+		pending_queries[frame_index % FRAME_HISTORY].push_back(queries);
+	}
+	return index;
+}
+
+void ProfilerImpl::end_zone(size_t zone)
+{
+	if (zone == size_t(-1) || !recording)
+		return;
+	current_frame().zones[zone].end_ns = now_ns();
+	--depth;
+	std::vector<GPUQueries>& pending = pending_queries[frame_index % FRAME_HISTORY];
+	for (auto iter = pending.rbegin(); iter != pending.rend(); ++iter)
+	{
+		if (iter->zone == zone)
+		{
+			issue_end_query(*iter);
+			break;
+		}
+	}
+}
+
+void ProfilerImpl::issue_end_query(GPUQueries& queries)
+{
+	QUASAR_GL(glQueryCounter(queries.end, GL_TIMESTAMP));
+	last_issued_queries[frame_index % FRAME_HISTORY] = queries.end;
+}
+
+long long ProfilerImpl::now_ns() const
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+GLuint ProfilerImpl::acquire_query()
+{
+	if (free_queries.empty())
+	{
+		GLuint query;
+		QUASAR_GL(glGenQueries(1, &query));
+		return query;
+	}
+	GLuint query = free_queries.back();
+	free_queries.pop_back();
+	return query;
+}
+
+void ProfilerImpl::resolve_gpu_queries()
+{
+	while (resolved_index < frame_index)
+	{
+		std::vector<GPUQueries>& pending = pending_queries[resolved_index % FRAME_HISTORY];
+		if (!pending.empty())
+		{
+			// timestamps complete in order, so the last one issued in the frame being available means all are
+			GLint available = 0;
+			QUASAR_GL(glGetQueryObjectiv(last_issued_queries[resolved_index % FRAME_HISTORY], GL_QUERY_RESULT_AVAILABLE, &available));
+			if (!available)
+				return;
+			Frame& frame = frames[resolved_index % FRAME_HISTORY];
+			for (const GPUQueries& queries : pending)
+			{
+				GLuint64 begin = 0, end = 0;
+				QUASAR_GL(glGetQueryObjectui64v(queries.begin, GL_QUERY_RESULT, &begin));
+				QUASAR_GL(glGetQueryObjectui64v(queries.end, GL_QUERY_RESULT, &end));
+				frame.zones[queries.zone].gpu_ns = (long long)(end - begin);
+				free_queries.push_back(queries.begin);
+				free_queries.push_back(queries.end);
+			}
+			pending.clear();
+		}
+		++resolved_index;
+	}
+}
+
+const ProfilerImpl::Frame* ProfilerImpl::last_resolved_frame() const
+{
+	if (resolved_index == 0 || frame_index - (resolved_index - 1) > FRAME_HISTORY)
+		return nullptr;
+	return &frames[(resolved_index - 1) % FRAME_HISTORY];
+}
+
+size_t ProfilerImpl::num_recorded_frames() const
+{
+	return (size_t)std::min<unsigned long long>(frame_index, FRAME_HISTORY);
+}
+
+const ProfilerImpl::Frame& ProfilerImpl::recorded_frame(size_t i) const
+{
+	return frames[(frame_index - num_recorded_frames() + i) % FRAME_HISTORY];
+}
+
+void ProfilerImpl::draw_overlay()
+{
+	if (!overlay_open)
+		return;
+	ImGui::SetNextWindowSize(ImVec2(480, 520), ImGuiCond_FirstUseEver);
+	if (ImGui::Begin("Frame profiler", &overlay_open))
+	{
+		ImGui::Checkbox("Record", &enabled);
+		ImGui::SameLine();
+		ImGui::Checkbox("Freeze", &frozen);
+		ImGui::SameLine();
+		ImGui::Checkbox("GPU timing", &gpu_timing);
+
+		size_t num_frames = num_recorded_frames();
+		if (num_frames > 0)
+		{
+			std::vector<float> frame_ms(num_frames);
+			float total_ms = 0.0f, max_ms = 0.0f;
+			for (size_t i = 0; i < num_frames; ++i)
+			{
+				frame_ms[i] = recorded_frame(i).cpu_ns() * 1e-6f;
+				total_ms += frame_ms[i];
+				max_ms = std::max(max_ms, frame_ms[i]);
+			}
+			ImGui::PlotLines("##FrameTimes", frame_ms.data(), (int)num_frames, 0, nullptr, 0.0f, max_ms * 1.1f, ImVec2(-1.0f, 80.0f));
+			ImGui::Text("Frame: %.2f ms avg, %.2f ms max over %d frames", total_ms / num_frames, max_ms, (int)num_frames);
+		}
+
+		if (const Frame* frame = last_resolved_frame())
+		{
+			ImGui::Text("Frame %llu: %.3f ms, GL binds: %llu issued, %llu elided", frame->index, frame->cpu_ns() * 1e-6, frame->gl_binds_issued, frame->gl_binds_elided);
+			if (ImGui::BeginTable("##Zones", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_SizingStretchProp))
+			{
+				ImGui::TableSetupColumn("Zone");
+				ImGui::TableSetupColumn("CPU ms");
+				ImGui::TableSetupColumn("GPU ms");
+				ImGui::TableHeadersRow();
+				for (const Zone& zone : frame->zones)
+				{
+					ImGui::TableNextRow();
+					ImGui::TableNextColumn();
+					ImGui::SetCursorPosX(ImGui::GetCursorPosX() + zone.depth * ImGui::GetStyle().IndentSpacing);
+					ImGui::TextUnformatted(zone.name);
+					ImGui::TableNextColumn();
+					ImGui::Text("%.3f", zone.cpu_ns() * 1e-6);
+					ImGui::TableNextColumn();
+					if (zone.gpu_ns >= 0)
+						ImGui::Text("%.3f", zone.gpu_ns * 1e-6);
+					else
+						ImGui::TextDisabled("-");
+				}
+				ImGui::EndTable();
+			}
+		}
+
+		if (ImGui::Button("Export Chrome trace"))
+		{
+			FilePath filepath = FileSystem::workspace_path("quasar_trace.json");
+			if (export_chrome_trace(filepath))
+				LOG << LOG.info << LOG.start << "Exported frame trace to \"" << filepath.c_str() << "\"." << LOG.endl;
+			else
+				LOG << LOG.error << LOG.start << "Could not export frame trace to \"" << filepath.c_str() << "\"." << LOG.endl;
+		}
+	}
+	ImGui::End();
+}
+
+static void write_trace_event(std::ofstream& file, bool& first, const char* name, int tid, long long start_ns, long long duration_ns)
+{
+	if (!first)
+		file << ",\n";
+	first = false;
+	file << "{\"name\":\"" << name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << tid
+		<< ",\"ts\":" << start_ns * 1e-3 << ",\"dur\":" << duration_ns * 1e-3 << "}";
+}
+
+// CPU zones go on thread 0. GPU durations go on thread 1, placed at the CPU time their zone started, since GL timestamps run on their own clock.
+bool ProfilerImpl::export_chrome_trace(const FilePath& filepath) const
+{
+	std::ofstream file(filepath.c_str());
+	if (!file)
+		return false;
+	file << std::fixed << std::setprecision(3); // microseconds
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool first = true;
+	for (size_t i = 0; i < num_recorded_frames(); ++i)
+	{
+		const Frame& frame = recorded_frame(i);
+		write_trace_event(file, first, "frame", 0, frame.start_ns, frame.cpu_ns());
+		for (const Zone& zone : frame.zones)
+		{
+			write_trace_event(file, first, zone.name, 0, zone.start_ns, zone.cpu_ns());
+			if (zone.gpu_ns >= 0)
+				write_trace_event(file, first, zone.name, 1, zone.start_ns, zone.gpu_ns);
+		}
+	}
+	file << "\n]}\n";
+	return (bool)file;
+}
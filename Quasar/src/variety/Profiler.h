@@ -0,0 +1,122 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <chrono>
+
+#include "Macros.h"
+#include "FileSystem.h"
+
+// Per-frame timing of the main loop. Zones are opened with QUASAR_PROFILE(name), which times its enclosing scope with steady_clock,
+// and nested zones record their depth. The zones of the last FRAME_HISTORY frames are kept in a ring, so a hitch can be inspected after it happened,
+// in the overlay or as a Chrome trace (chrome://tracing, Perfetto). Zone names must outlive the profiler, e.g. string literals.
+// With gpu_timing on, zones opened with QUASAR_PROFILE_GPU(name) also issue GL timestamp queries, which are read back once available,
+// a few frames later, so that the CPU never waits on them.
+class ProfilerImpl
+{
+public:
+	static constexpr size_t FRAME_HISTORY = 240;
+
+	struct Zone
+	{
+		const char* name = nullptr;
+		unsigned short depth = 0;
+		long long start_ns = 0;
+		long long end_ns = 0;
+		// GPU duration, or -1 if the zone wasn't GPU timed or its queries haven't been read back yet
+		long long gpu_ns = -1;
+
+		long long cpu_ns() const { return end_ns - start_ns; }
+	};
+
+	struct Frame
+	{
+		unsigned long long index = 0;
+		long long start_ns = 0;
+		long long end_ns = 0;
+		std::vector<Zone> zones;
+		unsigned long long gl_binds_issued = 0;
+		unsigned long long gl_binds_elided = 0;
+
+		long long cpu_ns() const { return end_ns - start_ns; }
+	};
+
+	bool enabled = true;
+	bool gpu_timing = false;
+	bool overlay_open = false;
+	bool frozen = false; // SETTINGS stops recording, so the overlay holds still
+
+private:
+	struct GPUQueries
+	{
+		size_t zone;
+		GLuint begin, end;
+	};
+
+	std::array<Frame, FRAME_HISTORY> frames;
+	std::array<std::vector<GPUQueries>, FRAME_HISTORY> pending_queries;
+	// The timestamp query issued last in each frame. With nested zones that is an outer zone's end, not the end of the last zone opened.
+	std::array<GLuint, FRAME_HISTORY> last_issued_queries = {};
+	std::vector<GLuint> free_queries;
+	unsigned long long frame_index = 0;
+	unsigned long long resolved_index = 0;
+	bool recording = false;
+	unsigned short depth = 0;
+	std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+	unsigned long long gl_binds_issued_at_start = 0;
+	unsigned long long gl_binds_elided_at_start = 0;
+
+public:
+	ProfilerImpl() = default;
+	ProfilerImpl(const ProfilerImpl&) = delete;
+	ProfilerImpl(ProfilerImpl&&) noexcept = delete;
+	~ProfilerImpl() = default;
+
+	void begin_frame();
+	void end_frame();
+	// Deletes the GL queries. Called while the context is still current.
+	void destroy();
+
+	size_t begin_zone(const char* name, bool gpu);
+	void end_zone(size_t zone);
+
+	long long now_ns() const;
+	// The last recorded frame whose zones are all resolved, or nullptr if none.
+	const Frame* last_resolved_frame() const;
+	size_t num_recorded_frames() const;
+	// i = 0 is the oldest recorded frame.
+	const Frame& recorded_frame(size_t i) const;
+
+	void draw_overlay();
+	bool export_chrome_trace(const FilePath& filepath) const;
+
+private:
+	Frame& current_frame() { return frames[frame_index % FRAME_HISTORY]; }
+	GLuint acquire_query();
+	void issue_end_query(GPUQueries& queries);
+	void resolve_gpu_queries();
+};
+
+inline ProfilerImpl Profiler;
+
+class ProfileZone
+{
+	size_t zone;
+
+public:
+	ProfileZone(const char* name, bool gpu = false) : zone(Profiler.begin_zone(name, gpu)) {}
+	ProfileZone(const ProfileZone&) = delete;
+	ProfileZone(ProfileZone&&) noexcept = delete;
+	~ProfileZone() { Profiler.end_zone(zone); }
+};
+
+// Builds that don't link Profiler.cpp, like the benchmarks, define QUASAR_NO_PROFILER.
+#ifdef QUASAR_NO_PROFILER
+#define QUASAR_PROFILE(name)
+#define QUASAR_PROFILE_GPU(name)
+#else
+#define QUASAR_PROFILE_CONCAT_IMPL(a, b) a##b
+#define QUASAR_PROFILE_CONCAT(a, b) QUASAR_PROFILE_CONCAT_IMPL(a, b)
+#define QUASAR_PROFILE(name) ProfileZone QUASAR_PROFILE_CONCAT(_profile_zone_, __LINE__)(name)
+#define QUASAR_PROFILE_GPU(name) ProfileZone QUASAR_PROFILE_CONCAT(_profile_zone_, __LINE__)(name, true)
+#endif
@@ -1,6 +1,16 @@
 #include "UTF.h"
 
 #include <stdexcept>
+#include <bit>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define QUASAR_UTF_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define QUASAR_UTF_SSE2
+#endif
 
 static constexpr int UTF_B1_CAP = 0b1000'0000; // 0x80
 static constexpr int UTF_B1_ERASURE = 0b0000'0000; // 0x00
@@ -48,6 +58,101 @@ static constexpr unsigned char UC(unsigned char c) { return static_cast<unsigned
 static constexpr unsigned char UC(int c) { return static_cast<unsigned char>(c); }
 static constexpr unsigned char UC(unsigned int c) { return static_cast<unsigned char>(c); }
 
+// Length of the ASCII run starting at utf8, scanning whole 32/16-byte blocks before falling back to single bytes.
+static size_t ascii_run(const char8_t* utf8, size_t length)
+{
+	size_t i = 0;
+#ifdef QUASAR_UTF_AVX2
+	for (; i + 32 <= length; i += 32)
+	{
+		unsigned int mask = static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(utf8 + i))));
+		if (mask)
+			return i + std::countr_zero(mask);
+	}
+#endif
+#ifdef QUASAR_UTF_SSE2
+	for (; i + 16 <= length; i += 16)
+	{
+		unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(utf8 + i))));
+		if (mask)
+			return i + std::countr_zero(mask);
+	}
+#endif
+	while (i < length && UC(utf8[i]) < UTF_B1_CAP)
+		++i;
+	return i;
+}
+
+template<typename Unit>
+static void widen_ascii(const char8_t* utf8, size_t length, Unit* out)
+{
+	size_t i = 0;
+#ifdef QUASAR_UTF_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	for (; i + 16 <= length; i += 16)
+	{
+		__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(utf8 + i));
+		__m128i lo = _mm_unpacklo_epi8(bytes, zero);
+		__m128i hi = _mm_unpackhi_epi8(bytes, zero);
+		if constexpr (sizeof(Unit) == 2)
+		{
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), lo);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 8), hi);
+		}
+		else
+		{
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_unpacklo_epi16(lo, zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 4), _mm_unpackhi_epi16(lo, zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 8), _mm_unpacklo_epi16(hi, zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 12), _mm_unpackhi_epi16(hi, zero));
+		}
+	}
+#endif
+	for (; i < length; ++i)
+		out[i] = static_cast<Unit>(utf8[i]);
+}
+
+// Appends the leading block-aligned ASCII run of [units, units + length) to utf8 and returns its length.
+template<typename Unit>
+static size_t narrow_ascii(const Unit* units, size_t length, std::u8string& utf8)
+{
+	size_t i = 0;
+#ifdef QUASAR_UTF_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	char8_t block[16];
+	if constexpr (sizeof(Unit) == 2)
+	{
+		const __m128i non_ascii = _mm_set1_epi16(static_cast<short>(0xFF80));
+		for (; i + 16 <= length; i += 16)
+		{
+			__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(units + i));
+			__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(units + i + 8));
+			if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(_mm_or_si128(a, b), non_ascii), zero)) != 0xFFFF)
+				break;
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(block), _mm_packus_epi16(a, b));
+			utf8.append(block, 16);
+		}
+	}
+	else
+	{
+		const __m128i non_ascii = _mm_set1_epi32(static_cast<int>(0xFFFFFF80));
+		for (; i + 16 <= length; i += 16)
+		{
+			__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(units + i));
+			__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(units + i + 4));
+			__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(units + i + 8));
+			__m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(units + i + 12));
+			__m128i all = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+			if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(all, non_ascii), zero)) != 0xFFFF)
+				break;
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(block), _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+			utf8.append(block, 16);
+		}
+	}
+#endif
+	return i;
+}
+
 static void encode_into(char32_t codepoint, char8_t quad[4], std::u8string& utf8, bool ignore_invalid_chars)
 {
 	if (codepoint <= CODEPOINT_B1_MAX)
@@ -91,12 +196,24 @@ static void encode_into(char32_t codepoint, char8_t quad[4], std::u8string& utf8
 std::u8string UTF::encode(const std::u16string& utf16, bool ignore_invalid_chars)
 {
 	std::u8string utf8;
+	utf8.reserve(utf16.size());
 	char8_t quad[4]{ 0, 0, 0, 0 };
 	char32_t codepoint = 0;
+	size_t next_block = 0;
 
 	for (size_t i = 0; i < utf16.size(); ++i)
 	{
 		codepoint = CH<32>(utf16[i]);
+		if (codepoint <= CODEPOINT_B1_MAX && i >= next_block)
+		{
+			size_t run = narrow_ascii(utf16.data() + i, utf16.size() - i, utf8);
+			if (run > 0)
+			{
+				i += run - 1;
+				continue;
+			}
+			next_block = i + 16;
+		}
 
 		if (codepoint >= UTF_SURR_HIGH_OFFSET && codepoint <= UTF_SURR_HIGH_MAX)
 		{
@@ -133,6 +250,7 @@ std::u8string UTF::encode(const std::u16string& utf16, bool ignore_invalid_chars
 std::u16string UTF::decode_utf16(const std::u8string& utf8)
 {
 	std::u16string utf16;
+	utf16.reserve(utf8.size());
 
 	for (size_t i = 0; i < utf8.size();)
 	{
@@ -140,9 +258,13 @@ std::u16string UTF::decode_utf16(const std::u8string& utf8)
 		char32_t character = 0;
 
 		if ((byte & UTF_B1_CAP) == UTF_B1_ERASURE) {
-			// 1-byte (ASCII)
-			character |= byte;
-			i += 1;
+			// ASCII run
+			size_t run = ascii_run(utf8.data() + i, utf8.size() - i);
+			size_t offset = utf16.size();
+			utf16.resize(offset + run);
+			widen_ascii(utf8.data() + i, run, utf16.data() + offset);
+			i += run;
+			continue;
 		}
 		else if ((byte & UTF_B2_CAP) == UTF_B2_ERASURE) {
 			// 2-byte
@@ -186,15 +308,30 @@ std::u16string UTF::decode_utf16(const std::u8string& utf8)
 std::u8string UTF::encode(const std::u32string& utf32, bool ignore_invalid_chars)
 {
 	std::u8string utf8;
+	utf8.reserve(utf32.size());
 	char8_t quad[4]{ 0, 0, 0, 0 };
-	for (char32_t codepoint : utf32)
-		encode_into(codepoint, quad, utf8, ignore_invalid_chars);
+	size_t next_block = 0;
+	for (size_t i = 0; i < utf32.size();)
+	{
+		if (utf32[i] <= CODEPOINT_B1_MAX && i >= next_block)
+		{
+			size_t run = narrow_ascii(utf32.data() + i, utf32.size() - i, utf8);
+			if (run > 0)
+			{
+				i += run;
+				continue;
+			}
+			next_block = i + 16;
+		}
+		encode_into(utf32[i++], quad, utf8, ignore_invalid_chars);
+	}
 	return utf8;
 }
 
 std::u32string UTF::decode_utf32(const std::u8string& utf8)
 {
 	std::u32string utf32;
+	utf32.reserve(utf8.size());
 	size_t i = 0;
 	while (i < utf8.size())
 	{
@@ -203,9 +340,13 @@ std::u32string UTF::decode_utf32(const std::u8string& utf8)
 
 		if ((byte & UTF_B1_CAP) == UTF_B1_ERASURE)
 		{
-			// 1-byte (ASCII)
-			character |= CH<32>(byte);
-			i += 1;
+			// ASCII run
+			size_t run = ascii_run(utf8.data() + i, utf8.size() - i);
+			size_t offset = utf32.size();
+			utf32.resize(offset + run);
+			widen_ascii(utf8.data() + i, run, utf32.data() + offset);
+			i += run;
+			continue;
 		}
 		else if ((byte & UTF_B2_CAP) == UTF_B2_ERASURE)
 		{
@@ -255,8 +396,8 @@ std::string UTF::convert(const std::u8string& utf8)
 
 int UTF::String::Iterator::codepoint() const
 {
-	if (i >= string.str.size()) throw std::out_of_range("End of string");
-	unsigned char first = UC(string.str[i]);
+	if (i >= str.size()) throw std::out_of_range("End of string");
+	unsigned char first = UC(str[i]);
 	char32_t codepoint = 0;
 
 	if (first < UTF_B1_CAP)
@@ -265,24 +406,24 @@ int UTF::String::Iterator::codepoint() const
 	}
 	else if (first < UTF_B2_CAP)
 	{
-		if (i + 1 >= string.str.size()) throw std::out_of_range("Invalid UTF-8");
+		if (i + 1 >= str.size()) throw std::out_of_range("Invalid UTF-8");
 		codepoint |= (first & UTF_B2_MASK) << 6;
-		codepoint |= (UC(string.str[i + 1]) & UTF_CONT_MASK);
+		codepoint |= (UC(str[i + 1]) & UTF_CONT_MASK);
 	}
 	else if (first < UTF_B3_CAP)
 	{
-		if (i + 2 >= string.str.size()) throw std::out_of_range("Invalid UTF-8");
+		if (i + 2 >= str.size()) throw std::out_of_range("Invalid UTF-8");
 		codepoint |= (first & UTF_B3_MASK) << 12;
-		codepoint |= (UC(string.str[i + 1]) & UTF_CONT_MASK) << 6;
-		codepoint |= (UC(string.str[i + 2]) & UTF_CONT_MASK);
+		codepoint |= (UC(str[i + 1]) & UTF_CONT_MASK) << 6;
+		codepoint |= (UC(str[i + 2]) & UTF_CONT_MASK);
 	}
 	else if (first < UTF_B4_CAP)
 	{
-		if (i + 3 >= string.str.size()) throw std::out_of_range("Invalid UTF-8");
+		if (i + 3 >= str.size()) throw std::out_of_range("Invalid UTF-8");
 		codepoint |= (first & UTF_B4_MASK) << 18;
-		codepoint |= (UC(string.str[i + 1]) & UTF_CONT_MASK) << 12;
-		codepoint |= (UC(string.str[i + 2]) & UTF_CONT_MASK) << 6;
-		codepoint |= (UC(string.str[i + 3]) & UTF_CONT_MASK);
+		codepoint |= (UC(str[i + 1]) & UTF_CONT_MASK) << 12;
+		codepoint |= (UC(str[i + 2]) & UTF_CONT_MASK) << 6;
+		codepoint |= (UC(str[i + 3]) & UTF_CONT_MASK);
 	}
 
 	return codepoint;
@@ -293,7 +434,7 @@ UTF::String::Iterator& UTF::String::Iterator::operator--()
 	if (i == 0)
 		throw std::out_of_range("Start of string");
 	--i;
-	while ((UC(string.str[i]) & UTF_CONT_CAPTURE) == UTF_CONT_HEAD)
+	while ((UC(str[i]) & UTF_CONT_CAPTURE) == UTF_CONT_HEAD)
 	{
 		if (i == 0)
 			throw std::runtime_error("UTF-8 invalid starting byte");
@@ -304,11 +445,11 @@ UTF::String::Iterator& UTF::String::Iterator::operator--()
 
 UTF::String::Iterator UTF::String::Iterator::operator--(int)
 {
-	Iterator it(string, i);
+	Iterator it(*this);
 	if (i == 0)
 		throw std::out_of_range("Start of string");
 	--i;
-	while ((UC(string.str[i]) & UTF_CONT_CAPTURE) == UTF_CONT_HEAD)
+	while ((UC(str[i]) & UTF_CONT_CAPTURE) == UTF_CONT_HEAD)
 	{
 		if (i == 0)
 			throw std::runtime_error("UTF-8 invalid starting byte");
@@ -319,7 +460,7 @@ UTF::String::Iterator UTF::String::Iterator::operator--(int)
 
 char UTF::String::Iterator::num_bytes() const
 {
-	unsigned char first = UC(string.str[i]);
+	unsigned char first = UC(str[i]);
 	if (first < UTF_B1_CAP)
 		return 1;
 	else if (first < UTF_B2_CAP)
@@ -334,8 +475,8 @@ char UTF::String::Iterator::num_bytes() const
 
 int UTF::String::Iterator::advance()
 {
-	if (i >= string.str.size()) throw std::out_of_range("End of string");
-	unsigned char first = UC(string.str[i]);
+	if (i >= str.size()) throw std::out_of_range("End of string");
+	unsigned char first = UC(str[i]);
 	char32_t codepoint = 0;
 
 	if (first < UTF_B1_CAP)
@@ -345,26 +486,26 @@ int UTF::String::Iterator::advance()
 	}
 	else if (first < UTF_B2_CAP)
 	{
-		if (i + 1 >= string.str.size()) throw std::out_of_range("Invalid UTF-8");
+		if (i + 1 >= str.size()) throw std::out_of_range("Invalid UTF-8");
 		codepoint |= (first & UTF_B2_MASK) << 6;
-		codepoint |= (UC(string.str[i + 1]) & UTF_CONT_MASK);
+		codepoint |= (UC(str[i + 1]) & UTF_CONT_MASK);
 		i += 2;
 	}
 	else if (first < UTF_B3_CAP)
 	{
-		if (i + 2 >= string.str.size()) throw std::out_of_range("Invalid UTF-8");
+		if (i + 2 >= str.size()) throw std::out_of_range("Invalid UTF-8");
 		codepoint |= (first & UTF_B3_MASK) << 12;
-		codepoint |= (UC(string.str[i + 1]) & UTF_CONT_MASK) << 6;
-		codepoint |= (UC(string.str[i + 2]) & UTF_CONT_MASK);
+		codepoint |= (UC(str[i + 1]) & UTF_CONT_MASK) << 6;
+		codepoint |= (UC(str[i + 2]) & UTF_CONT_MASK);
 		i += 3;
 	}
 	else if (first < UTF_B4_CAP)
 	{
-		if (i + 3 >= string.str.size()) throw std::out_of_range("Invalid UTF-8");
+		if (i + 3 >= str.size()) throw std::out_of_range("Invalid UTF-8");
 		codepoint |= (first & UTF_B4_MASK) << 18;
-		codepoint |= (UC(string.str[i + 1]) & UTF_CONT_MASK) << 12;
-		codepoint |= (UC(string.str[i + 2]) & UTF_CONT_MASK) << 6;
-		codepoint |= (UC(string.str[i + 3]) & UTF_CONT_MASK);
+		codepoint |= (UC(str[i + 1]) & UTF_CONT_MASK) << 12;
+		codepoint |= (UC(str[i + 2]) & UTF_CONT_MASK) << 6;
+		codepoint |= (UC(str[i + 3]) & UTF_CONT_MASK);
 		i += 4;
 	}
 	else
@@ -436,26 +577,25 @@ UTF::String& UTF::String::operator*=(size_t n)
 
 UTF::String::String(const Iterator& begin_, const Iterator& end_)
 {
-	if (&begin_.string == &end_.string)
-		str = begin_.string.str.substr(begin_.i, end_.i - begin_.i);
+	if (begin_.str.data() == end_.str.data())
+		str = begin_.str.substr(begin_.i, end_.i - begin_.i);
 	else
 		throw std::runtime_error("UTF::String iterators are not compatible.");
 }
 
 UTF::String UTF::String::substr(size_t begin_, size_t end_) const
 {
-	Iterator index = begin();
+	// A single walk from the start to end_, rather than a walk per bound.
+	if (begin_ > end_)
+		throw std::out_of_range("Substring is out of range");
+	Iterator b = begin();
 	size_t i = 0;
-	while (i < begin_)
-	{
-		++index;
-		++i;
-	}
-	Iterator b = index;
-	while (i < end_)
-	{
-		++index;
-		++i;
-	}
-	return String(b, index);
+	for (; i < begin_ && b; ++i)
+		++b;
+	Iterator e = b;
+	for (; i < end_ && e; ++i)
+		++e;
+	if (i < end_)
+		throw std::out_of_range("Substring is out of range");
+	return String(b, e);
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <variant>
 
@@ -38,11 +39,11 @@ namespace UTF
 		{
 		private:
 			friend class UTF::String;
-			const String& string;
+			std::u8string_view str;
 			size_t i;
 
 		public:
-			Iterator(const String& string, size_t i) : string(string), i(i) {}
+			Iterator(std::u8string_view str, size_t i) : str(str), i(i) {}
 			Iterator(const Iterator&) = default;
 			Iterator(Iterator&&) noexcept = default;
 			Iterator& operator=(const Iterator&) = default;
@@ -50,18 +51,19 @@ namespace UTF
 
 			int codepoint() const;
 			Iterator& operator++() { i += num_bytes(); return *this; }
-			Iterator operator++(int) { Iterator iter(string, i); i += num_bytes(); return iter; }
+			Iterator operator++(int) { Iterator iter(*this); i += num_bytes(); return iter; }
 			Iterator& operator--();
 			Iterator operator--(int);
-			bool operator==(const Iterator& other) const { return string.str == other.string.str && i == other.i; }
-			bool operator!=(const Iterator& other) const { return string.str != other.string.str || i != other.i; }
+			// Iterators are equal when they walk the same string or view, by identity rather than contents, and sit at the same offset.
+			bool operator==(const Iterator& other) const { return str.data() == other.str.data() && str.size() == other.str.size() && i == other.i; }
+			bool operator!=(const Iterator& other) const { return !(*this == other); }
 			char num_bytes() const;
-			operator bool() const { return i < string.str.size(); }
+			operator bool() const { return i < str.size(); }
 			int advance();
 		};
 
-		Iterator begin() const { return Iterator(*this, 0); }
-		Iterator end() const { return Iterator(*this, str.size()); }
+		Iterator begin() const { return Iterator(str, 0); }
+		Iterator end() const { return Iterator(str, str.size()); }
 		size_t size() const { return str.size(); }
 		bool empty() const { return str.empty(); }
 		std::u8string& encoding() { return str; }
@@ -79,6 +81,30 @@ namespace UTF
 		String(const Iterator& begin_, const Iterator& end_);
 		String substr(size_t begin_, size_t end_) const;
 	};
+
+	// Non-owning view into UTF-8 data, for code that only walks text. Strings and UTF-8 literals convert to it without copying.
+	class StringView
+	{
+		std::u8string_view str;
+
+	public:
+		typedef String::Iterator Iterator;
+
+		StringView() = default;
+		StringView(std::u8string_view str) : str(str) {}
+		StringView(const String& string) : str(string.encoding()) {}
+		StringView(const char8_t* str) : str(str) {}
+		StringView(const StringView&) = default;
+		StringView(StringView&&) noexcept = default;
+		StringView& operator=(const StringView&) = default;
+		StringView& operator=(StringView&&) noexcept = default;
+
+		Iterator begin() const { return Iterator(str, 0); }
+		Iterator end() const { return Iterator(str, str.size()); }
+		size_t size() const { return str.size(); }
+		bool empty() const { return str.empty(); }
+		std::u8string_view encoding() const { return str; }
+	};
 }
 
 template<> struct std::hash<UTF::String> { size_t operator()(const UTF::String& string) const { return string.hash(); } };
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <climits>
+#include <cfloat>
 #include <cmath>
 #include <concepts>
 
@@ -21,7 +22,7 @@ constexpr int floori(float x)
 
 constexpr float modulo(float x, float y)
 {
-	return y != 0.0f ? x - y * std::floorf(x / y) : 0.0f;
+	return y != 0.0f ? x - y * std::floor(x / y) : 0.0f;
 }
 
 constexpr float absolute(float x)
@@ -41,7 +42,18 @@ constexpr unsigned char hex_to_byte(unsigned int hex)
 	else if constexpr (i == 3)
 		return (hex & 0xFF000000) >> 24;
 	else
-		static_assert(false);
+		static_assert(i < 4);
+}
+
+// splitmix64 finalizer: every input bit affects every output bit, so packed coordinates/channels don't cancel out like XOR does.
+constexpr size_t mix_hash(unsigned long long x)
+{
+	x ^= x >> 30;
+	x *= 0xBF58476D1CE4E5B9ull;
+	x ^= x >> 27;
+	x *= 0x94D049BB133111EBull;
+	x ^= x >> 31;
+	return static_cast<size_t>(x);
 }
 
 inline int ceil_divide(int x, int y)
@@ -0,0 +1,165 @@
+#include "Bench.h"
+
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <algorithm>
+#include <numeric>
+#include <cstring>
+
+#include "variety/GLutility.h"
+#include "variety/FileSystem.h"
+
+namespace Bench
+{
+	bool Runner::selected(const char* name) const
+	{
+		return options.filter.empty() || std::string(name).find(options.filter) != std::string::npos;
+	}
+
+	void Runner::measure(const char* name, double items, const std::function<void()>& body, const std::function<void()>& reset)
+	{
+		if (!selected(name))
+			return;
+		typedef std::chrono::steady_clock Clock;
+		if (reset)
+			reset();
+		body();
+
+		std::vector<double> times;
+		double total_ns = 0.0;
+		while (times.size() < options.max_iterations && (times.size() < options.min_iterations || total_ns < options.min_time * 1e9))
+		{
+			if (reset)
+				reset();
+			auto start = Clock::now();
+			body();
+			double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+			times.push_back(ns);
+			total_ns += ns;
+		}
+
+		Result result;
+		result.name = name;
+		result.size = size;
+		result.iterations = times.size();
+		result.items = items;
+		result.mean_ns = total_ns / times.size();
+		std::sort(times.begin(), times.end());
+		result.min_ns = times.front();
+		result.median_ns = times.size() % 2 ? times[times.size() / 2] : 0.5 * (times[times.size() / 2 - 1] + times[times.size() / 2]);
+		write_json(out, result);
+	}
+
+	void Runner::check(const char* name, bool passed)
+	{
+		if (!selected(name))
+			return;
+		if (!passed)
+			++failures;
+		out << "{\"check\":\"" << name << "\",\"size\":" << size << ",\"passed\":" << (passed ? "true" : "false") << "}" << std::endl;
+	}
+
+	void write_json(std::ostream& out, const Result& result)
+	{
+		out << "{\"benchmark\":\"" << result.name << "\",\"size\":" << result.size << ",\"iterations\":" << result.iterations
+			<< ",\"min_ns\":" << (long long)result.min_ns << ",\"median_ns\":" << (long long)result.median_ns << ",\"mean_ns\":" << (long long)result.mean_ns;
+		if (result.items > 0.0 && result.median_ns > 0.0)
+			out << ",\"items_per_second\":" << (long long)(result.items * 1e9 / result.median_ns);
+		out << "}" << std::endl;
+	}
+
+	unsigned int Random::next()
+	{
+		// splitmix64
+		unsigned long long z = (state += 0x9E3779B97F4A7C15ull);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return (unsigned int)((z ^ (z >> 31)) >> 32);
+	}
+}
+
+static void print_usage()
+{
+	std::cerr << "usage: QuasarBench [--sizes 64,256,...] [--filter substring] [--min-time seconds] [--out results.jsonl] [--resources dir] [--exhaustive] [--list]\n";
+}
+
+static std::vector<int> parse_sizes(const char* arg)
+{
+	std::vector<int> sizes;
+	const char* p = arg;
+	while (*p)
+	{
+		char* end;
+		long size = std::strtol(p, &end, 10);
+		if (end == p)
+			break;
+		if (size > 0)
+			sizes.push_back((int)size);
+		p = *end == ',' ? end + 1 : end;
+	}
+	return sizes;
+}
+
+// One JSON line per benchmark, check and size, on stdout or in the --out file. Exits with 2 if any check failed.
+int main(int argc, char** argv)
+{
+	Bench::Options options;
+	const char* out_path = nullptr;
+	FileSystem::resources_root = "../Quasar/.quasar/"; // relative to the project directory, where Visual Studio runs it
+	bool list = false;
+	for (int i = 1; i < argc; ++i)
+	{
+		bool has_value = i + 1 < argc;
+		if (!strcmp(argv[i], "--sizes") && has_value)
+			options.sizes = parse_sizes(argv[++i]);
+		else if (!strcmp(argv[i], "--filter") && has_value)
+			options.filter = argv[++i];
+		else if (!strcmp(argv[i], "--min-time") && has_value)
+			options.min_time = std::atof(argv[++i]);
+		else if (!strcmp(argv[i], "--out") && has_value)
+			out_path = argv[++i];
+		else if (!strcmp(argv[i], "--resources") && has_value)
+			FileSystem::resources_root = argv[++i];
+		else if (!strcmp(argv[i], "--exhaustive"))
+			options.exhaustive = true;
+		else if (!strcmp(argv[i], "--list"))
+			list = true;
+		else
+		{
+			print_usage();
+			return 1;
+		}
+	}
+	if (list)
+	{
+		for (const auto& [name, _] : Bench::suites)
+			std::cout << name << "\n";
+		return 0;
+	}
+
+	GLS.headless = true;
+	std::ofstream file;
+	if (out_path)
+	{
+		file.open(out_path);
+		if (!file)
+		{
+			std::cerr << "could not open " << out_path << "\n";
+			return 1;
+		}
+	}
+	Bench::Runner runner(options, out_path ? file : std::cout);
+	for (int size : options.sizes)
+	{
+		runner.set_size(size);
+		for (const auto& [name, suite] : Bench::suites)
+			suite(runner);
+	}
+	if (runner.failed_checks())
+	{
+		std::cerr << runner.failed_checks() << " check(s) failed\n";
+		return 2;
+	}
+	return 0;
+}
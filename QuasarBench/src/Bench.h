@@ -0,0 +1,75 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <functional>
+#include <ostream>
+
+// Headless benchmarks of the editing core. No window or GL context is created: images never generate textures, and GLS is headless.
+// Inputs are generated from a fixed seed, so every run measures the same work.
+namespace Bench
+{
+	struct Result
+	{
+		std::string name;
+		int size = 0;
+		size_t iterations = 0;
+		double min_ns = 0.0;
+		double median_ns = 0.0;
+		double mean_ns = 0.0;
+		// Units of work per iteration, e.g. pixels, for the throughput column. 0 if it doesn't apply.
+		double items = 0.0;
+	};
+
+	struct Options
+	{
+		std::vector<int> sizes = { 64, 256, 1024, 4096, 8192 };
+		std::string filter;
+		double min_time = 0.5; // seconds per benchmark
+		size_t min_iterations = 3;
+		size_t max_iterations = 1000;
+		bool exhaustive = false; // run checks over their whole input space where they support it, rather than a sample
+	};
+
+	class Runner
+	{
+		const Options& options;
+		std::ostream& out;
+		int size = 0;
+		size_t failures = 0;
+
+	public:
+		Runner(const Options& options, std::ostream& out) : options(options), out(out) {}
+
+		int current_size() const { return size; }
+		void set_size(int size_) { size = size_; }
+		bool selected(const char* name) const;
+		bool exhaustive() const { return options.exhaustive; }
+
+		// Times body after one untimed warm-up run. reset, if given, runs untimed before every run of body, e.g. to restore an image
+		// that body modifies. The result is written out as one JSON line.
+		void measure(const char* name, double items, const std::function<void()>& body, const std::function<void()>& reset = {});
+		// Records a correctness check next to the timings, e.g. that a fast path agrees with its reference. Written out as one JSON line.
+		void check(const char* name, bool passed);
+		size_t failed_checks() const { return failures; }
+	};
+
+	// Writes a result as one JSON object on its own line.
+	void write_json(std::ostream& out, const Result& result);
+
+	typedef void(*Suite)(Runner& runner);
+	// Defined in BenchCases.cpp, in the order they run.
+	extern const std::vector<std::pair<const char*, Suite>> suites;
+
+	// Deterministic pseudo-random data, the same on every platform.
+	class Random
+	{
+		unsigned long long state;
+
+	public:
+		Random(unsigned long long seed = 0x9E3779B97F4A7C15ull) : state(seed) {}
+
+		unsigned int next();
+		int next_int(int bound) { return int(next() % (unsigned int)bound); }
+	};
+}
@@ -0,0 +1,1330 @@
+#include "Bench.h"
+
+#include <filesystem>
+#include <memory>
+#include <cstring>
+#include <thread>
+#include <atomic>
+#include <map>
+#include <set>
+#include <array>
+#include <unordered_map>
+
+#include "edit/image/Image.h"
+#include "edit/image/PixelBufferPaths.h"
+#include "edit/image/PaintActions.h"
+#include "edit/image/MipPyramid.h"
+#include "edit/image/Filters.h"
+#include "edit/color/ColorBuffer.h"
+#include "edit/color/ColorScheme.h"
+#include "edit/color/PaletteLookup.h"
+#include "edit/color/ColorHistogram.h"
+#include "edit/color/Quantize.h"
+#include "pipeline/text/TextLayout.h"
+#include "pipeline/render/SpriteBatchQueue.h"
+#include "variety/GLutility.h"
+#include "variety/History.h"
+#include "variety/UTF.h"
+#include "variety/Utils.h"
+
+using Bench::Runner;
+
+static volatile long long sink = 0;
+
+// A gradient with noise in the low bits, so that compression and colour conversions see something closer to artwork than to pure noise.
+static std::shared_ptr<Image> make_image(int width, int height, CHPP chpp, unsigned long long seed = 1)
+{
+	Bench::Random random(seed);
+	auto image = std::make_shared<Image>();
+	image->buf.width = width;
+	image->buf.height = height;
+	image->buf.chpp = chpp;
+	image->buf.pxnew();
+	for (Dim y = 0; y < height; ++y)
+	{
+		for (Dim x = 0; x < width; ++x)
+		{
+			Byte* pixel = image->buf.pos(x, y);
+			unsigned int noise = random.next();
+			Byte channels[4] = {
+				Byte(x * 255 / std::max(width - 1, 1) ^ (noise & 0xF)),
+				Byte(y * 255 / std::max(height - 1, 1) ^ ((noise >> 4) & 0xF)),
+				Byte((x + y) * 127 / std::max(width + height - 2, 1) ^ ((noise >> 8) & 0xF)),
+				Byte(noise >> 24 < 16 ? 0 : 255)
+			};
+			memcpy(pixel, channels, chpp);
+		}
+	}
+	return image;
+}
+
+static void restore(const Image& image, const Image& original)
+{
+	memcpy(image.buf.pixels, original.buf.pixels, original.buf.bytes());
+}
+
+// A stroke through random waypoints, rasterized the way Canvas does between cursor positions, about 8 image widths long.
+static std::vector<IPosition> make_stroke(int size, unsigned long long seed = 2)
+{
+	Bench::Random random(seed);
+	std::vector<IPosition> stroke;
+	IPosition from{ random.next_int(size), random.next_int(size) };
+	DiscreteLineInterpolator interp;
+	while (stroke.size() < 8 * (size_t)size)
+	{
+		IPosition to{ random.next_int(size), random.next_int(size) };
+		interp.start = from;
+		interp.finish = to;
+		interp.sync_with_endpoints();
+		IPosition pos;
+		for (unsigned int i = 0; i < interp.length; ++i)
+		{
+			interp.at(i, pos.x, pos.y);
+			stroke.push_back(pos);
+		}
+		from = to;
+	}
+	return stroke;
+}
+
+// Four strokes along each diagonal. Under the old xor hash every pixel on the main diagonal shared one bucket and (x, y)/(y, x) pairs collided across them.
+static std::vector<IPosition> make_diagonal_stroke(int size)
+{
+	std::vector<IPosition> stroke;
+	DiscreteLineInterpolator interp;
+	for (int offset = 0; offset < 4; ++offset)
+	{
+		for (int anti = 0; anti < 2; ++anti)
+		{
+			interp.start = anti ? IPosition{ size - 1 - offset, 0 } : IPosition{ offset, 0 };
+			interp.finish = anti ? IPosition{ 0, size - 1 - offset } : IPosition{ size - 1, size - 1 - offset };
+			interp.sync_with_endpoints();
+			IPosition pos;
+			for (unsigned int i = 0; i < interp.length; ++i)
+			{
+				interp.at(i, pos.x, pos.y);
+				stroke.push_back(pos);
+			}
+		}
+	}
+	return stroke;
+}
+
+typedef PixelMap<std::pair<PixelRGBA, PixelRGBA>> StrokeStorage;
+// How strokes were stored before PixelMap, as the reference for it.
+typedef std::unordered_map<IPosition, std::pair<PixelRGBA, PixelRGBA>> ReferenceStrokeStorage;
+
+// What CBImpl::Paint::brush_pencil() does per pixel, without the texture upload.
+template<typename Storage>
+static void brush_pencil(const Image& image, Storage& storage, IPosition pos, PixelRGBA color, float applied_alpha)
+{
+	PixelRGBA initial_c = image.pixel_color_at(pos.x, pos.y);
+	PixelRGBA blended_c{ 0, 0, 0, 0 };
+	for (CHPP i = 0; i < 4; ++i)
+	{
+		if (i < 3)
+			blended_c.at(i) = std::clamp(roundi(color[i] * applied_alpha + initial_c[i] * (1 - applied_alpha)), 0, 255);
+		else
+			blended_c.at(i) = std::clamp(roundi(applied_alpha * 255 + initial_c[i] * (1 - applied_alpha)), 0, 255);
+	}
+	image.set_pixel_color(pos.x, pos.y, blended_c);
+	PixelRGBA final_c = image.pixel_color_at(pos.x, pos.y);
+	auto iter = storage.find(pos);
+	if (iter == storage.end())
+		storage[pos] = { initial_c, final_c };
+	else
+		iter->second.second = final_c;
+}
+
+static IntBounds stroke_bounds(const std::vector<IPosition>& stroke)
+{
+	IntBounds bbox{ INT_MAX, INT_MIN, INT_MAX, INT_MIN };
+	for (IPosition pos : stroke)
+	{
+		bbox.x1 = std::min(bbox.x1, pos.x);
+		bbox.x2 = std::max(bbox.x2, pos.x);
+		bbox.y1 = std::min(bbox.y1, pos.y);
+		bbox.y2 = std::max(bbox.y2, pos.y);
+	}
+	return bbox;
+}
+
+template<typename Storage = StrokeStorage>
+static Storage paint_stroke(const Image& image, const std::vector<IPosition>& stroke)
+{
+	Storage storage;
+	for (IPosition pos : stroke)
+		brush_pencil(image, storage, pos, PixelRGBA{ 200, 40, 90, 255 }, 0.5f);
+	return storage;
+}
+
+static void buffer_suite(Runner& runner)
+{
+	int size = runner.current_size();
+	double area = double(size) * size;
+	auto image = make_image(size, size, 4);
+	const Buffer& buf = image->buf;
+	runner.measure("buffer/flip_horizontally", area, [&]() { buf.flip_horizontally(); });
+	runner.measure("buffer/flip_vertically", area, [&]() { buf.flip_vertically(); });
+	runner.measure("buffer/rotate_90", area, [&]() { delete[] buf.rotate_90_ret_new().pixels; });
+	runner.measure("buffer/rotate_180", area, [&]() { buf.rotate_180(); });
+	runner.measure("buffer/rotate_270", area, [&]() { delete[] buf.rotate_270_ret_new().pixels; });
+}
+
+static void subbuffer_copy_suite(Runner& runner)
+{
+	int size = runner.current_size();
+	int half = std::max(size / 2, 1);
+	auto src = make_image(size, size, 4);
+	auto dest = make_image(size, size, 4, 3);
+	auto half_buffer = make_image(half, half, 4, 4);
+	auto rgb = make_image(size, size, 3, 5);
+	UprightRect rect;
+	rect.x0 = size / 4;
+	rect.x1 = rect.x0 + half - 1;
+	rect.y0 = size / 4;
+	rect.y1 = rect.y0 + half - 1;
+	Subbuffer src_rect{ src->buf, &rect };
+	Subbuffer dest_rect{ dest->buf, &rect };
+	double area = double(size) * size;
+	double half_area = double(half) * half;
+
+	runner.measure("subbuffer_copy/buffer_to_buffer", area, [&]() { subbuffer_copy(dest->buf, src->buf); });
+	runner.measure("subbuffer_copy/path_to_buffer", half_area, [&]() { subbuffer_copy(half_buffer->buf, src_rect); });
+	runner.measure("subbuffer_copy/buffer_to_path", half_area, [&]() { subbuffer_copy(dest_rect, half_buffer->buf); });
+	runner.measure("subbuffer_copy/path_to_path", half_area, [&]() { subbuffer_copy(dest_rect, src_rect); });
+	runner.measure("subbuffer_copy/unbalanced", area, [&]() { subbuffer_copy_unbalanced(rgb->buf, src->buf); });
+}
+
+static void measure_interpolator(Runner& runner, const char* name, DiscreteInterpolator& interp, IPosition finish)
+{
+	interp.start = { 0, 0 };
+	interp.finish = finish;
+	interp.sync_with_endpoints();
+	runner.measure(name, interp.length, [&]() {
+		interp.sync_with_endpoints();
+		long long sum = 0;
+		int x, y;
+		for (unsigned int i = 0; i < interp.length; ++i)
+		{
+			interp.at(i, x, y);
+			sum += x + y;
+		}
+		sink = sum;
+		});
+}
+
+static void interpolator_suite(Runner& runner)
+{
+	int size = runner.current_size();
+	IPosition corner{ size - 1, size - 1 };
+	DiscreteLineInterpolator line;
+	DiscreteRectOutlineInterpolator rect_outline;
+	DiscreteRectFillInterpolator rect_fill;
+	DiscreteEllipseOutlineInterpolator ellipse_outline;
+	DiscreteEllipseFillInterpolator ellipse_fill;
+	measure_interpolator(runner, "interpolator/line", line, { size - 1, size / 3 });
+	measure_interpolator(runner, "interpolator/rect_outline", rect_outline, corner);
+	measure_interpolator(runner, "interpolator/rect_fill", rect_fill, corner);
+	measure_interpolator(runner, "interpolator/ellipse_outline", ellipse_outline, corner);
+	measure_interpolator(runner, "interpolator/ellipse_fill", ellipse_fill, corner);
+}
+
+static bool same_pixels(const Image& a, const Image& b)
+{
+	return a.buf.bytes() == b.buf.bytes() && memcmp(a.buf.pixels, b.buf.pixels, a.buf.bytes()) == 0;
+}
+
+// The stroke is painted into a PixelMap and into the reference map. Both must leave the same image and record the same colours per pixel.
+// An action built from the PixelMap must then undo back to the original image and redo to the painted one.
+static bool stroke_storage_matches_reference(int size, const std::vector<IPosition>& stroke)
+{
+	auto image = make_image(size, size, 4);
+	auto reference_image = make_image(size, size, 4);
+	auto original = make_image(size, size, 4);
+	StrokeStorage storage = paint_stroke(*image, stroke);
+	ReferenceStrokeStorage reference = paint_stroke<ReferenceStrokeStorage>(*reference_image, stroke);
+	if (storage.size() != reference.size() || !same_pixels(*image, *reference_image))
+		return false;
+	for (const auto& [pos, colors] : reference)
+	{
+		auto iter = storage.find(pos);
+		if (iter == storage.end() || !(iter->second.first == colors.first) || !(iter->second.second == colors.second))
+			return false;
+	}
+	PaintToolAction action(image, stroke_bounds(stroke), std::move(storage));
+	action.backward();
+	if (!same_pixels(*image, *original))
+		return false;
+	action.forward();
+	return same_pixels(*image, *reference_image);
+}
+
+static void paint_suite(Runner& runner)
+{
+	int size = runner.current_size();
+	auto image = make_image(size, size, 4);
+	auto original = make_image(size, size, 4);
+	int check_size = std::min(size, 1024);
+	runner.check("paint/pixel_map_matches_reference", stroke_storage_matches_reference(check_size, make_stroke(check_size))
+		&& stroke_storage_matches_reference(check_size, make_diagonal_stroke(check_size)));
+	std::vector<IPosition> stroke = make_stroke(size);
+	std::vector<IPosition> diagonal_stroke = make_diagonal_stroke(size);
+
+	runner.measure("paint/brush_pencil", (double)stroke.size(), [&]() { sink = paint_stroke(*image, stroke).size(); },
+		[&]() { restore(*image, *original); });
+	runner.measure("paint/diagonal_stroke", (double)diagonal_stroke.size(), [&]() { sink = paint_stroke(*image, diagonal_stroke).size(); },
+		[&]() { restore(*image, *original); });
+
+	restore(*image, *original);
+	auto painted_colors = paint_stroke(*image, stroke);
+	double painted = (double)painted_colors.size();
+	PaintToolAction action(image, stroke_bounds(stroke), std::move(painted_colors));
+	runner.measure("paint/action_forward", painted, [&]() { action.forward(); });
+	runner.measure("paint/action_backward", painted, [&]() { action.backward(); });
+}
+
+static void history_suite(Runner& runner)
+{
+	static const int num_actions = 64;
+	int size = runner.current_size();
+	auto image = make_image(size, size, 4);
+	std::vector<std::shared_ptr<PaintToolAction>> actions;
+	for (int i = 0; i < num_actions; ++i)
+	{
+		std::vector<IPosition> stroke = make_stroke(size, 100 + i);
+		stroke.resize(size);
+		actions.push_back(std::make_shared<PaintToolAction>(image, stroke_bounds(stroke), paint_stroke(*image, stroke)));
+	}
+
+	std::unique_ptr<ActionHistory> history;
+	runner.measure("history/push", num_actions, [&]() {
+		for (const auto& action : actions)
+			history->push(action);
+		}, [&]() { history = std::make_unique<ActionHistory>(size_t(-1)); });
+	runner.measure("history/undo_redo", 2 * num_actions, [&]() {
+		for (int i = 0; i < num_actions; ++i)
+			history->undo();
+		for (int i = 0; i < num_actions; ++i)
+			history->redo();
+		}, [&]() {
+			history = std::make_unique<ActionHistory>(size_t(-1));
+			for (const auto& action : actions)
+				history->push(action);
+		});
+}
+
+// Rounded half up, as PixelRGBA::blend_over() documents: alpha is n / 255 and each colour channel is num / n, with n the composite alpha scaled by 255 * 255.
+static bool blend_over_is_exact(PixelRGBA src, PixelRGBA bkg)
+{
+	PixelRGBA blended = src;
+	blended.blend_over(bkg);
+	unsigned int weight = 255 * src.a;
+	unsigned int bkg_weight = bkg.a * (255 - src.a);
+	unsigned long long n = weight + bkg_weight;
+	if (blended.a != (2 * n + 255) / 510)
+		return false;
+	if (n == 0)
+		return blended.r == src.r && blended.g == src.g && blended.b == src.b;
+	for (int i = 0; i < 3; ++i)
+	{
+		unsigned long long num = (unsigned long long)src[i] * weight + (unsigned long long)bkg[i] * bkg_weight;
+		if (blended[i] != (2 * num + n) / (2 * n))
+			return false;
+	}
+	return true;
+}
+
+// Every (a, bkg.a, c, bkg.c) combination with both alphas in alphas, with r, g and b covering consecutive values of c so that each blend
+// checks three of them.
+static bool blend_over_check(const std::vector<unsigned int>& alphas)
+{
+	std::atomic<size_t> next_alpha = 0;
+	std::atomic<bool> exact = true;
+	auto worker = [&]() {
+		for (size_t ai = next_alpha++; ai < alphas.size() && exact; ai = next_alpha++)
+		{
+			unsigned int a = alphas[ai];
+			for (unsigned int bkg_a : alphas)
+				for (unsigned int c = 0; c < 256; c += 3)
+					for (unsigned int bkg_c = 0; bkg_c < 256; ++bkg_c)
+					{
+						PixelRGBA src{ Byte(c), Byte(std::min(c + 1, 255u)), Byte(std::min(c + 2, 255u)), Byte(a) };
+						if (!blend_over_is_exact(src, PixelRGBA{ Byte(bkg_c), Byte(bkg_c), Byte(bkg_c), Byte(bkg_a) }))
+							exact = false;
+					}
+		}
+		};
+	std::vector<std::thread> threads(std::max(std::thread::hardware_concurrency(), 1u));
+	for (auto& thread : threads)
+		thread = std::thread(worker);
+	for (auto& thread : threads)
+		thread.join();
+	return exact;
+}
+
+static void color_suite(Runner& runner)
+{
+	int size = runner.current_size();
+	size_t area = size_t(size) * size;
+	auto image = make_image(size, size, 4);
+	auto background = make_image(size, size, 4, 6);
+	const Buffer& buf = image->buf;
+	std::vector<float> planes(3 * area);
+
+	runner.measure("color/buffer_to_hsv", (double)area, [&]() { convert_buffer(buf, ColorSpace::HSV, planes.data()); });
+	runner.measure("color/buffer_from_hsv", (double)area, [&]() { convert_buffer(planes.data(), ColorSpace::HSV, buf); },
+		[&]() { convert_buffer(buf, ColorSpace::HSV, planes.data()); });
+	runner.measure("color/buffer_to_hsl", (double)area, [&]() { convert_buffer(buf, ColorSpace::HSL, planes.data()); });
+	runner.measure("color/buffer_from_hsl", (double)area, [&]() { convert_buffer(planes.data(), ColorSpace::HSL, buf); },
+		[&]() { convert_buffer(buf, ColorSpace::HSL, planes.data()); });
+
+	runner.measure("color/scalar_rgb_to_hsv", (double)area, [&]() {
+		float sum = 0.0f;
+		for (size_t i = 0; i < area; ++i)
+		{
+			const Byte* pixel = buf.pixels + 4 * i;
+			sum += RGB(pixel[0], pixel[1], pixel[2]).to_hsv().h;
+		}
+		sink = (long long)sum;
+		});
+	runner.measure("color/oklab_round_trip", (double)area, [&]() {
+		long long sum = 0;
+		for (size_t i = 0; i < area; ++i)
+		{
+			PixelRGBA px;
+			memcpy(&px, buf.pixels + 4 * i, 4);
+			sum += from_oklab(to_oklab(px)).r;
+		}
+		sink = sum;
+		});
+	runner.measure("color/blend_over", (double)area, [&]() {
+		PixelRGBA* bkg = reinterpret_cast<PixelRGBA*>(background->buf.pixels);
+		PixelRGBA* src = reinterpret_cast<PixelRGBA*>(image->buf.pixels);
+		long long sum = 0;
+		for (size_t i = 0; i < area; ++i)
+		{
+			PixelRGBA px = src[i];
+			px.blend_over(bkg[i]);
+			sum += px.a;
+		}
+		sink = sum;
+		});
+
+	// The input space doesn't depend on the size, so it is only swept once. The full sweep takes tens of seconds, so by default only
+	// every 17th alpha is covered, along with the values next to 0, 128 and 255 where rounding is most likely to go wrong.
+	static bool blend_checked = false;
+	const char* blend_check = runner.exhaustive() ? "color/blend_over_exhaustive" : "color/blend_over_sampled";
+	if (!blend_checked && runner.selected(blend_check))
+	{
+		blend_checked = true;
+		std::vector<unsigned int> alphas;
+		for (unsigned int a = 0; a < 256; ++a)
+			if (runner.exhaustive() || a % 17 == 0 || a == 1 || a == 127 || a == 128 || a == 254)
+				alphas.push_back(a);
+		runner.check(blend_check, blend_over_check(alphas));
+	}
+}
+
+// The float comparisons ColorSubscheme sorted with before it packed fixed-point keys. Secondary components that compared the other way
+// round are negated here, and the whole tuple is then compared in the primary direction.
+static std::array<float, 4> reference_sort_tuple(RGBA c, ColorSubscheme::SortingPolicy policy)
+{
+	HSV hsv = c.rgb.to_hsv();
+	HSL hsl = c.rgb.to_hsl();
+	switch (policy)
+	{
+	case ColorSubscheme::SortingPolicy::HUE: return { hsv.h, -hsv.s, -hsv.v, -c.alpha };
+	case ColorSubscheme::SortingPolicy::SAT_HSV: return { hsv.s, hsv.h, -hsv.v, -c.alpha };
+	case ColorSubscheme::SortingPolicy::SAT_HSL: return { hsl.s, hsl.h, -hsl.l, -c.alpha };
+	case ColorSubscheme::SortingPolicy::VALUE: return { -hsv.v, hsv.h, hsv.s, -c.alpha };
+	case ColorSubscheme::SortingPolicy::LIGHT: return { -hsl.l, hsl.h, hsl.s, -c.alpha };
+	case ColorSubscheme::SortingPolicy::RED: return { -c.rgb.r, c.rgb.g, c.rgb.b, -c.alpha };
+	case ColorSubscheme::SortingPolicy::GREEN: return { -c.rgb.g, c.rgb.b, c.rgb.r, -c.alpha };
+	case ColorSubscheme::SortingPolicy::BLUE: return { -c.rgb.b, c.rgb.r, c.rgb.g, -c.alpha };
+	case ColorSubscheme::SortingPolicy::ALPHA: return { -c.alpha, hsv.h, -hsv.s, -hsv.v };
+	default: return {};
+	}
+}
+
+// Random colors, half of them from a coarse grid so that primary and secondary components tie often.
+static std::vector<RGBA> make_scheme_colors(size_t count, unsigned long long seed)
+{
+	Bench::Random random(seed);
+	std::vector<RGBA> colors;
+	colors.reserve(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (i % 2)
+			colors.push_back(RGBA(random.next_int(256), random.next_int(256), random.next_int(256), random.next_int(256)));
+		else
+			colors.push_back(RGBA(random.next_int(5) * 63, random.next_int(5) * 63, random.next_int(5) * 63, random.next_int(3) * 127));
+	}
+	return colors;
+}
+
+static bool key_sort_matches_reference(const std::vector<RGBA>& colors, ColorSubscheme::Sort sort)
+{
+	std::vector<std::pair<std::array<float, 4>, RGBA>> reference;
+	reference.reserve(colors.size());
+	for (RGBA color : colors)
+		reference.push_back({ reference_sort_tuple(color, sort.policy), color });
+	std::stable_sort(reference.begin(), reference.end(), [&](const auto& a, const auto& b) { return sort.topfirst ? a.first > b.first : a.first < b.first; });
+
+	ColorSubscheme scheme("check", colors);
+	scheme.sort(sort);
+	for (size_t i = 0; i < colors.size(); ++i)
+	{
+		if (!(scheme.colors[i] == reference[i].second))
+			return false;
+	}
+	return true;
+}
+
+static void palette_sort_suite(Runner& runner)
+{
+	int size = runner.current_size();
+	std::vector<RGBA> colors = make_scheme_colors(std::min(size, 4096), 9);
+	bool matches = true;
+	for (int policy = (int)ColorSubscheme::SortingPolicy::HUE; policy <= (int)ColorSubscheme::SortingPolicy::ALPHA; ++policy)
+		for (bool topfirst : { false, true })
+			matches = matches && key_sort_matches_reference(colors, { (ColorSubscheme::SortingPolicy)policy, topfirst });
+	runner.check("palette_sort/matches_float_predicates", matches);
+
+	colors = make_scheme_colors(size, 10);
+	runner.measure("palette_sort/hue", (double)size, [&]() {
+		ColorSubscheme scheme("bench", colors);
+		scheme.sort({ ColorSubscheme::SortingPolicy::HUE, true });
+		sink = scheme.colors.size();
+		});
+}
+
+// Each filter's formula applied per pixel and per channel, without lookup tables, tiles or threads.
+static Byte reference_filter_channel(const ColorFilter& filter, Byte value)
+{
+	auto to_byte = [](float v) { return (Byte)std::clamp(roundi(v * 255), 0, 255); };
+	float v = value * inv255;
+	switch (filter.type)
+	{
+	case ColorFilter::Type::BRIGHTNESS_CONTRAST:
+	{
+		float contrast = std::clamp(filter.contrast, -1.0f, 0.99f);
+		return to_byte((v - 0.5f) * ((1.0f + contrast) / (1.0f - contrast)) + 0.5f + filter.brightness);
+	}
+	case ColorFilter::Type::LEVELS:
+	{
+		float t = std::pow(std::clamp((value - filter.in_black) / float(std::max(filter.in_white - filter.in_black, 1)), 0.0f, 1.0f), 1.0f / std::max(filter.gamma, 0.01f));
+		return (Byte)std::clamp(roundi(filter.out_black + t * (filter.out_white - filter.out_black)), 0, 255);
+	}
+	case ColorFilter::Type::CURVES:
+	{
+		const std::vector<glm::ivec2>& curve = filter.curve;
+		if (value <= curve.front().x)
+			return (Byte)std::clamp(curve.front().y, 0, 255);
+		size_t i = 1;
+		while (i < curve.size() && value > curve[i].x)
+			++i;
+		if (i == curve.size())
+			return (Byte)std::clamp(curve.back().y, 0, 255);
+		glm::ivec2 a = curve[i - 1], b = curve[i];
+		float t = b.x != a.x ? float(value - a.x) / (b.x - a.x) : 1.0f;
+		return (Byte)std::clamp(roundi(a.y + t * (b.y - a.y)), 0, 255);
+	}
+	case ColorFilter::Type::INVERT:
+		return Byte(255 - value);
+	case ColorFilter::Type::POSTERIZE:
+	{
+		float levels = float(std::max(filter.posterize_levels, 2) - 1);
+		return to_byte(roundf(v * levels) / levels);
+	}
+	default:
+		return value;
+	}
+}
+
+// The pixel at (x, y) of src filtered through the scalar colour conversions. Missing colour channels read as 255, and alpha is copied.
+static PixelRGBA reference_filter_pixel(const ColorFilter& filter, const Buffer& src, int x, int y)
+{
+	const Byte* p = src.pos(x, y);
+	PixelRGBA out{ 0, 0, 0, 0 };
+	if (filter.type == ColorFilter::Type::HSL_SHIFT)
+	{
+		HSL hsl = RGB(p[0], src.chpp > 1 ? p[1] : 255, src.chpp > 2 ? p[2] : 255).to_hsl();
+		float h = hsl.h + filter.hue_shift;
+		h -= std::floor(h);
+		auto shift = [](float value, float shift) { return shift >= 0.0f ? value + shift * (1.0f - value) : value + shift * value; };
+		RGB rgb = HSL(h, shift(hsl.s, filter.saturation_shift), shift(hsl.l, filter.lightness_shift)).to_rgb();
+		out = { Byte(rgb.get_pixel_r()), Byte(rgb.get_pixel_g()), Byte(rgb.get_pixel_b()), 0 };
+	}
+	else
+	{
+		for (CHPP c = 0; c < std::min(src.chpp, 3); ++c)
+			out.at(c) = reference_filter_channel(filter, p[c]);
+	}
+	if (src.chpp > 3)
+		out.a = p[3];
+	return out;
+}
+
+// Every pixel of dst against the reference for the pixel its value was taken from: itself, or the corner of its step x step block.
+// The planar HSL conversions only agree with the scalar ones to within float rounding, so HSL results may be one off.
+static bool filter_matches_reference(const ColorFilter& filter, const Buffer& src, const Buffer& dst, int step)
+{
+	int tolerance = filter.type == ColorFilter::Type::HSL_SHIFT ? 1 : 0;
+	for (int y = 0; y < src.height; ++y)
+	{
+		for (int x = 0; x < src.width; ++x)
+		{
+			PixelRGBA expected = reference_filter_pixel(filter, src, x / step * step, y / step * step);
+			const Byte* q = dst.pos(x, y);
+			for (CHPP c = 0; c < src.chpp; ++c)
+			{
+				if (std::abs(q[c] - expected[c]) > (c < 3 ? tolerance : 0))
+					return false;
+			}
+		}
+	}
+	return true;
+}
+
+static std::vector<ColorFilter> make_check_filters()
+{
+	std::vector<ColorFilter> filters(6);
+	filters[0].type = ColorFilter::Type::HSL_SHIFT;
+	filters[0].hue_shift = 0.3f;
+	filters[0].saturation_shift = 0.4f;
+	filters[0].lightness_shift = -0.2f;
+	filters[1].type = ColorFilter::Type::BRIGHTNESS_CONTRAST;
+	filters[1].brightness = 0.1f;
+	filters[1].contrast = 0.5f;
+	filters[2].type = ColorFilter::Type::LEVELS;
+	filters[2].in_black = 20;
+	filters[2].in_white = 230;
+	filters[2].gamma = 1.7f;
+	filters[2].out_black = 10;
+	filters[2].out_white = 240;
+	filters[3].type = ColorFilter::Type::CURVES;
+	filters[3].curve = { { 0, 30 }, { 64, 40 }, { 128, 150 }, { 192, 230 }, { 250, 255 } };
+	filters[4].type = ColorFilter::Type::INVERT;
+	filters[5].type = ColorFilter::Type::POSTERIZE;
+	filters[5].posterize_levels = 5;
+	return filters;
+}
+
+static void filter_suite(Runner& runner)
+{
+	int size = runner.current_size();
+	// Sides that aren't multiples of the tile size, so that the partial tiles at the edges are covered.
+	int check_width = std::min(size, 512) + 13, check_height = std::min(size, 512) + 7;
+	static const int reduced_step = 4; // Easel's step for previews while a slider is dragged
+	bool matches = true;
+	for (const ColorFilter& filter : make_check_filters())
+	{
+		for (CHPP chpp : { CHPP(4), CHPP(3), CHPP(1) })
+		{
+			auto src = make_image(check_width, check_height, chpp);
+			auto dst = make_image(check_width, check_height, chpp, 12);
+			apply_color_filter(filter, src->buf, dst->buf);
+			matches = matches && filter_matches_reference(filter, src->buf, dst->buf, 1);
+			glm::ivec2 grid = color_filter_tile_grid(src->buf);
+			std::vector<int> tiles(grid.x * grid.y);
+			for (int i = 0; i < (int)tiles.size(); ++i)
+				tiles[i] = i;
+			apply_color_filter(filter, src->buf, dst->buf, tiles, reduced_step);
+			matches = matches && filter_matches_reference(filter, src->buf, dst->buf, reduced_step);
+			// In place, as previews of the canvas image are committed.
+			apply_color_filter(filter, src->buf, src->buf);
+			matches = matches && filter_matches_reference(filter, make_image(check_width, check_height, chpp)->buf, src->buf, 1);
+		}
+	}
+	runner.check("filter/matches_reference", matches);
+
+	auto image = make_image(size, size, 4);
+	auto filtered = make_image(size, size, 4);
+	double area = double(size) * size;
+	std::vector<ColorFilter> filters = make_check_filters();
+	runner.measure("filter/hsl_shift", area, [&]() { apply_color_filter(filters[0], image->buf, filtered->buf); });
+	runner.measure("filter/levels", area, [&]() { apply_color_filter(filters[2], image->buf, filtered->buf); });
+}
+
+static unsigned int pack_color(PixelRGBA color)
+{
+	return (unsigned int)color.r << 24 | (unsigned int)color.g << 16 | (unsigned int)color.b << 8 | color.a;
+}
+
+static std::vector<std::pair<unsigned int, unsigned int>> sorted_histogram(const std::vector<ColorCount>& histogram)
+{
+	std::vector<std::pair<unsigned int, unsigned int>> sorted;
+	sorted.reserve(histogram.size());
+	for (const ColorCount& entry : histogram)
+		sorted.push_back({ pack_color(entry.color), entry.count });
+	std::sort(sorted.begin(), sorted.end());
+	return sorted;
+}
+
+static bool histogram_matches_reference(const Buffer& buf)
+{
+	std::map<unsigned int, unsigned int> reference;
+	for (Dim i = 0; i < buf.area(); ++i)
+	{
+		PixelRGBA color{ 255, 255, 255, 255 };
+		for (CHPP c = 0; c < buf.chpp; ++c)
+			color.at(c) = buf.pixels[i * buf.chpp + c];
+		++reference[pack_color(color)];
+	}
+	return sorted_histogram(color_histogram(buf)) == std::vector<std::pair<unsigned int, unsigned int>>(reference.begin(), reference.end());
+}
+
+// Uniformly random pixels, so that nearly every pixel of a large image has its own colour.
+static std::shared_ptr<Image> make_noise_image(int width, int height, unsigned long long seed = 8)
+{
+	Bench::Random random(seed);
+	auto image = std::make_shared<Image>();
+	image->buf.width = width;
+	image->buf.height = height;
+	image->buf.chpp = 4;
+	image->buf.pxnew();
+	unsigned int* pixels = reinterpret_cast<unsigned int*>(image->buf.pixels);
+	for (Dim i = 0; i < image->buf.area(); ++i)
+		pixels[i] = random.next();
+	return image;
+}
+
+static void histogram_suite(Runner& runner)
+{
+	int size = runner.current_size();
+	int check_size = std::min(size, 1024);
+	bool matches = true;
+	for (CHPP chpp : { CHPP(4), CHPP(3), CHPP(1) })
+		matches = matches && histogram_matches_reference(make_image(check_size, check_size, chpp)->buf);
+	matches = matches && histogram_matches_reference(make_noise_image(check_size, check_size)->buf);
+	runner.check("histogram/matches_reference", matches);
+
+	double area = double(size) * size;
+	auto image = make_image(size, size, 4);
+	auto noise = make_noise_image(size, size);
+	runner.measure("histogram/gradient", area, [&]() { sink = color_histogram(image->buf).size(); });
+	runner.measure("histogram/noise", area, [&]() { sink = color_histogram(noise->buf).size(); });
+	runner.measure("histogram/extract_palette_256", area, [&]() {
+		std::vector<ColorCount> histogram = color_histogram(image->buf);
+		keep_most_frequent_colors(histogram, 256);
+		sink = histogram.size();
+		});
+}
+
+// The linear scan PaletteLookup replaces: squared Oklab distance, with ties going to the lowest index.
+static size_t brute_force_nearest(const std::vector<Oklab>& labs, Oklab lab)
+{
+	size_t k = 0;
+	float best = FLT_MAX;
+	for (size_t i = 0; i < labs.size(); ++i)
+	{
+		float dl = lab.L - labs[i].L, da = lab.a - labs[i].a, db = lab.b - labs[i].b;
+		float d = dl * dl + da * da + db * db;
+		if (d < best)
+		{
+			best = d;
+			k = i;
+		}
+	}
+	return k;
+}
+
+// Like the quantizer, channels missing from buffers with chpp < 3 read as 255.
+static PixelRGBA pixel_at_index(const Buffer& buf, Dim i)
+{
+	PixelRGBA color{ 255, 255, 255, 255 };
+	for (CHPP c = 0; c < buf.chpp; ++c)
+		color.at(c) = buf.pixels[i * buf.chpp + c];
+	return color;
+}
+
+static std::shared_ptr<Image> copy_image(const Image& original)
+{
+	auto image = std::make_shared<Image>();
+	image->buf.width = original.buf.width;
+	image->buf.height = original.buf.height;
+	image->buf.chpp = original.buf.chpp;
+	image->buf.pxnew();
+	restore(*image, original);
+	return image;
+}
+
+// The palette must be opaque, ordered by lightness and no larger than asked. Undithered remapping must pick what the brute force scan picks,
+// and dithered remapping must stay in range. Applying the indices must write the palette colours and leave alpha alone, and snapping must do both steps at once.
+static bool quantize_matches_reference(const Image& image, QuantizeOptions::Method method)
+{
+	const Buffer& buf = image.buf;
+	QuantizeOptions options;
+	options.method = method;
+	std::vector<PixelRGBA> palette = quantize_palette(buf, options);
+	if (palette.empty() || palette.size() > (size_t)options.num_colors)
+		return false;
+	std::vector<Oklab> labs;
+	for (size_t i = 0; i < palette.size(); ++i)
+	{
+		labs.push_back(to_oklab(palette[i]));
+		if (palette[i].a != 255 || (i > 0 && labs[i].L < labs[i - 1].L))
+			return false;
+	}
+
+	PaletteLookup lookup(palette);
+	std::vector<Byte> indices = remap_to_palette(buf, lookup, QuantizeOptions::Dither::NONE);
+	if (indices.size() != (size_t)buf.area())
+		return false;
+	for (Dim i = 0; i < buf.area(); ++i)
+	{
+		if (indices[i] != brute_force_nearest(labs, to_oklab(pixel_at_index(buf, i))))
+			return false;
+	}
+	for (QuantizeOptions::Dither dither : { QuantizeOptions::Dither::ORDERED, QuantizeOptions::Dither::FLOYD_STEINBERG })
+	{
+		std::vector<Byte> dithered = remap_to_palette(buf, lookup, dither);
+		if (dithered.size() != (size_t)buf.area() || std::any_of(dithered.begin(), dithered.end(), [&](Byte index) { return index >= palette.size(); }))
+			return false;
+	}
+
+	auto applied = copy_image(image);
+	apply_palette_indices(applied->buf, palette, indices);
+	for (Dim i = 0; i < buf.area(); ++i)
+	{
+		for (CHPP c = 0; c < buf.chpp; ++c)
+		{
+			Byte expected = c < 3 ? palette[indices[i]].at(c) : buf.pixels[i * buf.chpp + c];
+			if (applied->buf.pixels[i * buf.chpp + c] != expected)
+				return false;
+		}
+	}
+	auto snapped = copy_image(image);
+	snap_to_palette(snapped->buf, lookup, QuantizeOptions::Dither::NONE);
+	return same_pixels(*snapped, *applied);
+}
+
+// Pixels drawn from colors, some of them half transparent and some fully transparent with unrelated colours. Every method must give back
+// exactly the distinct colours, and a fully transparent image must give back an empty palette.
+static bool quantize_keeps_few_colors(int size, const std::vector<PixelRGBA>& colors)
+{
+	Bench::Random random(14);
+	auto image = make_image(size, size, 4);
+	for (Dim i = 0; i < image->buf.area(); ++i)
+	{
+		PixelRGBA color = colors[random.next_int((int)colors.size())];
+		unsigned int roll = random.next_int(8);
+		color.a = roll == 0 ? 0 : roll == 1 ? 128 : 255;
+		if (color.a == 0)
+			color.r ^= 0x55;
+		for (CHPP c = 0; c < 4; ++c)
+			image->buf.pixels[i * 4 + c] = color.at(c);
+	}
+	std::set<unsigned int> expected;
+	for (PixelRGBA color : colors)
+		expected.insert(pack_color({ color.r, color.g, color.b, 255 }));
+	QuantizeOptions options;
+	for (QuantizeOptions::Method method : { QuantizeOptions::Method::MEDIAN_CUT, QuantizeOptions::Method::OCTREE, QuantizeOptions::Method::K_MEANS })
+	{
+		options.method = method;
+		std::vector<PixelRGBA> palette = quantize_palette(image->buf, options);
+		std::set<unsigned int> got;
+		for (PixelRGBA color : palette)
+			got.insert(pack_color(color));
+		if (palette.size() != expected.size() || got != expected)
+			return false;
+	}
+	for (Dim i = 0; i < image->buf.area(); ++i)
+		image->buf.pixels[i * 4 + 3] = 0;
+	for (QuantizeOptions::Method method : { QuantizeOptions::Method::MEDIAN_CUT, QuantizeOptions::Method::OCTREE, QuantizeOptions::Method::K_MEANS })
+	{
+		options.method = method;
+		if (!quantize_palette(image->buf, options).empty())
+			return false;
+	}
+	return true;
+}
+
+static void quantize_suite(Runner& runner)
+{
+	int size = runner.current_size();
+	int check_size = std::min(size, 256);
+	bool matches = true;
+	for (CHPP chpp : { CHPP(4), CHPP(3), CHPP(1) })
+	{
+		auto check_image = make_image(check_size, check_size, chpp);
+		for (QuantizeOptions::Method method : { QuantizeOptions::Method::MEDIAN_CUT, QuantizeOptions::Method::OCTREE, QuantizeOptions::Method::K_MEANS })
+			matches = matches && quantize_matches_reference(*check_image, method);
+	}
+	Bench::Random random(13);
+	std::vector<PixelRGBA> few_colors(12);
+	for (PixelRGBA& color : few_colors)
+		color = { Byte(random.next()), Byte(random.next()), Byte(random.next()), 255 };
+	matches = matches && quantize_keeps_few_colors(check_size, few_colors);
+	runner.check("quantize/matches_reference", matches);
+
+	auto image = make_image(size, size, 4);
+	double area = double(size) * size;
+
+	QuantizeOptions options;
+	options.method = QuantizeOptions::Method::MEDIAN_CUT;
+	runner.measure("quantize/median_cut_16", area, [&]() { sink = quantize_palette(image->buf, options).size(); });
+	options.method = QuantizeOptions::Method::OCTREE;
+	runner.measure("quantize/octree_16", area, [&]() { sink = quantize_palette(image->buf, options).size(); });
+	options.method = QuantizeOptions::Method::K_MEANS;
+	runner.measure("quantize/k_means_16", area, [&]() { sink = quantize_palette(image->buf, options).size(); });
+	options.num_colors = MAX_QUANTIZED_COLORS;
+	std::vector<PixelRGBA> palette = quantize_palette(image->buf, options);
+	runner.measure("quantize/k_means_256", area, [&]() { sink = quantize_palette(image->buf, options).size(); });
+
+	PaletteLookup lookup(palette);
+	runner.measure("quantize/remap_none", area, [&]() { sink = remap_to_palette(image->buf, lookup, QuantizeOptions::Dither::NONE).size(); });
+	runner.measure("quantize/remap_ordered", area, [&]() { sink = remap_to_palette(image->buf, lookup, QuantizeOptions::Dither::ORDERED).size(); });
+	runner.measure("quantize/remap_floyd_steinberg", area, [&]() { sink = remap_to_palette(image->buf, lookup, QuantizeOptions::Dither::FLOYD_STEINBERG).size(); });
+}
+
+// Every query kind against the brute force scan, over a lattice through the RGB cube that includes both of its ends.
+static bool palette_lookup_matches_brute_force(const std::vector<PixelRGBA>& palette)
+{
+	PaletteLookup lookup(palette);
+	std::vector<Oklab> labs;
+	for (PixelRGBA color : palette)
+		labs.push_back(to_oklab(color));
+	std::vector<Byte> pixels;
+	for (int r = 0; r < 256; r += 15)
+		for (int g = 0; g < 256; g += 5)
+			for (int b = 0; b < 256; b += 3)
+				pixels.insert(pixels.end(), { Byte(r), Byte(g), Byte(b), 255 });
+	size_t n = pixels.size() / 4;
+	std::vector<unsigned short> indices(n);
+	lookup.nearest(pixels.data(), 4, indices.data(), n);
+	for (size_t i = 0; i < n; ++i)
+	{
+		PixelRGBA color{ pixels[4 * i], pixels[4 * i + 1], pixels[4 * i + 2], 255 };
+		Oklab lab = to_oklab(color);
+		size_t expected = brute_force_nearest(labs, lab);
+		if (lookup.nearest(color) != expected || indices[i] != expected || lookup.nearest(lab) != expected)
+			return false;
+	}
+	return true;
+}
+
+static void palette_lookup_suite(Runner& runner)
+{
+	Bench::Random random(11);
+	auto random_palette = [&](size_t count) {
+		std::vector<PixelRGBA> palette(count);
+		for (PixelRGBA& color : palette)
+			color = { Byte(random.next()), Byte(random.next()), Byte(random.next()), 255 };
+		return palette;
+		};
+	bool matches = true;
+	for (size_t count : { 1, 2, 16, 256 })
+		matches = matches && palette_lookup_matches_brute_force(random_palette(count));
+	// Repeated colours tie exactly, so the lookup has to settle them by index.
+	std::vector<PixelRGBA> repeated = random_palette(8);
+	repeated.insert(repeated.end(), repeated.rbegin(), repeated.rend());
+	matches = matches && palette_lookup_matches_brute_force(repeated);
+	runner.check("palette_lookup/matches_brute_force", matches);
+
+	int size = runner.current_size();
+	auto image = make_image(size, size, 4);
+	PaletteLookup lookup(random_palette(256));
+	std::vector<Byte> indices(size_t(size) * size);
+	runner.measure("palette_lookup/nearest_256", double(size) * size, [&]() { lookup.nearest(image->buf.pixels, 4, indices.data(), indices.size()); });
+}
+
+static void png_suite(Runner& runner)
+{
+	int size = runner.current_size();
+	auto image = make_image(size, size, 4);
+	FilePath filepath = (std::filesystem::temp_directory_path() / "quasar_bench.png").string();
+	runner.measure("png/save", double(size) * size, [&]() { sink = image->write_to_file(filepath, ImageFormat::PNG); });
+	if (!image->write_to_file(filepath, ImageFormat::PNG))
+		return;
+	runner.measure("png/load", double(size) * size, [&]() { Image loaded(filepath, false); sink = loaded.buf.width; });
+	std::error_code ec;
+	std::filesystem::remove(filepath.c_str(), ec);
+}
+
+// Edits a series of rects of the base, updating the pyramid after each, and compares every level with a pyramid built from scratch.
+// The rects sit at odd offsets, at the far edges and partly outside the base, whose odd sides leave rows and columns that the levels drop.
+static bool mip_update_matches_rebuild(int width, int height, CHPP chpp)
+{
+	auto image = make_image(width, height, chpp);
+	MipPyramid mips, rebuilt;
+	mips.build(image->buf, 10);
+	std::vector<IntRect> level_rects;
+	const IntRect rects[] = {
+		{ width / 3, height / 3, 32, 32 },
+		{ 1, 3, 5, 1 },
+		{ width - 7, height - 5, 7, 5 },
+		{ width - 1, 0, 1, height },
+		{ -10, height / 2, 21, 40 },
+		{ width / 2, height - 3, width, 9 },
+		{ 0, 0, width, height }
+	};
+	Bench::Random random(15);
+	IntRect bounds{ 0, 0, width, height };
+	for (IntRect rect : rects)
+	{
+		IntRect clipped;
+		if (!bounds.intersect(rect, clipped))
+			return false;
+		for (Dim y = clipped.y; y < clipped.y + clipped.h; ++y)
+			for (Dim x = clipped.x; x < clipped.x + clipped.w; ++x)
+				for (CHPP c = 0; c < chpp; ++c)
+					image->buf.pos(x, y)[c] = Byte(random.next());
+		mips.update(image->buf, rect, level_rects);
+		if (level_rects.empty() || level_rects[0] != clipped)
+			return false;
+		rebuilt.build(image->buf, 10);
+		if (mips.num_levels() != rebuilt.num_levels())
+			return false;
+		for (int k = 1; k < mips.num_levels(); ++k)
+		{
+			const Buffer& level = mips.level(image->buf, k);
+			const Buffer& expected = rebuilt.level(image->buf, k);
+			if (level.width != (width >> k) || level.height != (height >> k) || memcmp(level.pixels, expected.pixels, expected.bytes()) != 0)
+				return false;
+		}
+	}
+	return true;
+}
+
+static void mips_suite(Runner& runner)
+{
+	int size = runner.current_size();
+	int check_size = std::min(size, 512);
+	bool matches = true;
+	for (CHPP chpp : { CHPP(4), CHPP(3), CHPP(2), CHPP(1) })
+		matches = matches && mip_update_matches_rebuild(check_size + 13, check_size + 7, chpp);
+	runner.check("mips/update_matches_rebuild", matches);
+
+	auto image = make_image(size, size, 4);
+	MipPyramid mips;
+	std::vector<IntRect> level_rects;
+	int dab = std::min(size, 32);
+	runner.measure("mips/build", double(size) * size, [&]() { mips.build(image->buf, 10); });
+	runner.measure("mips/update_dab", double(dab) * dab, [&]() { mips.update(image->buf, { size / 3, size / 3, dab, dab }, level_rects); });
+}
+
+// size lines of prose, with a few codepoints outside the font's common buffer so that the glyph cache is exercised.
+static UTF::String make_text(int size)
+{
+	static const char8_t* const sentences[] = {
+		u8"The quick brown fox jumps over the lazy dog.\t",
+		u8"Pack my box with five dozen liquor jugs, \u00e9t\u00e9 \u00e0 l'\u00e9cole. ",
+		u8"Sphinx of black quartz, judge my vow!\n",
+		u8"How vexingly quick daft zebras jump; 0123456789 \u00fc\u00f1\u00ee\u00e7\u00f8d\u00e9.\r\n",
+	};
+	std::u8string text;
+	for (int i = 0; i < size; ++i)
+		text += sentences[i % std::size(sentences)];
+	return text;
+}
+
+static void text_suite(Runner& runner)
+{
+	FilePath font_path = FileSystem::font_path("Merriweather-Regular.ttf");
+	if (!std::filesystem::exists(font_path.c_str()))
+		return;
+	static Font font(font_path, 24.0f); // rasterizes the common buffer once, without a GL context
+	UTF::String text = make_text(runner.current_size());
+	TextLayout layout(&font);
+	layout.format.horizontal_align = TextLayout::HorizontalAlign::JUSTIFY;
+	std::vector<GLfloat> varr;
+	layout.build_layout(text);
+	double glyphs = (double)layout.num_printable_glyphs();
+	runner.measure("text/build_layout", glyphs, [&]() { layout.build_layout(text); });
+	runner.measure("text/generate_vertices", glyphs, [&]() { layout.generate_vertices(text, {}, 16, varr); });
+}
+
+// Random codepoints in ASCII runs of 0 to 47 characters, each followed by one 2-, 3- or 4-byte codepoint. Surrogates are skipped.
+static std::u32string make_codepoints(size_t length, bool ascii_only, unsigned long long seed = 3)
+{
+	Bench::Random random(seed);
+	std::u32string codepoints;
+	codepoints.reserve(length);
+	while (codepoints.size() < length)
+	{
+		int run = ascii_only ? int(length - codepoints.size()) : random.next_int(48);
+		for (int i = 0; i < run && codepoints.size() < length; ++i)
+			codepoints.push_back(char32_t(0x20 + random.next_int(0x5F)));
+		if (ascii_only || codepoints.size() == length)
+			continue;
+		int width = random.next_int(3);
+		if (width == 0)
+			codepoints.push_back(char32_t(0x80 + random.next_int(0x780)));
+		else if (width == 1)
+		{
+			char32_t codepoint = char32_t(0x800 + random.next_int(0xF800));
+			codepoints.push_back(codepoint >= 0xD800 && codepoint <= 0xDFFF ? codepoint + 0x800 : codepoint);
+		}
+		else
+			codepoints.push_back(char32_t(0x10000 + random.next_int(0x100000)));
+	}
+	return codepoints;
+}
+
+// Scalar references for the SSE2/AVX2 ASCII paths in UTF.cpp: String::push_back() and String::Iterator::advance() handle one codepoint at a time.
+static std::u8string scalar_encode(const std::u32string& codepoints)
+{
+	UTF::String str;
+	str.encoding().reserve(codepoints.size());
+	for (char32_t codepoint : codepoints)
+		str.push_back(int(codepoint));
+	return std::move(str.encoding());
+}
+
+static std::u32string scalar_decode_utf32(const std::u8string& utf8)
+{
+	std::u32string codepoints;
+	UTF::String::Iterator iter(utf8, 0);
+	while (iter)
+		codepoints.push_back(char32_t(iter.advance()));
+	return codepoints;
+}
+
+static std::u16string scalar_utf16(const std::u32string& codepoints)
+{
+	std::u16string utf16;
+	for (char32_t codepoint : codepoints)
+	{
+		if (codepoint < 0x10000)
+			utf16.push_back(char16_t(codepoint));
+		else
+		{
+			utf16.push_back(char16_t(0xD800 + ((codepoint - 0x10000) >> 10)));
+			utf16.push_back(char16_t(0xDC00 + ((codepoint - 0x10000) & 0x3FF)));
+		}
+	}
+	return utf16;
+}
+
+static void utf_suite(Runner& runner)
+{
+	size_t length = size_t(runner.current_size()) * 64;
+
+	// Every start offset within a 32-byte block, so that the vector loops meet ASCII runs at every alignment and every tail length.
+	std::u32string mixed_check = make_codepoints(std::min(length, size_t(1) << 14), false, 4);
+	bool matches = true;
+	for (size_t offset = 0; offset < 32 && matches; ++offset)
+	{
+		std::u32string codepoints = mixed_check.substr(offset);
+		std::u8string utf8 = scalar_encode(codepoints);
+		std::u16string utf16 = scalar_utf16(codepoints);
+		matches = UTF::encode(codepoints) == utf8 && UTF::encode(utf16) == utf8 && UTF::decode_utf32(utf8) == codepoints && UTF::decode_utf16(utf8) == utf16
+			&& scalar_decode_utf32(utf8) == codepoints;
+	}
+	runner.check("utf/simd_matches_scalar", matches);
+
+	std::u32string ascii = make_codepoints(length, true);
+	std::u8string ascii_utf8 = scalar_encode(ascii);
+	std::u16string ascii_utf16 = scalar_utf16(ascii);
+	double bytes = (double)ascii_utf8.size();
+	runner.measure("utf/decode_utf32_ascii", bytes, [&]() { sink = UTF::decode_utf32(ascii_utf8).size(); });
+	runner.measure("utf/decode_utf16_ascii", bytes, [&]() { sink = UTF::decode_utf16(ascii_utf8).size(); });
+	runner.measure("utf/encode_utf32_ascii", bytes, [&]() { sink = UTF::encode(ascii).size(); });
+	runner.measure("utf/encode_utf16_ascii", bytes, [&]() { sink = UTF::encode(ascii_utf16).size(); });
+	runner.measure("utf/scalar_decode_ascii", bytes, [&]() { sink = scalar_decode_utf32(ascii_utf8).size(); });
+	runner.measure("utf/scalar_encode_ascii", bytes, [&]() { sink = scalar_encode(ascii).size(); });
+
+	std::u32string mixed = make_codepoints(length, false);
+	std::u8string mixed_utf8 = scalar_encode(mixed);
+	bytes = (double)mixed_utf8.size();
+	runner.measure("utf/decode_utf32_mixed", bytes, [&]() { sink = UTF::decode_utf32(mixed_utf8).size(); });
+	runner.measure("utf/encode_utf32_mixed", bytes, [&]() { sink = UTF::encode(mixed).size(); });
+	runner.measure("utf/scalar_decode_mixed", bytes, [&]() { sink = scalar_decode_utf32(mixed_utf8).size(); });
+}
+
+// Only the addresses of shaders matter to SpriteBatchQueue, so these stand in for real ones without a GL context.
+static const Shader* fake_shader(int i)
+{
+	static const char shaders[4] = {};
+	return reinterpret_cast<const Shader*>(shaders + i);
+}
+
+static unsigned short fake_stride(int shader) { return static_cast<unsigned short>(4 + shader); }
+
+// num_quads quads over 4 layers, 3 shaders and 6 textures in 3 slots. The first two floats of every vertex hold the quad's index and layer.
+static void push_sprite_quads(SpriteBatchQueue& queue, size_t num_quads, std::vector<SpriteBatchQueue::Quad>& pushed)
+{
+	Bench::Random random(7);
+	GLfloat vertices[4 * 8] = {};
+	for (size_t i = 0; i < num_quads; ++i)
+	{
+		SpriteBatchQueue::Quad quad;
+		quad.layer = random.next_int(4);
+		int shader = random.next_int(3);
+		quad.shader = fake_shader(shader);
+		quad.stride = fake_stride(shader);
+		quad.num_textures = (unsigned char)random.next_int(3);
+		for (unsigned char t = 0; t < quad.num_textures; ++t)
+			quad.textures[t] = { GLuint(t + random.next_int(2)), GLuint(1 + random.next_int(6)) };
+		if (quad.num_textures == 2 && quad.textures[0].slot == quad.textures[1].slot)
+			quad.num_textures = 1;
+		for (int v = 0; v < 4; ++v)
+		{
+			vertices[v * quad.stride] = GLfloat(i);
+			vertices[v * quad.stride + 1] = GLfloat(quad.layer);
+			for (unsigned short f = 2; f < quad.stride; ++f)
+				vertices[v * quad.stride + f] = GLfloat(v * 16 + f);
+		}
+		if (quad.num_textures == 0)
+			queue.push(quad.layer, quad.shader, quad.stride, vertices);
+		else if (quad.num_textures == 1)
+			queue.push(quad.layer, quad.shader, quad.stride, vertices, { quad.textures[0] });
+		else
+			queue.push(quad.layer, quad.shader, quad.stride, vertices, { quad.textures[0], quad.textures[1] });
+		pushed.push_back(quad);
+	}
+}
+
+// Every quad is drawn exactly once with its vertices intact, layers never go down, and each draw uses one shader and binds at most one
+// texture per slot, including every binding its quads were pushed with.
+static bool sprite_draws_are_valid(const SpriteBatchQueue& queue, const std::vector<SpriteBatchQueue::Quad>& pushed)
+{
+	const std::vector<GLfloat>& packed = queue.packed_vertices();
+	std::vector<bool> drawn(pushed.size(), false);
+	int layer = INT_MIN;
+	size_t offset = 0;
+	for (const SpriteBatchQueue::Draw& draw : queue.get_draws())
+	{
+		if (draw.vertices_offset != offset || draw.num_quads == 0)
+			return false;
+		for (size_t i = 0; i < draw.textures.size(); ++i)
+			for (size_t j = i + 1; j < draw.textures.size(); ++j)
+				if (draw.textures[i].slot == draw.textures[j].slot)
+					return false;
+		for (size_t q = 0; q < draw.num_quads; ++q)
+		{
+			const GLfloat* vertices = packed.data() + offset;
+			size_t index = size_t(vertices[0]);
+			if (index >= pushed.size() || drawn[index])
+				return false;
+			drawn[index] = true;
+			const SpriteBatchQueue::Quad& quad = pushed[index];
+			if (quad.shader != draw.shader || quad.stride != draw.stride || quad.layer < layer)
+				return false;
+			layer = quad.layer;
+			for (int v = 0; v < 4; ++v)
+			{
+				if (vertices[v * quad.stride] != GLfloat(index) || vertices[v * quad.stride + 1] != GLfloat(quad.layer))
+					return false;
+				for (unsigned short f = 2; f < quad.stride; ++f)
+					if (vertices[v * quad.stride + f] != GLfloat(v * 16 + f))
+						return false;
+			}
+			for (unsigned char t = 0; t < quad.num_textures; ++t)
+				if (std::find(draw.textures.begin(), draw.textures.end(), quad.textures[t]) == draw.textures.end())
+					return false;
+			offset += 4 * size_t(quad.stride);
+		}
+	}
+	return offset == packed.size() && std::find(drawn.begin(), drawn.end(), false) == drawn.end();
+}
+
+static void sprite_batch_suite(Runner& runner)
+{
+	size_t num_quads = size_t(runner.current_size()) * 4;
+	SpriteBatchQueue queue;
+	std::vector<SpriteBatchQueue::Quad> pushed;
+	push_sprite_quads(queue, num_quads, pushed);
+	queue.build();
+	runner.check("sprite_batch/draws_valid", sprite_draws_are_valid(queue, pushed));
+
+	// Easel's canvas: checkerboard, image and brush preview through flatsprite.frag in texture slots 0 to 2, then the cursor on top.
+	SpriteBatchQueue canvas;
+	GLfloat vertices[4 * 8] = {};
+	canvas.push(0, fake_shader(0), fake_stride(0), vertices, { { 0, 1 } });
+	canvas.push(0, fake_shader(0), fake_stride(0), vertices, { { 1, 2 } });
+	canvas.push(0, fake_shader(0), fake_stride(0), vertices, { { 2, 3 } });
+	canvas.push(1, fake_shader(1), fake_stride(1), vertices);
+	canvas.build();
+	runner.check("sprite_batch/canvas_draws", canvas.get_draws().size() == 2 && canvas.get_draws()[0].num_quads == 3);
+
+	runner.measure("sprite_batch/push_build", (double)num_quads, [&]() {
+		pushed.clear();
+		push_sprite_quads(queue, num_quads, pushed);
+		queue.build();
+		sink = queue.get_draws().size();
+		}, [&]() { queue.clear(); });
+}
+
+static void reset_gl_state()
+{
+	GLS.invalidate();
+	GLS.counters = {};
+}
+
+static bool gl_counters_are(unsigned long long issued, unsigned long long elided)
+{
+	return GLS.counters.issued == issued && GLS.counters.elided == elided;
+}
+
+// Runs against the headless GLStateCache, so the counters show exactly which binds would have reached GL.
+static void gl_state_suite(Runner& runner)
+{
+	reset_gl_state();
+	bind_texture(7, 0); // unit and texture
+	bind_texture(7, 0);
+	bind_texture(8, 1); // unit and texture
+	bind_texture(7, 0); // unit only
+	delete_texture(7);
+	bind_texture(7, 0); // a new texture may reuse the name
+	runner.check("gl_state/texture_binds", gl_counters_are(6, 4));
+
+	reset_gl_state();
+	bind_vao_buffers(1, 10, 11);
+	bind_vao_buffers(2, 12, 13);
+	bind_vao_buffers(1, 10, 11); // the element buffer is still part of vao 1
+	unbind_vao_buffers();
+	bind_vao_buffers(1, 10, 11);
+	delete_vao(2);
+	bind_vao_buffers(2, 12, 13);
+	GLS.invalidate();
+	bind_vao(1);
+	runner.check("gl_state/vao_binds", gl_counters_are(12, 4));
+
+	reset_gl_state();
+	bind_shader(3);
+	unbind_shader();
+	bind_shader(3);
+	bind_uniform_buffer_base(0, 5);
+	bind_uniform_buffer(5);
+	runner.check("gl_state/shader_binds", gl_counters_are(2, 2));
+
+	// A frame of size sprites over 3 programs, 8 VAOs and 4 textures in 2 slots, grouped the way SpriteBatch draws them.
+	int size = runner.current_size();
+	double binds = 6.0 * size; // program, VAO, array and element buffers, texture unit and texture
+	runner.measure("gl_state/frame_binds", binds, [&]() {
+		for (int i = 0; i < size; ++i)
+		{
+			bind_shader(1 + i * 3 / size);
+			bind_vao_buffers(1 + i * 8 / size, 100, 200);
+			bind_texture(1 + (i / 16) % 4, (i / 16) % 2);
+		}
+		sink = (long long)GLS.counters.elided;
+		}, &reset_gl_state);
+	reset_gl_state();
+}
+
+namespace Bench
+{
+	const std::vector<std::pair<const char*, Suite>> suites = {
+		{ "buffer", &buffer_suite },
+		{ "subbuffer_copy", &subbuffer_copy_suite },
+		{ "interpolator", &interpolator_suite },
+		{ "paint", &paint_suite },
+		{ "history", &history_suite },
+		{ "color", &color_suite },
+		{ "palette_sort", &palette_sort_suite },
+		{ "filter", &filter_suite },
+		{ "histogram", &histogram_suite },
+		{ "quantize", &quantize_suite },
+		{ "palette_lookup", &palette_lookup_suite },
+		{ "png", &png_suite },
+		{ "mips", &mips_suite },
+		{ "text", &text_suite },
+		{ "utf", &utf_suite },
+		{ "sprite_batch", &sprite_batch_suite },
+		{ "gl_state", &gl_state_suite },
+	};
+}